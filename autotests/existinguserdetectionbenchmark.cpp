@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "existinguserdetection.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * The range of regular UIDs used by the tests.
+ */
+constexpr std::pair<int, int> UID_RANGE = {1000, 60000};
+
+/**
+ * Measures detecting existing users on a system with many accounts, where the only regular user comes last,
+ * and tests querying systemd-homed.
+ */
+class ExistingUserDetectionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    /**
+     * Writes a passwd file with the given number of system users, followed by a regular user if requested.
+     */
+    static bool writePasswdFile(const QString &path, int systemUsers, bool withRegularUser)
+    {
+        QDir().mkpath(QFileInfo(path).path());
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        file.write("root:x:0:0:root:/root:/bin/bash\n");
+        for (int i = 1; i <= systemUsers; ++i) {
+            const int uid = 1 + i % (UID_RANGE.first - 1);
+            file.write(QStringLiteral("system%1:x:%2:%2:System user %1:/var/lib/system%1:/usr/sbin/nologin\n").arg(i).arg(uid).toUtf8());
+        }
+        if (withRegularUser) {
+            file.write("jdoe:x:1000:1000:Jane Doe:/home/jdoe:/bin/bash\n");
+        }
+        return file.flush();
+    }
+
+    /**
+     * Listens on the given path like systemd-homed, and answers the first request with the given replies.
+     *
+     * @return The thread serving the request, to be joined.
+     */
+    static std::thread serveHomedRecords(const QString &socketPath, const QList<QByteArray> &replies)
+    {
+        const int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        const QByteArray encodedPath = QFile::encodeName(socketPath);
+        memcpy(address.sun_path, encodedPath.constData(), encodedPath.size());
+        if (bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || listen(listenFd, 1) < 0) {
+            close(listenFd);
+            return {};
+        }
+
+        return std::thread([listenFd, replies]() {
+            const int fd = accept(listenFd, nullptr, nullptr);
+            close(listenFd);
+            char byte = 1;
+            while (byte != 0 && read(fd, &byte, 1) == 1) { }
+            for (const QByteArray &reply : replies) {
+                send(fd, reply.constData(), reply.size() + 1, MSG_NOSIGNAL);
+            }
+            close(fd);
+        });
+    }
+
+    /**
+     * Returns a reply of systemd-homed with the record of the given user.
+     */
+    static QByteArray homedRecord(const QByteArray &userName, int uid, bool continues)
+    {
+        return R"({"parameters":{"record":{"userName":")" + userName + R"(","uid":)" + QByteArray::number(uid) + R"(,"service":"io.systemd.Home"},"incomplete":false})"
+            + (continues ? R"(,"continues":true})" : "}");
+    }
+
+private Q_SLOTS:
+    void homed_data()
+    {
+        QTest::addColumn<QList<QByteArray>>("replies");
+        QTest::addColumn<bool>("found");
+
+        QTest::newRow("no users") << QList<QByteArray>{R"({"error":"io.systemd.UserDatabase.NoRecordFound","parameters":{}})"} << false;
+        QTest::newRow("system user") << QList<QByteArray>{homedRecord("daemon", 60600, false)} << false;
+        QTest::newRow("regular user last") << QList<QByteArray>{homedRecord("daemon", 60600, true), homedRecord("jdoe", 60001, true), homedRecord("jane", 1000, false)}
+                                           << true;
+        QTest::newRow("closed early") << QList<QByteArray>{homedRecord("daemon", 60600, true)} << false;
+    }
+
+    void homed()
+    {
+        QFETCH(QList<QByteArray>, replies);
+        QFETCH(bool, found);
+
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString socketPath = directory.filePath(QStringLiteral("io.systemd.Home"));
+
+        std::thread server = serveHomedRecords(socketPath, replies);
+        QVERIFY(server.joinable());
+        QCOMPARE(ExistingUserDetection::homedHasRegularUser(UID_RANGE, socketPath), found);
+        server.join();
+    }
+
+    void homedNotRunning()
+    {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        QVERIFY(!ExistingUserDetection::homedHasRegularUser(UID_RANGE, directory.filePath(QStringLiteral("io.systemd.Home"))));
+    }
+
+
+    void passwdFile_data()
+    {
+        QTest::addColumn<int>("systemUsers");
+        QTest::addColumn<bool>("withRegularUser");
+
+        QTest::newRow("50 users") << 50 << true;
+        QTest::newRow("10000 users") << 10000 << true;
+        QTest::newRow("10000 users, no regular user") << 10000 << false;
+    }
+
+    void passwdFile()
+    {
+        QFETCH(int, systemUsers);
+        QFETCH(bool, withRegularUser);
+
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString path = directory.filePath(QStringLiteral("passwd"));
+        QVERIFY(writePasswdFile(path, systemUsers, withRegularUser));
+
+        bool found = false;
+        QBENCHMARK {
+            found = ExistingUserDetection::passwdFileHasRegularUser(path, UID_RANGE);
+        }
+        QCOMPARE(found, withRegularUser);
+    }
+
+    void nss_data()
+    {
+        QTest::addColumn<int>("systemUsers");
+
+        QTest::newRow("50 users") << 50;
+        QTest::newRow("10000 users") << 10000;
+    }
+
+    void nss()
+    {
+        QFETCH(int, systemUsers);
+
+        // Set up by the build when nss_wrapper is installed, which answers from the given files
+        const QString passwdPath = qEnvironmentVariable("NSS_WRAPPER_PASSWD");
+        const QString groupPath = qEnvironmentVariable("NSS_WRAPPER_GROUP");
+        if (passwdPath.isEmpty() || groupPath.isEmpty()) {
+            QSKIP("nss_wrapper is not available");
+        }
+
+        QVERIFY(writePasswdFile(passwdPath, systemUsers, true));
+        QFile group(groupPath);
+        QVERIFY(group.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        group.write("root:x:0:\njdoe:x:1000:\n");
+        group.close();
+
+        bool found = false;
+        QBENCHMARK {
+            found = ExistingUserDetection::nssHasRegularUser(UID_RANGE);
+        }
+        QVERIFY(found);
+    }
+};
+
+QTEST_GUILESS_MAIN(ExistingUserDetectionBenchmark)
+
+#include "existinguserdetectionbenchmark.moc"
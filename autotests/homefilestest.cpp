@@ -0,0 +1,215 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "homefiles.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+
+/**
+ * Tests collecting and staging the files of the plasma-setup home directory, and measures copying them for files of various sizes.
+ */
+class HomeFilesTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    /**
+     * Writes a file of the given size filled with a repeating pattern.
+     */
+    static bool writeFile(const QString &path, qint64 size)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        QByteArray chunk(64 * 1024, Qt::Uninitialized);
+        for (qsizetype i = 0; i < chunk.size(); ++i) {
+            chunk[i] = char(i % 251);
+        }
+        for (qint64 written = 0; written < size; written += chunk.size()) {
+            if (file.write(chunk.constData(), std::min<qint64>(chunk.size(), size - written)) < 0) {
+                return false;
+            }
+        }
+        return file.flush();
+    }
+
+    static QByteArray contents(const QString &path)
+    {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_directory.isValid());
+    }
+
+    void collectHomeEntries()
+    {
+        QTemporaryDir home;
+        QTemporaryDir outside;
+        QVERIFY(home.isValid() && outside.isValid());
+
+        QVERIFY(QDir(home.path()).mkpath(QStringLiteral(".config/plasma")));
+        QVERIFY(writeFile(home.filePath(QStringLiteral(".config/kdeglobals")), 10));
+        QVERIFY(writeFile(home.filePath(QStringLiteral(".config/plasma/settings")), 10));
+        QVERIFY(writeFile(outside.filePath(QStringLiteral("secret")), 10));
+
+        // Links to the outside, as the last component of a path and in the middle of one
+        QVERIFY(QFile::link(outside.filePath(QStringLiteral("secret")), home.filePath(QStringLiteral(".config/kwinrc"))));
+        QVERIFY(QFile::link(outside.path(), home.filePath(QStringLiteral(".config/linked"))));
+        QVERIFY(QFile::link(outside.path(), home.filePath(QStringLiteral("linked"))));
+
+        const FileDescriptor homeDirectory = HomeFiles::openDirectory(home.path());
+        std::vector<HomeFiles::HomeEntry> entries;
+        QSet<QString> collectedPaths;
+        const auto collect = [&](const QString &path) {
+            HomeFiles::collectHomeEntries(homeDirectory, {path, true}, entries, collectedPaths);
+        };
+
+        collect(QStringLiteral("linked/secret"));
+        collect(QStringLiteral(".config/linked/secret"));
+        collect(QStringLiteral(".config/kwinrc"));
+        collect(QStringLiteral("missing/file"));
+        QVERIFY(entries.empty());
+
+        collect(QStringLiteral(".config"));
+        QStringList paths;
+        for (const HomeFiles::HomeEntry &entry : entries) {
+            paths << entry.relativePath;
+            QCOMPARE(entry.source.isValid(), S_ISREG(entry.sourceStat.st_mode));
+        }
+        const QStringList expectedPaths = {
+            QStringLiteral(".config"),
+            QStringLiteral(".config/kdeglobals"),
+            QStringLiteral(".config/plasma"),
+            QStringLiteral(".config/plasma/settings"),
+        };
+        QCOMPARE(paths, expectedPaths);
+
+        // Already collected along with the directory
+        collect(QStringLiteral(".config/plasma/settings"));
+        QCOMPARE(entries.size(), size_t(4));
+
+        QVERIFY_THROWS_EXCEPTION(std::runtime_error, collect(QStringLiteral("../outside")));
+        QVERIFY_THROWS_EXCEPTION(std::runtime_error, collect(QStringLiteral("/etc/shadow")));
+        QVERIFY_THROWS_EXCEPTION(std::runtime_error, HomeFiles::collectHomeEntries(homeDirectory, {QStringLiteral("missing"), false}, entries, collectedPaths));
+        QVERIFY_THROWS_EXCEPTION(std::runtime_error, HomeFiles::openDirectory(home.filePath(QStringLiteral("linked"))));
+    }
+
+    void copyToTempFile_data()
+    {
+        QTest::addColumn<qint64>("size");
+
+        QTest::newRow("empty") << qint64(0);
+        QTest::newRow("4 KiB") << qint64(4 * 1024);
+        QTest::newRow("256 KiB") << qint64(256 * 1024);
+        QTest::newRow("16 MiB") << qint64(16 * 1024 * 1024);
+    }
+
+    void copyToTempFile()
+    {
+        QFETCH(qint64, size);
+
+        const QString sourcePath = m_directory.filePath(QStringLiteral("source"));
+        QVERIFY(writeFile(sourcePath, size));
+
+        std::unique_ptr<QTemporaryFile> tempFile;
+        QBENCHMARK {
+            tempFile = HomeFiles::copyToTempFile(sourcePath);
+        }
+
+        QCOMPARE(contents(tempFile->fileName()), contents(sourcePath));
+        QCOMPARE(tempFile->permissions() & QFileDevice::ReadOther, QFileDevice::ReadOther);
+    }
+
+    void copyToFile_data()
+    {
+        copyToTempFile_data();
+    }
+
+    void copyToFile()
+    {
+        QFETCH(qint64, size);
+
+        const QString sourcePath = m_directory.filePath(QStringLiteral("source"));
+        const QString destPath = m_directory.filePath(QStringLiteral("dest"));
+        QVERIFY(writeFile(sourcePath, size));
+
+        const FileDescriptor source = HomeFiles::openSourceFile(sourcePath);
+        QBENCHMARK {
+            HomeFiles::copyToFile(source, destPath);
+        }
+
+        QCOMPARE(contents(destPath), contents(sourcePath));
+
+        struct stat sourceStat;
+        QCOMPARE(fstat(source.get(), &sourceStat), 0);
+        QVERIFY(HomeFiles::hasSameContents(source, sourceStat, destPath));
+    }
+
+    void stageEntries()
+    {
+        QTemporaryDir home;
+        QTemporaryDir newHome;
+        QVERIFY(home.isValid() && newHome.isValid());
+        QVERIFY(QDir(home.path()).mkpath(QStringLiteral(".config")));
+        QVERIFY(QDir(newHome.path()).mkpath(QStringLiteral(".config")));
+        QVERIFY(writeFile(home.filePath(QStringLiteral(".config/kdeglobals")), 10));
+        QVERIFY(writeFile(home.filePath(QStringLiteral(".config/kwinrc")), 10));
+
+        const FileDescriptor homeDirectory = HomeFiles::openDirectory(home.path());
+        const auto collect = [&homeDirectory]() {
+            std::vector<HomeFiles::HomeEntry> entries;
+            QSet<QString> collectedPaths;
+            HomeFiles::collectHomeEntries(homeDirectory, {QStringLiteral(".config"), false}, entries, collectedPaths);
+            return entries;
+        };
+
+        const QString stagingPath = m_directory.filePath(QStringLiteral("staging"));
+        {
+            const FileDescriptor stagingDirectory = HomeFiles::createStagingDirectory(stagingPath);
+            HomeFiles::stageEntries(stagingDirectory, collect());
+        }
+
+        // Changed after staging, so copied rather than moved into place
+        QVERIFY(writeFile(home.filePath(QStringLiteral(".config/kwinrc")), 20));
+
+        const FileDescriptor stagingDirectory = HomeFiles::openStagingDirectory(stagingPath);
+        QVERIFY(stagingDirectory.isValid());
+        const QSet<QString> staged = HomeFiles::stagedFiles(stagingDirectory, collect());
+        QCOMPARE(staged, QSet<QString>{QStringLiteral(".config/kdeglobals")});
+
+        const FileDescriptor newHomeDirectory = HomeFiles::openDirectory(newHome.path());
+        HomeFiles::moveStagedFile(stagingDirectory, QStringLiteral(".config/kdeglobals"), newHomeDirectory, getuid(), getgid());
+        QCOMPARE(contents(newHome.filePath(QStringLiteral(".config/kdeglobals"))), contents(home.filePath(QStringLiteral(".config/kdeglobals"))));
+        QVERIFY(!QFile::exists(stagingPath + QStringLiteral("/home/.config/kdeglobals")));
+
+        HomeFiles::removeStagingDirectory(stagingPath);
+        QVERIFY(!HomeFiles::openStagingDirectory(stagingPath).isValid());
+
+        // Others must not be able to read or replace the staged files
+        QVERIFY(QDir().mkdir(stagingPath));
+        QVERIFY(QFile::setPermissions(stagingPath, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner | QFileDevice::ReadOther | QFileDevice::ExeOther));
+        QVERIFY_THROWS_EXCEPTION(std::runtime_error, HomeFiles::openStagingDirectory(stagingPath));
+        HomeFiles::removeStagingDirectory(stagingPath);
+    }
+
+private:
+    QTemporaryDir m_directory;
+};
+
+QTEST_GUILESS_MAIN(HomeFilesTest)
+
+#include "homefilestest.moc"
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "languagesearchindex.h"
+#include "languagesortfilterproxymodel.h"
+
+#include <QLocale>
+#include <QSet>
+#include <QStringListModel>
+#include <QTest>
+
+#include <algorithm>
+
+/**
+ * Measures filtering the language list while a search is typed, over every locale Qt knows.
+ */
+class LanguageFilterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QSet<QString> codes;
+        const QList<QLocale> locales = QLocale::matchingLocales(QLocale::AnyLanguage, QLocale::AnyScript, QLocale::AnyTerritory);
+        for (const QLocale &locale : locales) {
+            const QString code = locale.name();
+            if (locale.language() == QLocale::C || codes.contains(code)) {
+                continue;
+            }
+            codes.insert(code);
+            m_languages.append({code, locale.nativeLanguageName(), QLocale::languageToString(locale.language())});
+        }
+        std::sort(m_languages.begin(), m_languages.end(), [](const LanguageEntry &left, const LanguageEntry &right) {
+            return left.code < right.code;
+        });
+
+        QStringList languageCodes;
+        for (const LanguageEntry &language : std::as_const(m_languages)) {
+            languageCodes << language.code;
+        }
+        m_languageModel.setStringList(languageCodes);
+        m_proxyModel.setSourceModel(&m_languageModel);
+
+        qInfo() << "Filtering" << m_languages.size() << "languages";
+    }
+
+    void buildIndex()
+    {
+        QBENCHMARK {
+            m_searchIndex.build(m_languages);
+        }
+        QCOMPARE(m_searchIndex.size(), m_languages.size());
+    }
+
+    void filter_data()
+    {
+        QTest::addColumn<QString>("query");
+
+        QTest::newRow("code") << QStringLiteral("pt_BR");
+        QTest::newRow("native name") << QStringLiteral("español");
+        QTest::newRow("without diacritics") << QStringLiteral("espanol");
+        QTest::newRow("english name") << QStringLiteral("Portuguese");
+        QTest::newRow("no match") << QStringLiteral("qqqq");
+    }
+
+    void filter()
+    {
+        QFETCH(QString, query);
+
+        m_searchIndex.build(m_languages);
+        m_proxyModel.setSearchIndex(&m_searchIndex);
+
+        // Every keystroke filters again, then the search is cleared
+        QBENCHMARK {
+            for (qsizetype length = 1; length <= query.size(); ++length) {
+                m_proxyModel.setFilterString(query.first(length));
+            }
+            m_proxyModel.setFilterString(QString());
+        }
+
+        m_proxyModel.setFilterString(query);
+        if (query == QLatin1String("qqqq")) {
+            QCOMPARE(m_proxyModel.rowCount(), 0);
+        } else {
+            QVERIFY(m_proxyModel.rowCount() > 0);
+        }
+        m_proxyModel.setFilterString(QString());
+        QCOMPARE(m_proxyModel.rowCount(), m_languages.size());
+    }
+
+private:
+    QList<LanguageEntry> m_languages;
+    LanguageSearchIndex m_searchIndex;
+    QStringListModel m_languageModel;
+    LanguageSortFilterProxyModel m_proxyModel;
+};
+
+QTEST_GUILESS_MAIN(LanguageFilterBenchmark)
+
+#include "languagefilterbenchmark.moc"
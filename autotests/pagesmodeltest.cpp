@@ -0,0 +1,264 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "pagesmodel.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+/**
+ * Tests and measures loading the modules of the wizard, using synthetic module packages.
+ */
+class PagesModelTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Keeps the modules installed on the system out of the test, only the synthetic ones are found.
+     */
+    static void initMain()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        qputenv("XDG_DATA_DIRS", QFile::encodeName(QDir::tempPath() + QStringLiteral("/plasma-setup-pagesmodeltest-no-data")));
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+
+private:
+    static QString packagesPath()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/plasma/packages");
+    }
+
+    /**
+     * Replaces the installed packages with the given number of synthetic modules.
+     */
+    static bool installModules(int count)
+    {
+        QDir(packagesPath()).removeRecursively();
+        QFile::remove(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/moduleindex.json"));
+
+        for (int i = 0; i < count; ++i) {
+            const QString id = QStringLiteral("org.kde.plasmasetuptest.page%1").arg(i);
+            const QString packagePath = packagesPath() + QLatin1Char('/') + id;
+            if (!QDir().mkpath(packagePath + QStringLiteral("/contents/ui"))) {
+                return false;
+            }
+
+            const QJsonObject metadata{
+                {QStringLiteral("KPlugin"),
+                 QJsonObject{
+                     {QStringLiteral("Id"), id},
+                     {QStringLiteral("Name"), QStringLiteral("Page %1").arg(i)},
+                 }},
+                {QStringLiteral("KPackageStructure"), QStringLiteral("KDE/PlasmaSetup")},
+                {QStringLiteral("X-KDE-Weight"), i},
+            };
+            QFile metadataFile(packagePath + QStringLiteral("/metadata.json"));
+            if (!metadataFile.open(QIODevice::WriteOnly) || metadataFile.write(QJsonDocument(metadata).toJson()) < 0) {
+                return false;
+            }
+
+            QFile mainFile(packagePath + QStringLiteral("/contents/ui/main.qml"));
+            if (!mainFile.open(QIODevice::WriteOnly)) {
+                return false;
+            }
+            mainFile.write(
+                "import QtQuick\n"
+                "import org.kde.plasmasetup.components as PlasmaSetupComponents\n"
+                "\n"
+                "PlasmaSetupComponents.SetupModule {\n"
+                "    unloadable: true\n"
+                "    contentItem: Item {\n"
+                "        Repeater {\n"
+                "            model: 20\n"
+                "            Rectangle { width: 10; height: 10 }\n"
+                "        }\n"
+                "    }\n"
+                "}\n");
+        }
+        return true;
+    }
+
+    /**
+     * Creates a pages model living in the given engine.
+     */
+    static std::unique_ptr<PagesModel> createModel(QQmlEngine &engine)
+    {
+        auto model = std::make_unique<PagesModel>();
+        QQmlEngine::setContextForObject(model.get(), engine.rootContext());
+        return model;
+    }
+
+    /**
+     * Processes the deletion of the released modules.
+     */
+    static void deleteReleasedModules()
+    {
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+private Q_SLOTS:
+    void cleanupTestCase()
+    {
+        QDir(packagesPath()).removeRecursively();
+    }
+
+    void reload_data()
+    {
+        QTest::addColumn<int>("moduleCount");
+
+        QTest::newRow("10 modules") << 10;
+        QTest::newRow("100 modules") << 100;
+    }
+
+    void reload()
+    {
+        QFETCH(int, moduleCount);
+        QVERIFY(installModules(moduleCount));
+
+        QQmlEngine engine;
+        const auto model = createModel(engine);
+        QSignalSpy loadedSpy(model.get(), &PagesModel::loaded);
+
+        QBENCHMARK {
+            model->reload();
+            deleteReleasedModules();
+        }
+
+        QVERIFY(loadedSpy.count() > 0);
+        QCOMPARE(model->rowCount(), moduleCount);
+        QCOMPARE(model->componentCompilations(), moduleCount);
+        QCOMPARE(model->pluginId(0), QStringLiteral("org.kde.plasmasetuptest.page0"));
+    }
+
+    void lazyReload()
+    {
+        QVERIFY(installModules(100));
+
+        QQmlEngine engine;
+        const auto model = createModel(engine);
+        model->setLazyLoading(true);
+
+        QBENCHMARK {
+            model->reload();
+            deleteReleasedModules();
+        }
+
+        QCOMPARE(model->rowCount(), 100);
+        QVERIFY(model->isPageLoaded(1));
+        QVERIFY(model->isPageLoaded(2));
+    }
+
+    void lazyLoadingCreatesOnce()
+    {
+        QVERIFY(installModules(10));
+
+        QQmlEngine engine;
+        const auto model = createModel(engine);
+        model->setLazyLoading(true);
+        model->reload();
+        QCOMPARE(model->moduleCreations(), 10);
+
+        // Going through the wizard hands out the instances reload() created to check the availability
+        for (int row = 0; row < model->rowCount(); ++row) {
+            QVERIFY(model->pageItem(row));
+            model->preparePage(row + 1);
+        }
+        QCOMPARE(model->moduleCreations(), 10);
+    }
+
+    void preparePage()
+    {
+        QVERIFY(installModules(10));
+
+        QQmlEngine engine;
+        const auto model = createModel(engine);
+        model->setLazyLoading(true);
+        model->reload();
+        model->releasePage(2);
+        deleteReleasedModules();
+        QSignalSpy readySpy(model.get(), &PagesModel::pageReady);
+
+        model->preparePage(2);
+        QTRY_COMPARE(readySpy.count(), 1);
+        QCOMPARE(readySpy.first().first().toInt(), 2);
+        QVERIFY(model->isPageLoaded(2));
+        QVERIFY(model->pageItem(2));
+    }
+
+    void pageItemDuringPreparation()
+    {
+        QVERIFY(installModules(10));
+
+        QQmlEngine engine;
+        const auto model = createModel(engine);
+        model->setLazyLoading(true);
+        model->reload();
+        model->releasePage(2);
+        deleteReleasedModules();
+        const int compilations = model->componentCompilations();
+        QSignalSpy readySpy(model.get(), &PagesModel::pageReady);
+
+        // The module being created in the background is handed out, not created a second time
+        model->preparePage(2);
+        SetupModule *module = model->pageItem(2);
+        QVERIFY(module);
+        QVERIFY(model->isPageLoaded(2));
+
+        QTest::qWait(100);
+        QCOMPARE(readySpy.count(), 0);
+        QCOMPARE(model->pageItem(2), module);
+        QCOMPARE(model->componentCompilations(), compilations);
+
+        // Preparing again right after releasing starts over with a new instance
+        model->releasePage(2);
+        deleteReleasedModules();
+        model->preparePage(2);
+        QTRY_COMPARE(readySpy.count(), 1);
+        QVERIFY(model->pageItem(2));
+    }
+
+    void releasedPageDeleted()
+    {
+        QVERIFY(installModules(10));
+
+        QQmlEngine engine;
+        const auto model = createModel(engine);
+        model->setLazyLoading(true);
+        model->reload();
+        const int compilations = model->componentCompilations();
+        const int creations = model->moduleCreations();
+
+        // A released page is deleted, and creating it again reuses the compiled component
+        constexpr int cycles = 20;
+        for (int cycle = 0; cycle < cycles; ++cycle) {
+            const QPointer<SetupModule> page = model->pageItem(2);
+            QVERIFY(page);
+
+            model->releasePage(2);
+            deleteReleasedModules();
+            QVERIFY(!page);
+            QVERIFY(!model->isPageLoaded(2));
+        }
+
+        QCOMPARE(model->componentCompilations(), compilations);
+        // The first cycle releases the page created by reload()
+        QCOMPARE(model->moduleCreations(), creations + cycles - 1);
+    }
+};
+
+QTEST_MAIN(PagesModelTest)
+
+#include "pagesmodeltest.moc"
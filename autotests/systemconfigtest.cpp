@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "systemconfig.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+/**
+ * Tests reading the system configuration, and measures parsing login.defs.
+ */
+class SystemConfigTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    /**
+     * Returns a login.defs shaped like the ones of distributions, mostly comments, with the
+     * given number of settings before the UID range.
+     */
+    static QByteArray loginDefs(int settings)
+    {
+        QByteArray data;
+        for (int i = 0; i < settings; ++i) {
+            data += "#\n# Setting " + QByteArray::number(i) + " controls something unrelated to the users,\n# see login.defs(5).\n#\n";
+            data += "SETTING_" + QByteArray::number(i) + "\t\tvalue" + QByteArray::number(i) + "\n\n";
+        }
+        data += "#\n# Min/max values for automatic uid selection in useradd\n#\n";
+        data += "UID_MIN\t\t\t 1500\n";
+        data += "UID_MAX\t\t\t60000\n";
+        data += "#SYS_UID_MIN\t\t  100\n";
+        return data;
+    }
+
+private Q_SLOTS:
+    void parseLoginDefs_data()
+    {
+        QTest::addColumn<QByteArray>("data");
+        QTest::addColumn<int>("uidMin");
+        QTest::addColumn<int>("uidMax");
+
+        QTest::newRow("empty") << QByteArray() << DEFAULT_MIN_REGULAR_USER_ID << DEFAULT_MAX_REGULAR_USER_ID;
+        QTest::newRow("indented") << QByteArray("  UID_MIN 2000\n\tUID_MAX\t3000") << 2000 << 3000;
+        QTest::newRow("commented out") << QByteArray("#UID_MIN 2000\n# UID_MAX 3000\n") << DEFAULT_MIN_REGULAR_USER_ID << DEFAULT_MAX_REGULAR_USER_ID;
+        QTest::newRow("invalid") << QByteArray("UID_MIN -5\nUID_MAX lots\n") << DEFAULT_MIN_REGULAR_USER_ID << DEFAULT_MAX_REGULAR_USER_ID;
+        QTest::newRow("similar keys") << QByteArray("UID_MINIMUM 2000\nSYS_UID_MAX 999\n") << DEFAULT_MIN_REGULAR_USER_ID << DEFAULT_MAX_REGULAR_USER_ID;
+        QTest::newRow("distribution") << loginDefs(60) << 1500 << 60000;
+    }
+
+    void parseLoginDefs()
+    {
+        QFETCH(QByteArray, data);
+        QFETCH(int, uidMin);
+        QFETCH(int, uidMax);
+
+        const LoginDefs parsed = ::parseLoginDefs(data);
+        QCOMPARE(parsed.uidMin, uidMin);
+        QCOMPARE(parsed.uidMax, uidMax);
+    }
+
+    void benchmarkParseLoginDefs_data()
+    {
+        QTest::addColumn<int>("settings");
+
+        QTest::newRow("distribution") << 60;
+        QTest::newRow("large") << 5000;
+    }
+
+    void benchmarkParseLoginDefs()
+    {
+        QFETCH(int, settings);
+        const QByteArray data = loginDefs(settings);
+
+        LoginDefs parsed;
+        QBENCHMARK {
+            parsed = ::parseLoginDefs(data);
+        }
+        QCOMPARE(parsed.uidMin, 1500);
+    }
+
+    void benchmarkLoad()
+    {
+        // Reading the file included, as done by the application and the helper on first use
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const QString path = directory.filePath(QStringLiteral("login.defs"));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(loginDefs(60));
+        file.close();
+
+        std::pair<int, int> uidRange;
+        QBENCHMARK {
+            uidRange = SystemConfig::load(path, QString()).uidRange();
+        }
+        QCOMPARE(uidRange, std::make_pair(1500, 60000));
+    }
+
+    void defaultUserBackend()
+    {
+        QTemporaryDir directory;
+        QVERIFY(directory.isValid());
+        const SystemConfig config = SystemConfig::load(directory.filePath(QStringLiteral("login.defs")), QString());
+        QVERIFY(config.userBackend() == SystemConfig::UserBackend::Subprocess);
+    }
+
+    void helperIgnoresCallerConfiguration()
+    {
+        const SystemConfig &ownConfig = SystemConfig::instance();
+
+        QVariantMap args = ownConfig.helperArguments();
+        args.insert(QStringLiteral("uidMin"), 0);
+        args.insert(QStringLiteral("uidMax"), 0);
+        args.insert(QStringLiteral("newUserHomePaths"), QStringList{QStringLiteral(".ssh")});
+        const bool usesUseradd = ownConfig.userBackend() == SystemConfig::UserBackend::Subprocess;
+        args.insert(QStringLiteral("userBackend"), usesUseradd ? QStringLiteral("accountsservice") : QStringLiteral("useradd"));
+
+        const SystemConfig helperConfig = SystemConfig::fromHelperArguments(args);
+        QCOMPARE(helperConfig.uidRange(), ownConfig.uidRange());
+        QCOMPARE(helperConfig.newUserHomePaths(), ownConfig.newUserHomePaths());
+        QVERIFY(helperConfig.userBackend() == ownConfig.userBackend());
+    }
+};
+
+QTEST_GUILESS_MAIN(SystemConfigTest)
+
+#include "systemconfigtest.moc"
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "systemsettingscommitter.h"
+
+#include <QDBusConnection>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <array>
+#include <memory>
+
+/**
+ * Stands in for systemd-localed.
+ */
+class MockLocale1 : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.locale1")
+
+public Q_SLOTS:
+    void SetLocale(const QStringList &locale, bool interactive)
+    {
+        Q_UNUSED(interactive)
+        m_locale = locale;
+    }
+
+public:
+    QStringList m_locale;
+};
+
+/**
+ * Stands in for systemd-timedated.
+ */
+class MockTimedate1 : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.timedate1")
+
+public Q_SLOTS:
+    void SetTimezone(const QString &timezone, bool interactive)
+    {
+        Q_UNUSED(interactive)
+        m_timezone = timezone;
+    }
+
+public:
+    QString m_timezone;
+};
+
+/**
+ * Stands in for systemd-hostnamed.
+ */
+class MockHostname1 : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.hostname1")
+
+public Q_SLOTS:
+    void SetStaticHostname(const QString &hostname, bool interactive)
+    {
+        Q_UNUSED(interactive)
+        m_hostname = hostname;
+    }
+
+public:
+    QString m_hostname;
+};
+
+/**
+ * Measures writing the settings of the wizard to mock system services on the session bus.
+ *
+ * The mock services run on a connection of their own, so every call makes the full round trip over the bus.
+ */
+class SystemSettingsCommitterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QDBusMessage call(const QString &service, const QString &method, const QVariantList &arguments)
+    {
+        const QString path = QLatin1Char('/') + QString(service).replace(QLatin1Char('.'), QLatin1Char('/'));
+        QDBusMessage message = QDBusMessage::createMethodCall(service, path, service, method);
+        message.setArguments(arguments);
+        return message;
+    }
+
+    /**
+     * Stages new values for the given settings, "locale", "timezone" and "hostname".
+     */
+    void stage(SystemSettingsCommitter &committer, const QStringList &settings)
+    {
+        ++m_writes;
+        const QString suffix = QString::number(m_writes);
+        if (settings.contains(QLatin1String("locale"))) {
+            const QStringList locale = {QStringLiteral("LANG=de_DE.UTF-8"), QStringLiteral("LC_MESSAGES=C.") + suffix};
+            committer.stage(QStringLiteral("locale"), locale, call(QStringLiteral("org.freedesktop.locale1"), QStringLiteral("SetLocale"), {locale, false}));
+        }
+        if (settings.contains(QLatin1String("timezone"))) {
+            const QString timezone = m_writes % 2 ? QStringLiteral("Europe/Berlin") : QStringLiteral("Europe/Paris");
+            committer.stage(QStringLiteral("timezone"), timezone, call(QStringLiteral("org.freedesktop.timedate1"), QStringLiteral("SetTimezone"), {timezone, false}));
+        }
+        if (settings.contains(QLatin1String("hostname"))) {
+            const QString hostname = QStringLiteral("workstation-") + suffix;
+            committer.stage(QStringLiteral("hostname"),
+                            hostname,
+                            call(QStringLiteral("org.freedesktop.hostname1"), QStringLiteral("SetStaticHostname"), {hostname, false}));
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        if (!QDBusConnection::sessionBus().isConnected()) {
+            QSKIP("No session bus to run the mock services on");
+        }
+
+        m_serviceConnection = std::make_unique<QDBusConnection>(QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("mockservices")));
+        QVERIFY(m_serviceConnection->isConnected());
+
+        const std::array<std::pair<QString, QObject *>, 3> services = {{
+            {QStringLiteral("org.freedesktop.locale1"), &m_locale1},
+            {QStringLiteral("org.freedesktop.timedate1"), &m_timedate1},
+            {QStringLiteral("org.freedesktop.hostname1"), &m_hostname1},
+        }};
+        for (const auto &[service, object] : services) {
+            const QString path = QLatin1Char('/') + QString(service).replace(QLatin1Char('.'), QLatin1Char('/'));
+            QVERIFY(m_serviceConnection->registerObject(path, object, QDBusConnection::ExportAllSlots));
+            if (!m_serviceConnection->registerService(service)) {
+                QSKIP("Unable to register the mock services on the session bus");
+            }
+        }
+    }
+
+    void cleanupTestCase()
+    {
+        if (m_serviceConnection) {
+            QDBusConnection::disconnectFromBus(m_serviceConnection->name());
+        }
+    }
+
+    void commit_data()
+    {
+        QTest::addColumn<QStringList>("settings");
+
+        QTest::newRow("locale") << QStringList{QStringLiteral("locale")};
+        QTest::newRow("all") << QStringList{QStringLiteral("locale"), QStringLiteral("timezone"), QStringLiteral("hostname")};
+    }
+
+    void commit()
+    {
+        QFETCH(QStringList, settings);
+
+        SystemSettingsCommitter committer(QDBusConnection::sessionBus());
+        QSignalSpy allCommittedSpy(&committer, &SystemSettingsCommitter::allCommitted);
+
+        QBENCHMARK {
+            stage(committer, settings);
+            committer.commit();
+            QVERIFY(allCommittedSpy.wait());
+        }
+
+        QVERIFY(allCommittedSpy.last().at(0).toStringList().isEmpty());
+        QVERIFY(m_locale1.m_locale.contains(QStringLiteral("LC_MESSAGES=C.") + QString::number(m_writes)));
+        if (settings.contains(QLatin1String("hostname"))) {
+            QCOMPARE(m_hostname1.m_hostname, QStringLiteral("workstation-") + QString::number(m_writes));
+        }
+    }
+
+    void commitOneByOne()
+    {
+        // For comparison, waiting for each reply before sending the next call
+        SystemSettingsCommitter committer(QDBusConnection::sessionBus());
+        QSignalSpy allCommittedSpy(&committer, &SystemSettingsCommitter::allCommitted);
+
+        const QStringList settings = {QStringLiteral("locale"), QStringLiteral("timezone"), QStringLiteral("hostname")};
+        QBENCHMARK {
+            for (const QString &setting : settings) {
+                stage(committer, {setting});
+                committer.commit();
+                QVERIFY(allCommittedSpy.wait());
+            }
+        }
+
+        QVERIFY(allCommittedSpy.last().at(0).toStringList().isEmpty());
+    }
+
+private:
+    MockLocale1 m_locale1;
+    MockTimedate1 m_timedate1;
+    MockHostname1 m_hostname1;
+    std::unique_ptr<QDBusConnection> m_serviceConnection;
+
+    /** The number of times the settings were staged, so every write has a new value. */
+    int m_writes = 0;
+};
+
+QTEST_GUILESS_MAIN(SystemSettingsCommitterBenchmark)
+
+#include "systemsettingscommitterbenchmark.moc"
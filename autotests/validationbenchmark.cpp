@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "hostnamevalidator.h"
+#include "usernamevalidator.h"
+
+#include <QRegularExpression>
+#include <QTest>
+
+#include <algorithm>
+#include <utility>
+
+using namespace PlasmaSetupValidation;
+
+/**
+ * Measures the validators run on every keystroke of the account and hostname pages, against the
+ * regular expressions they replaced.
+ */
+class ValidationBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    /**
+     * Returns every prefix of the given text, as validated while it is typed.
+     */
+    static QStringList typed(const QString &text)
+    {
+        QStringList prefixes;
+        for (qsizetype length = 1; length <= text.size(); ++length) {
+            prefixes << text.first(length);
+        }
+        return prefixes;
+    }
+
+    /**
+     * The username validation as done with a regular expression before.
+     */
+    static Account::UsernameValidationResult regexValidateUsername(const QString &username)
+    {
+        static const QRegularExpression usernamePattern(QStringLiteral("^[A-Za-z_][A-Za-z0-9_.-]*$"));
+
+        const QString trimmed = username.trimmed();
+        if (trimmed.isEmpty()) {
+            return Account::UsernameValidationResult::Empty;
+        }
+        if (trimmed.size() > Account::MAX_USERNAME_LENGTH) {
+            return Account::UsernameValidationResult::TooLong;
+        }
+        if (!usernamePattern.match(trimmed).hasMatch()) {
+            return Account::UsernameValidationResult::InvalidCharacters;
+        }
+        return Account::UsernameValidationResult::Valid;
+    }
+
+    /**
+     * The hostname validation as done with a regular expression per label before.
+     */
+    static Hostname::HostnameValidationResult regexValidateHostname(const QString &hostname)
+    {
+        static const QRegularExpression labelPattern(QStringLiteral("^[A-Za-z0-9](?:[A-Za-z0-9-]*[A-Za-z0-9])?$"));
+
+        const QString trimmed = hostname.trimmed();
+        if (trimmed.isEmpty()) {
+            return Hostname::HostnameValidationResult::Empty;
+        }
+        for (const QLatin1StringView disallowed : Hostname::DISALLOWED_HOSTNAMES) {
+            if (trimmed.compare(disallowed, Qt::CaseInsensitive) == 0) {
+                return Hostname::HostnameValidationResult::Disallowed;
+            }
+        }
+        if (trimmed.size() > Hostname::MAX_HOSTNAME_LENGTH) {
+            return Hostname::HostnameValidationResult::TooLong;
+        }
+        if (trimmed.startsWith(u'.')) {
+            return Hostname::HostnameValidationResult::LeadingDot;
+        }
+        if (trimmed.endsWith(u'.')) {
+            return Hostname::HostnameValidationResult::TrailingDot;
+        }
+        if (trimmed.contains(QStringLiteral(".."))) {
+            return Hostname::HostnameValidationResult::ConsecutiveDots;
+        }
+
+        const QStringList labels = trimmed.split(u'.');
+        for (const QString &label : labels) {
+            if (label.isEmpty()) {
+                return Hostname::HostnameValidationResult::EmptyLabel;
+            }
+            if (label.size() > Hostname::MAX_LABEL_LENGTH) {
+                return Hostname::HostnameValidationResult::LabelTooLong;
+            }
+            if (!labelPattern.match(label).hasMatch()) {
+                return Hostname::HostnameValidationResult::InvalidCharacters;
+            }
+        }
+        return Hostname::HostnameValidationResult::Valid;
+    }
+
+private Q_SLOTS:
+    void validateUsername_data()
+    {
+        QTest::addColumn<QStringList>("usernames");
+        QTest::addColumn<bool>("regex");
+
+        const QList<std::pair<const char *, QStringList>> rows = {
+            {"typed", typed(QStringLiteral("jane.doe-admin_01"))},
+            {"invalid", {QStringLiteral("1jane"), QStringLiteral("jane doe"), QStringLiteral("jané"), QStringLiteral("-jane")}},
+            {"too long", {QString(Account::MAX_USERNAME_LENGTH + 1, QLatin1Char('a'))}},
+        };
+        for (const auto &[name, usernames] : rows) {
+            QTest::addRow("%s, character classes", name) << usernames << false;
+            QTest::addRow("%s, regular expression", name) << usernames << true;
+        }
+    }
+
+    void validateUsername()
+    {
+        QFETCH(QStringList, usernames);
+        QFETCH(bool, regex);
+
+        QVERIFY(Account::validateUsername(u"jane.doe-admin_01") == Account::UsernameValidationResult::Valid);
+        QVERIFY(Account::validateUsername(u"jane doe") == Account::UsernameValidationResult::InvalidCharacters);
+        for (const QString &username : std::as_const(usernames)) {
+            QVERIFY(Account::validateUsername(username) == regexValidateUsername(username));
+        }
+
+        // The valid usernames as counted with the regular expressions, each iteration of the
+        // benchmark has to count the same
+        const auto expectedValid = std::ranges::count_if(usernames, [](const QString &username) {
+            return regexValidateUsername(username) == Account::UsernameValidationResult::Valid;
+        });
+
+        qsizetype valid = 0;
+        qsizetype iterations = 0;
+        if (regex) {
+            QBENCHMARK {
+                ++iterations;
+                for (const QString &username : std::as_const(usernames)) {
+                    valid += regexValidateUsername(username) == Account::UsernameValidationResult::Valid;
+                }
+            }
+        } else {
+            QBENCHMARK {
+                ++iterations;
+                for (const QString &username : std::as_const(usernames)) {
+                    valid += Account::validateUsername(username) == Account::UsernameValidationResult::Valid;
+                }
+            }
+        }
+        QCOMPARE(valid, expectedValid * iterations);
+    }
+
+    void validateHostname_data()
+    {
+        QTest::addColumn<QStringList>("hostnames");
+        QTest::addColumn<bool>("regex");
+
+        const QList<std::pair<const char *, QStringList>> rows = {
+            {"typed", typed(QStringLiteral("workstation-042.office.example.org"))},
+            {"invalid", {QStringLiteral("-host"), QStringLiteral("host..example"), QStringLiteral("host_name"), QStringLiteral("localhost")}},
+            {"longest", {QStringList(4, QString(Hostname::MAX_LABEL_LENGTH - 1, QLatin1Char('a'))).join(QLatin1Char('.'))}},
+        };
+        for (const auto &[name, hostnames] : rows) {
+            QTest::addRow("%s, character classes", name) << hostnames << false;
+            QTest::addRow("%s, regular expression", name) << hostnames << true;
+        }
+    }
+
+    void validateHostname()
+    {
+        QFETCH(QStringList, hostnames);
+        QFETCH(bool, regex);
+
+        QVERIFY(Hostname::validateHostname(u"workstation-042.office.example.org") == Hostname::HostnameValidationResult::Valid);
+        QVERIFY(Hostname::validateHostname(u"host..example") == Hostname::HostnameValidationResult::ConsecutiveDots);
+        for (const QString &hostname : std::as_const(hostnames)) {
+            QVERIFY(Hostname::validateHostname(hostname) == regexValidateHostname(hostname));
+        }
+
+        // The valid hostnames as counted with the regular expressions, each iteration of the
+        // benchmark has to count the same
+        const auto expectedValid = std::ranges::count_if(hostnames, [](const QString &hostname) {
+            return regexValidateHostname(hostname) == Hostname::HostnameValidationResult::Valid;
+        });
+
+        qsizetype valid = 0;
+        qsizetype iterations = 0;
+        if (regex) {
+            QBENCHMARK {
+                ++iterations;
+                for (const QString &hostname : std::as_const(hostnames)) {
+                    valid += regexValidateHostname(hostname) == Hostname::HostnameValidationResult::Valid;
+                }
+            }
+        } else {
+            QBENCHMARK {
+                ++iterations;
+                for (const QString &hostname : std::as_const(hostnames)) {
+                    valid += Hostname::validateHostname(hostname) == Hostname::HostnameValidationResult::Valid;
+                }
+            }
+        }
+        QCOMPARE(valid, expectedValid * iterations);
+    }
+};
+
+QTEST_GUILESS_MAIN(ValidationBenchmark)
+
+#include "validationbenchmark.moc"
@@ -1,4 +1,6 @@
 #define PLASMA_SETUP_LIBEXECDIR "${KDE_INSTALL_FULL_LIBEXECDIR}"
 #define PLASMA_SETUP_DONE_FLAG_PATH "${KDE_INSTALL_FULL_SYSCONFDIR}/plasma-setup-done"
+#define PLASMA_SETUP_CACHE_DIR "${KDE_INSTALL_FULL_LOCALSTATEDIR}/cache/plasma-setup" // Caches kept across boots, see CacheDirectory
 #define PLASMA_SETUP_CONFIG_PATH "${KDE_INSTALL_FULL_CONFDIR}/plasmasetuprc" // The path to the plasma setup configuration file
 #define LOGIN_DEFS_PATH "${LOGIN_DEFS_PATH}" // Build-time configurable location of login.defs
+#cmakedefine01 PLASMA_SETUP_ACCOUNTSSERVICE // Whether users can be created through AccountsService
@@ -17,21 +17,30 @@ import org.kde.plasmasetup.components as PlasmaSetupComponents
 PlasmaSetupComponents.SetupModule {
     id: root
 
-    available: !AccountController.hasExistingUsers
+    // Stays available once shown, the user entered here is created even if existing users are found meanwhile
+    available: AccountController.createsUser
+    availabilityPending: AccountController.detectingExistingUsers
 
     /*!
     Whether the entered username is valid.
     */
-    property bool usernameValid: AccountController.isUsernameValid(usernameField.text)
+    property bool usernameValid: {
+        AccountController.takenNamesLoaded; // Validate again once the existing names are known
+        return AccountController.isUsernameValid(usernameField.text);
+    }
 
     /*!
     Message describing why the username is invalid, or empty if valid.
     */
-    property string usernameValidationMessage: AccountController.usernameValidationMessage(usernameField.text)
+    property string usernameValidationMessage: {
+        AccountController.takenNamesLoaded;
+        return AccountController.usernameValidationMessage(usernameField.text);
+    }
 
     nextEnabled: root.usernameValid && passwordField.text.length > 0 && repeatField.text === passwordField.text
 
     function onPageActivated() {
+        AccountController.keepUserCreation();
         fullNameField.forceActiveFocus();
     }
 
@@ -100,6 +109,14 @@ PlasmaSetupComponents.SetupModule {
                     Layout.bottomMargin: Kirigami.Units.gridUnit
                 }
 
+                Kirigami.InlineMessage {
+                    Layout.fillWidth: true
+                    Layout.bottomMargin: Kirigami.Units.gridUnit
+                    type: Kirigami.MessageType.Information
+                    text: i18n("Other user accounts were found on this system. The account entered here will still be created.")
+                    visible: AccountController.hasExistingUsers
+                }
+
                 Kirigami.FormLayout {
                     TextField {
                         id: fullNameField
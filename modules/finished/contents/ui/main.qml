@@ -35,6 +35,15 @@ PlasmaSetupComponents.SetupModule {
         InitialStartUtil.distroName
     )
 
+    Connections {
+        target: InitialStartUtil
+
+        // Let the user try again, only the steps that failed are run again
+        function onFinishFailed(): void {
+            root.nextEnabled = true;
+        }
+    }
+
     contentItem: ColumnLayout {
         id: mainColumn
 
@@ -45,18 +54,60 @@ PlasmaSetupComponents.SetupModule {
                 id: finishedMessage
                 Layout.fillWidth: true
                 Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
-                text: AccountController.hasExistingUsers
+                text: !AccountController.createsUser
                         ? root.existingUserFinishedMessage
                         : root.newUserFinishedMessage
                 wrapMode: Text.Wrap
                 horizontalAlignment: Text.AlignHCenter
             }
 
+            Kirigami.InlineMessage {
+                id: finishErrorMessage
+                Layout.fillWidth: true
+                Layout.topMargin: Kirigami.Units.gridUnit
+                visible: InitialStartUtil.finishError.length > 0
+                type: Kirigami.MessageType.Error
+                text: i18n("Setup could not be completed:<br />%1", InitialStartUtil.finishError)
+            }
+
+            Kirigami.InlineMessage {
+                id: preparationErrorMessage
+                Layout.fillWidth: true
+                Layout.topMargin: Kirigami.Units.gridUnit
+                visible: InitialStartUtil.preparationError.length > 0 && !finishErrorMessage.visible && !InitialStartUtil.finishing
+                type: Kirigami.MessageType.Warning
+                text: i18n("Setup may not be able to complete, consider going back to change your choices:<br />%1", InitialStartUtil.preparationError)
+            }
+
+            ColumnLayout {
+                id: finishProgressColumn
+                Layout.fillWidth: true
+                Layout.topMargin: Kirigami.Units.gridUnit
+                visible: InitialStartUtil.finishing
+
+                Label {
+                    Layout.fillWidth: true
+                    text: InitialStartUtil.finishStatus
+                    wrapMode: Text.Wrap
+                    horizontalAlignment: Text.AlignHCenter
+                }
+
+                ProgressBar {
+                    Layout.fillWidth: true
+                    from: 0
+                    to: 1
+                    value: InitialStartUtil.finishProgress
+                }
+            }
+
             Image {
                 Layout.fillWidth: true
                 Layout.alignment: Qt.AlignHCenter
                 Layout.topMargin: Kirigami.Units.gridUnit
                 Layout.maximumHeight: mainColumn.height - finishedMessage.height - Kirigami.Units.gridUnit
+                                      - (finishErrorMessage.visible ? finishErrorMessage.height + Kirigami.Units.gridUnit : 0)
+                                      - (preparationErrorMessage.visible ? preparationErrorMessage.height + Kirigami.Units.gridUnit : 0)
+                                      - (finishProgressColumn.visible ? finishProgressColumn.height + Kirigami.Units.gridUnit : 0)
                 fillMode: Image.PreserveAspectFit
                 source: "konqi-calling.png"
             }
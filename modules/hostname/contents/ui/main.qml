@@ -21,7 +21,9 @@ import org.kde.plasmasetup.hostnameutil
 PlasmaSetupComponents.SetupModule {
     id: root
 
-    available: HostnameUtil.hostnameIsDefault()
+    // The hostnames are read asynchronously, the page is only needed if the system still has the default one
+    availabilityPending: !HostnameUtil.loaded
+    available: HostnameUtil.loaded && HostnameUtil.hostnameIsDefault()
 
     /**
     * Whether the user has modified the field.
@@ -56,6 +58,12 @@ PlasmaSetupComponents.SetupModule {
         hostnameField.forceActiveFocus();
     }
 
+    function onPageDeactivated(): void {
+        // Leaving the page does not always finish editing the field
+        HostnameUtil.hostname = hostnameField.text;
+        HostnameUtil.commitSystemSettings();
+    }
+
     /**
     * Update the validation properties based on the current hostname field text.
     */
@@ -6,112 +6,11 @@
 
 #include "plasmasetup_hostnameutil_debug.h"
 
-#include <KLocalizedString>
-
 namespace
 {
-enum class HostnameValidationResult {
-    Valid,
-    Empty,
-    Disallowed,
-    TooLong,
-    LeadingDot,
-    TrailingDot,
-    ConsecutiveDots,
-    EmptyLabel,
-    LabelTooLong,
-    InvalidCharacters,
-};
-
-const QRegularExpression VALID_HOSTNAME_REGEX(QStringLiteral("^[A-Za-z0-9](?:[A-Za-z0-9-]*[A-Za-z0-9])?$"));
-constexpr int MAX_HOSTNAME_LENGTH = 253;
-constexpr int MAX_LABEL_LENGTH = 63;
-const QList<QString> DISALLOWED_HOSTNAMES = {QStringLiteral("localhost"), QStringLiteral("localhost.localdomain")};
-
-bool isDisallowedHostname(const QString &hostname)
-{
-    const QString trimmed = hostname.trimmed();
-    for (const QString &disallowed : DISALLOWED_HOSTNAMES) {
-        if (trimmed.compare(disallowed, Qt::CaseInsensitive) == 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-HostnameValidationResult validateHostname(const QString &hostname)
-{
-    const QString trimmed = hostname.trimmed();
-
-    if (trimmed.isEmpty()) {
-        return HostnameValidationResult::Empty;
-    }
-
-    if (isDisallowedHostname(trimmed)) {
-        return HostnameValidationResult::Disallowed;
-    }
-
-    if (trimmed.size() > MAX_HOSTNAME_LENGTH) {
-        return HostnameValidationResult::TooLong;
-    }
-
-    if (trimmed.startsWith(u'.')) {
-        return HostnameValidationResult::LeadingDot;
-    }
-
-    if (trimmed.endsWith(u'.')) {
-        return HostnameValidationResult::TrailingDot;
-    }
-
-    if (trimmed.contains(QStringLiteral(".."))) {
-        return HostnameValidationResult::ConsecutiveDots;
-    }
-
-    const auto labels = trimmed.split(u'.');
-    for (const QString &label : labels) {
-        if (label.isEmpty()) {
-            return HostnameValidationResult::EmptyLabel;
-        }
-
-        if (label.size() > MAX_LABEL_LENGTH) {
-            return HostnameValidationResult::LabelTooLong;
-        }
-
-        if (!VALID_HOSTNAME_REGEX.match(label).hasMatch()) {
-            return HostnameValidationResult::InvalidCharacters;
-        }
-    }
-
-    return HostnameValidationResult::Valid;
-}
-
-QString hostnameValidationMessageForResult(HostnameValidationResult result)
-{
-    switch (result) {
-    case HostnameValidationResult::Valid:
-        return QString();
-    case HostnameValidationResult::Empty:
-        return i18nc("@info", "Hostname cannot be empty.");
-    case HostnameValidationResult::Disallowed:
-        return i18nc("@info", "Hostname cannot be “localhost” or “localhost.localdomain”.");
-    case HostnameValidationResult::TooLong:
-        return i18nc("@info", "Hostname is too long (maximum 253 characters).");
-    case HostnameValidationResult::LeadingDot:
-        return i18nc("@info", "Hostname cannot start with a dot.");
-    case HostnameValidationResult::TrailingDot:
-        return i18nc("@info", "Hostname cannot end with a dot.");
-    case HostnameValidationResult::ConsecutiveDots:
-        return i18nc("@info", "Hostname cannot contain consecutive dots.");
-    case HostnameValidationResult::EmptyLabel:
-        return i18nc("@info", "Hostname labels cannot be empty.");
-    case HostnameValidationResult::LabelTooLong:
-        return i18nc("@info", "Each hostname label must be at most 63 characters.");
-    case HostnameValidationResult::InvalidCharacters:
-        return i18nc("@info", "Hostnames may contain letters, numbers, and hyphens. Each label must start and end with a letter or number.");
-    }
-
-    return QString();
-}
+/** The keys of the hostnames in the committed system settings. */
+const QString STATIC_HOSTNAME_SETTING = QStringLiteral("staticHostname");
+const QString TRANSIENT_HOSTNAME_SETTING = QStringLiteral("hostname");
 } // namespace
 
 HostnameUtil::HostnameUtil(QObject *parent)
@@ -120,8 +19,25 @@ HostnameUtil::HostnameUtil(QObject *parent)
                                                            QStringLiteral("/org/freedesktop/hostname1"),
                                                            QDBusConnection::systemBus(),
                                                            this))
+    , m_hostname1(m_dbusInterface->service(), m_dbusInterface->path(), m_dbusInterface->interface(), QDBusConnection::systemBus())
+    , m_systemSettings(QDBusConnection::systemBus())
 {
-    loadHostname();
+    connect(&m_systemSettings, &SystemSettingsCommitter::committed, this, [](const QString &key, const QString &errorMessage) {
+        const QString kind = key == STATIC_HOSTNAME_SETTING ? QStringLiteral("static") : QStringLiteral("transient");
+        if (!errorMessage.isEmpty()) {
+            qCWarning(PlasmaSetupHostnameUtil) << "Failed to set" << kind << "hostname:" << errorMessage;
+            return;
+        }
+
+        qCInfo(PlasmaSetupHostnameUtil) << "Successfully set" << kind << "hostname.";
+    });
+    connect(&m_systemSettings, &SystemSettingsCommitter::allCommitted, this, &HostnameUtil::systemSettingsCommitted);
+
+    connect(&m_hostname1, &SystemPropertyCache::loaded, this, [this]() {
+        loadHostname();
+        Q_EMIT loadedChanged();
+    });
+    connect(&m_hostname1, &SystemPropertyCache::propertiesChanged, this, &HostnameUtil::loadHostname);
 }
 
 QString HostnameUtil::hostname() const
@@ -129,6 +45,11 @@ QString HostnameUtil::hostname() const
     return m_hostname;
 }
 
+bool HostnameUtil::isLoaded() const
+{
+    return m_hostname1.isLoaded();
+}
+
 bool HostnameUtil::hostnameIsDefault() const
 {
     if (m_hostname.startsWith(QStringLiteral("localhost"))) {
@@ -136,7 +57,7 @@ bool HostnameUtil::hostnameIsDefault() const
         return true;
     }
 
-    QString defaultHostname = m_dbusInterface->defaultHostname();
+    const QString defaultHostname = m_hostname1.value(QStringLiteral("DefaultHostname")).toString();
     bool currentHostnameIsDefault = m_hostname == defaultHostname;
     qCDebug(PlasmaSetupHostnameUtil) << "Current hostname:" << m_hostname << "; Default hostname from hostnamed:" << defaultHostname
                                      << "; Is default:" << currentHostnameIsDefault;
@@ -152,13 +73,13 @@ void HostnameUtil::setHostname(const QString &hostname)
         return;
     }
 
-    const HostnameValidationResult validationResult = validateHostname(trimmed);
-    if (validationResult != HostnameValidationResult::Valid) {
+    if (!isHostnameValid(trimmed)) {
         qCWarning(PlasmaSetupHostnameUtil) << "Rejected invalid hostname" << trimmed << hostnameValidationMessage(trimmed);
         return;
     }
 
     m_hostname = trimmed;
+    m_hostnameChosen = true;
     Q_EMIT hostnameChanged();
 
     setHostnameOnSystem(trimmed);
@@ -166,20 +87,24 @@ void HostnameUtil::setHostname(const QString &hostname)
 
 bool HostnameUtil::isHostnameValid(const QString &hostname) const
 {
-    return validateHostname(hostname.trimmed()) == HostnameValidationResult::Valid;
+    return m_hostnameValidation.result(hostname) == PlasmaSetupValidation::Hostname::HostnameValidationResult::Valid;
 }
 
 QString HostnameUtil::hostnameValidationMessage(const QString &hostname) const
 {
-    const HostnameValidationResult result = validateHostname(hostname.trimmed());
-    return hostnameValidationMessageForResult(result);
+    return m_hostnameValidation.message(hostname);
 }
 
 void HostnameUtil::loadHostname()
 {
-    QString hostname = readHostnameViaDBus(QStringLiteral("StaticHostname"));
+    const QString staticHostname = cachedHostname(QStringLiteral("StaticHostname"));
+    const QString transientHostname = cachedHostname(QStringLiteral("Hostname"));
+    m_systemSettings.setCurrentValue(STATIC_HOSTNAME_SETTING, staticHostname);
+    m_systemSettings.setCurrentValue(TRANSIENT_HOSTNAME_SETTING, transientHostname);
+
+    QString hostname = staticHostname;
     if (hostname.isEmpty()) {
-        hostname = readHostnameViaDBus(QStringLiteral("Hostname"));
+        hostname = transientHostname;
     }
     if (hostname.isEmpty()) {
         hostname = QSysInfo::machineHostName();
@@ -187,26 +112,21 @@ void HostnameUtil::loadHostname()
 
     hostname = hostname.trimmed();
 
-    if (hostname != m_hostname) {
+    // Don't replace what the user chose with what the system currently has
+    if (!m_hostnameChosen && hostname != m_hostname) {
         m_hostname = hostname;
         Q_EMIT hostnameChanged();
     }
 }
 
-QString HostnameUtil::readHostnameViaDBus(const QString &propertyName)
+QString HostnameUtil::cachedHostname(const QString &propertyName) const
 {
-    QString value;
-
-    if (propertyName == QLatin1String("StaticHostname")) {
-        value = m_dbusInterface->staticHostname();
-    } else if (propertyName == QLatin1String("Hostname")) {
-        value = m_dbusInterface->hostname();
-    } else {
+    if (propertyName != QLatin1String("StaticHostname") && propertyName != QLatin1String("Hostname")) {
         qCWarning(PlasmaSetupHostnameUtil) << "Unknown property name requested:" << propertyName;
         return {};
     }
 
-    return value;
+    return m_hostname1.value(propertyName).toString();
 }
 
 void HostnameUtil::setHostnameOnSystem(const QString &hostname)
@@ -217,36 +137,29 @@ void HostnameUtil::setHostnameOnSystem(const QString &hostname)
 
 void HostnameUtil::setStaticHostname(const QString &hostname)
 {
+    QDBusMessage message = QDBusMessage::createMethodCall(m_dbusInterface->service(),
+                                                          m_dbusInterface->path(),
+                                                          m_dbusInterface->interface(),
+                                                          QStringLiteral("SetStaticHostname"));
     const bool interactive = false;
-    QDBusPendingReply<> reply = m_dbusInterface->SetStaticHostname(hostname, interactive);
-    QDBusPendingCallWatcher *staticWatcher = new QDBusPendingCallWatcher(reply, this);
-    connect(staticWatcher, &QDBusPendingCallWatcher::finished, [hostname](QDBusPendingCallWatcher *watcher) {
-        watcher->deleteLater();
-
-        if (watcher->isError()) {
-            qCWarning(PlasmaSetupHostnameUtil) << "Failed to set static hostname:" << hostname << ";" << watcher->error().message();
-            return;
-        }
-
-        qCInfo(PlasmaSetupHostnameUtil) << "Successfully set static hostname.";
-    });
+    message << hostname << interactive;
+    m_systemSettings.stage(STATIC_HOSTNAME_SETTING, hostname, message);
 }
 
 void HostnameUtil::setTransientHostname(const QString &hostname)
 {
+    QDBusMessage message = QDBusMessage::createMethodCall(m_dbusInterface->service(),
+                                                          m_dbusInterface->path(),
+                                                          m_dbusInterface->interface(),
+                                                          QStringLiteral("SetHostname"));
     const bool interactive = false;
-    QDBusPendingReply<> reply = m_dbusInterface->SetHostname(hostname, interactive);
-    QDBusPendingCallWatcher *transientWatcher = new QDBusPendingCallWatcher(reply, this);
-    connect(transientWatcher, &QDBusPendingCallWatcher::finished, [hostname](QDBusPendingCallWatcher *watcher) {
-        watcher->deleteLater();
-
-        if (watcher->isError()) {
-            qCWarning(PlasmaSetupHostnameUtil) << "Failed to set transient hostname:" << hostname << ";" << watcher->error().message();
-            return;
-        }
+    message << hostname << interactive;
+    m_systemSettings.stage(TRANSIENT_HOSTNAME_SETTING, hostname, message);
+}
 
-        qCInfo(PlasmaSetupHostnameUtil) << "Successfully set transient hostname.";
-    });
+void HostnameUtil::commitSystemSettings()
+{
+    m_systemSettings.commit();
 }
 
 #include "moc_hostnameutil.cpp"
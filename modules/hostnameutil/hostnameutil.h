@@ -5,6 +5,9 @@
 #pragma once
 
 #include "hostname1_interface.h"
+#include "hostnamevalidator.h"
+#include "systempropertycache.h"
+#include "systemsettingscommitter.h"
 
 #include <QObject>
 #include <qqmlintegration.h>
@@ -26,6 +29,14 @@ class HostnameUtil : public QObject
      */
     Q_PROPERTY(QString hostname READ hostname WRITE setHostname NOTIFY hostnameChanged)
 
+    /**
+     * Whether the hostnames have been read from the system.
+     *
+     * They are read asynchronously, so hostname and hostnameIsDefault() are only
+     * meaningful once this is true.
+     */
+    Q_PROPERTY(bool loaded READ isLoaded NOTIFY loadedChanged)
+
 public:
     /**
      * Default constructor.
@@ -37,6 +48,8 @@ public:
      */
     QString hostname() const;
 
+    bool isLoaded() const;
+
     /**
      * Checks if the current hostname is the system default.
      *
@@ -71,29 +84,53 @@ public:
      * isHostnameValid() or hostnameValidationMessage() before invoking this
      * function to ensure the hostname will be accepted.
      *
+     * The change is staged, and written to the system by commitSystemSettings().
+     *
      * @param hostname The new hostname to set.
      */
     void setHostname(const QString &hostname);
 
+    /**
+     * Writes the chosen hostname to the system.
+     *
+     * Meant to be called when the user leaves the hostname page, so that typing a
+     * hostname does not write every intermediate value.
+     */
+    Q_INVOKABLE void commitSystemSettings();
+
 Q_SIGNALS:
     /**
      * Emitted when the hostname changes.
      */
     void hostnameChanged();
 
+    /**
+     * Emitted once the hostnames have been read from the system.
+     */
+    void loadedChanged();
+
+    /**
+     * Emitted once the settings written by commitSystemSettings() have been written.
+     *
+     * @param errorMessages The errors of the writes that failed, empty if all succeeded.
+     */
+    void systemSettingsCommitted(const QStringList &errorMessages);
+
 private:
     /**
      * Reads the current hostname from the system.
+     *
+     * The hostname property is only updated as long as the user has not chosen one.
      */
     void loadHostname();
 
     /**
-     * Attempts to read the hostname via D-Bus.
+     * Returns the hostname from the cached hostnamed properties.
      *
      * @param propertyName The D-Bus property name to read, e.g., "StaticHostname" or "Hostname".
      * @return The retrieved value, or an empty string on failure.
      */
-    QString readHostnameViaDBus(const QString &propertyName);
+    QString cachedHostname(const QString &propertyName) const;
 
     /**
      * Applies the requested hostname to the system.
@@ -103,14 +140,14 @@ private:
     void setHostnameOnSystem(const QString &hostname);
 
     /**
-     * Sets the static hostname via D-Bus.
+     * Stages setting the static hostname via D-Bus.
      *
      * @param hostname The static hostname to set.
      */
     void setStaticHostname(const QString &hostname);
 
     /**
-     * Sets the transient hostname via D-Bus.
+     * Stages setting the transient hostname via D-Bus.
      *
      * @param hostname The transient hostname to set.
      */
@@ -125,4 +162,20 @@ private:
      * Cached hostname value.
      */
     QString m_hostname;
+
+    /** Whether the user set a hostname, which then takes precedence over the system's. */
+    bool m_hostnameChosen = false;
+
+    /** The properties of org.freedesktop.hostname1. */
+    SystemPropertyCache m_hostname1;
+
+    SystemSettingsCommitter m_systemSettings;
+
+    /**
+     * The validation of the hostname last entered, shared by isHostnameValid() and hostnameValidationMessage().
+     */
+    PlasmaSetupValidation::ValidationCache<PlasmaSetupValidation::Hostname::HostnameValidationResult> m_hostnameValidation{
+        PlasmaSetupValidation::Hostname::validateHostname,
+        PlasmaSetupValidation::Hostname::hostnameValidationMessage,
+    };
 };
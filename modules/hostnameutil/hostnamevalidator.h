@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2025 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "validation.h"
+
+#include <KLocalizedString>
+
+#include <QLatin1StringView>
+#include <QString>
+#include <QStringView>
+
+#include <array>
+
+/**
+ * Hostname validation logic for Plasma Setup.
+ */
+
+namespace PlasmaSetupValidation
+{
+namespace Hostname
+{
+
+/**
+ * Possible results of hostname validation.
+ */
+enum class HostnameValidationResult {
+    Valid,
+    Empty,
+    Disallowed,
+    TooLong,
+    LeadingDot,
+    TrailingDot,
+    ConsecutiveDots,
+    EmptyLabel,
+    LabelTooLong,
+    InvalidCharacters,
+};
+
+/**
+ * Maximum number of characters allowed in a hostname.
+ */
+constexpr int MAX_HOSTNAME_LENGTH = 253;
+
+/**
+ * Maximum number of characters allowed in each dot-separated label of a hostname.
+ */
+constexpr int MAX_LABEL_LENGTH = 63;
+
+/**
+ * Hostnames that would break networking if used.
+ */
+constexpr std::array<QLatin1StringView, 2> DISALLOWED_HOSTNAMES = {QLatin1StringView("localhost"), QLatin1StringView("localhost.localdomain")};
+
+/**
+ * Validate the provided hostname.
+ *
+ * Hostnames are made of labels separated by dots. Labels may contain letters, digits and
+ * hyphens, and must start and end with a letter or digit.
+ *
+ * Problems with the dots take precedence over problems with the labels, whatever their position.
+ *
+ * @param hostname The hostname to validate.
+ * @return The result of the validation.
+ */
+inline HostnameValidationResult validateHostname(QStringView hostname)
+{
+    const QStringView trimmed = hostname.trimmed();
+
+    if (trimmed.isEmpty()) {
+        return HostnameValidationResult::Empty;
+    }
+
+    for (const QLatin1StringView disallowed : DISALLOWED_HOSTNAMES) {
+        if (trimmed.compare(disallowed, Qt::CaseInsensitive) == 0) {
+            return HostnameValidationResult::Disallowed;
+        }
+    }
+
+    if (trimmed.size() > MAX_HOSTNAME_LENGTH) {
+        return HostnameValidationResult::TooLong;
+    }
+
+    if (trimmed.front() == u'.') {
+        return HostnameValidationResult::LeadingDot;
+    }
+
+    if (trimmed.back() == u'.') {
+        return HostnameValidationResult::TrailingDot;
+    }
+
+    using namespace PlasmaSetupValidation::CharacterClass;
+
+    // Labels are checked as the dots are found, the first problem is only reported
+    // once it is clear there are no consecutive dots later on
+    HostnameValidationResult labelResult = HostnameValidationResult::Valid;
+    qsizetype labelStart = 0;
+    bool labelValid = true;
+    for (qsizetype i = 0; i <= trimmed.size(); ++i) {
+        if (i < trimmed.size() && trimmed[i] != u'.') {
+            labelValid = labelValid && hasCharacterClass(trimmed[i], Letter | Digit | Hyphen);
+            continue;
+        }
+
+        const qsizetype labelLength = i - labelStart;
+        if (labelLength == 0) {
+            return HostnameValidationResult::ConsecutiveDots;
+        }
+
+        if (labelResult == HostnameValidationResult::Valid) {
+            if (labelLength > MAX_LABEL_LENGTH) {
+                labelResult = HostnameValidationResult::LabelTooLong;
+            } else if (!labelValid || trimmed[labelStart] == u'-' || trimmed[i - 1] == u'-') {
+                labelResult = HostnameValidationResult::InvalidCharacters;
+            }
+        }
+
+        labelStart = i + 1;
+        labelValid = true;
+    }
+
+    return labelResult;
+}
+
+/**
+ * Returns user-facing feedback for a validation result. When the hostname is valid,
+ * the returned string is empty.
+ */
+inline QString hostnameValidationMessage(HostnameValidationResult result)
+{
+    switch (result) {
+    case HostnameValidationResult::Valid:
+        return QString();
+    case HostnameValidationResult::Empty:
+        return i18nc("@info", "Hostname cannot be empty.");
+    case HostnameValidationResult::Disallowed:
+        return i18nc("@info", "Hostname cannot be “localhost” or “localhost.localdomain”.");
+    case HostnameValidationResult::TooLong:
+        return i18nc("@info", "Hostname is too long (maximum 253 characters).");
+    case HostnameValidationResult::LeadingDot:
+        return i18nc("@info", "Hostname cannot start with a dot.");
+    case HostnameValidationResult::TrailingDot:
+        return i18nc("@info", "Hostname cannot end with a dot.");
+    case HostnameValidationResult::ConsecutiveDots:
+        return i18nc("@info", "Hostname cannot contain consecutive dots.");
+    case HostnameValidationResult::EmptyLabel:
+        return i18nc("@info", "Hostname labels cannot be empty.");
+    case HostnameValidationResult::LabelTooLong:
+        return i18nc("@info", "Each hostname label must be at most 63 characters.");
+    case HostnameValidationResult::InvalidCharacters:
+        return i18nc("@info", "Hostnames may contain letters, numbers, and hyphens. Each label must start and end with a letter or number.");
+    }
+
+    return QString();
+}
+
+} // namespace Hostname
+} // namespace PlasmaSetupValidation
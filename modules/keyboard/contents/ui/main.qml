@@ -12,16 +12,16 @@ import QtQuick.Layouts
 import QtQuick.Controls
 
 import org.kde.kirigami as Kirigami
-import org.kde.kitemmodels as KItemModels
 
 import org.kde.plasmasetup
 import org.kde.plasmasetup.components as PlasmaSetupComponents
 
-import org.kde.plasma.private.kcm_keyboard as KCMKeyboard
-
 PlasmaSetupComponents.SetupModule {
     id: root
 
+    // The chosen layout and variant are kept by KeyboardUtil and selected again in onPageActivated().
+    unloadable: true
+
     available: !Kirigami.Settings.isMobile
 
     function onPageActivated(): void {
@@ -30,57 +30,22 @@ PlasmaSetupComponents.SetupModule {
         layoutsView.highlightMoveDuration = 0;
         variantView.highlightMoveDuration = 0;
         // Set the initial current item to the system's current layout.
-        layoutsView.currentIndex = layoutsProxy.findCurrentLayoutIndex();
+        layoutsView.currentIndex = layoutsModel.findCurrentLayoutIndex();
         // Set the initial current variant to the system's current variant.
-        variantView.currentIndex = variantProxy.findCurrentVariantIndex();
+        variantView.currentIndex = variantsModel.findCurrentVariantIndex();
         // Reset the highlight move duration to the default value.
         layoutsView.highlightMoveDuration = -1;
         variantView.highlightMoveDuration = -1;
         searchField.forceActiveFocus();
     }
 
-    KCMKeyboard.LayoutSearchModel {
-        id: layoutSearchProxy
-        sourceModel: KCMKeyboard.LayoutModel {}
-        searchString: ""
+    function onPageDeactivated(): void {
+        KeyboardUtil.commitSystemSettings();
     }
 
-    KItemModels.KSortFilterProxyModel {
-        id: layoutsProxy
-        sourceModel: layoutSearchProxy
-        sortRoleName: "searchScore"
-        sortOrder: Qt.AscendingOrder
-
-        filterRowCallback: function (row, parent) {
-            const modelIndex = sourceModel.index(row, 0, parent);
-            const currentVariantName = modelIndex.data(KItemModels.KRoleNames.role("variantName"));
-            const description = modelIndex.data(KItemModels.KRoleNames.role("description"));
-
-            if (currentVariantName !== '') {
-                return false;
-            }
-
-            if (searchField.text.length > 0) {
-                const score = modelIndex.data(KItemModels.KRoleNames.role("searchScore"));
-                if (score !== 0) {
-                    return true;
-                }
-                const shortNameRole = KItemModels.KRoleNames.role("shortName");
-                const currentName = modelIndex.data(shortNameRole);
-                const searchScoreRole = KItemModels.KRoleNames.role("searchScore");
-                for (let i = 0; i < sourceModel.rowCount(); i++) {
-                    const index = sourceModel.index(i, 0, parent);
-                    const name = sourceModel.data(index, shortNameRole);
-                    const variantSearchScore = sourceModel.data(index, searchScoreRole);
-                    if (name === currentName && variantSearchScore > 100) {
-                        return true;
-                    }
-                }
-                return false;
-            }
-
-            return true;
-        }
+    KeyboardLayoutModel {
+        id: layoutsModel
+        searchString: searchField.text
 
         // Returns the index matching the system's current keyboard layout, or -1 if not found.
         function findCurrentLayoutIndex(): int {
@@ -89,60 +54,26 @@ PlasmaSetupComponents.SetupModule {
             // pair with a non-latin layout.
             const layoutName = KeyboardUtil.layoutName.split(",").pop().trim();
 
-            // Iterate through the rows to find the layout that matches the system's current layout.
-            for (let i = 0; i < rowCount(); i++) {
-                const proxyIndex = index(i, 0);
-                const shortName = data(proxyIndex, KItemModels.KRoleNames.role("shortName"));
-                const description = data(proxyIndex, KItemModels.KRoleNames.role("description"));
-
-                if (shortName === layoutName) {
-                    console.warn("Found keyboard layout matching system default:", shortName, description);
-                    return i;
-                }
+            const layoutIndex = indexOf(layoutName, "");
+            if (layoutIndex === -1) {
+                console.warn("No keyboard layout matching system default found for layout name:", layoutName);
             }
-
-            console.warn("No keyboard layout matching system default found for layout name:", layoutName);
-            return -1; // Not found
+            return layoutIndex;
         }
     }
 
-    KItemModels.KSortFilterProxyModel {
-        id: variantProxy
-        sourceModel: layoutSearchProxy
-        sortRoleName: "searchScore"
-        sortOrder: Qt.AscendingOrder
-
-        filterRowCallback: function (row, parent) {
-            if (!layoutsView.currentItem) {
-                return false;
-            }
-
-            const modelIndex = sourceModel.index(row, 0, parent);
-            const currentName = modelIndex.data(KItemModels.KRoleNames.role("shortName"));
-            const selectedName = layoutsView.currentItem.shortName;
-
-            if (currentName !== selectedName) {
-                return false;
-            }
-
-            if (searchField.text.length > 0) {
-                const searchScore = modelIndex.data(KItemModels.KRoleNames.role("searchScore"));
-                return searchScore > 100;
-            }
-
-            return true;
-        }
+    KeyboardLayoutModel {
+        id: variantsModel
+        variants: true
+        layoutName: layoutsView.currentItem ? layoutsView.currentItem.shortName : ""
+        searchString: searchField.text
 
         // Returns the index matching the system's current keyboard layout variant, or -1 if not found.
         function findCurrentVariantIndex(): int {
-            const layoutIndex = layoutsView.currentIndex;
-            if (layoutIndex === -1) {
+            if (layoutName === "") {
                 return -1; // No layout selected, so no variant to find
             }
 
-            const layoutModelIndex = layoutsProxy.index(layoutIndex, 0);
-            const layoutShortName = layoutsProxy.data(layoutModelIndex, KItemModels.KRoleNames.role("shortName"));
-
             // The system's current layout variant, if any (e.g. "dvorak" in "us(dvorak)").
             //
             // If there are multiple variants configured (e.g. a layout of "us,ru(bak)") we only
@@ -151,20 +82,11 @@ PlasmaSetupComponents.SetupModule {
             // the actual non-latin layout we care about showing in the picker.
             const currentVariantName = KeyboardUtil.layoutVariant.split(",").pop().trim();
 
-            // Iterate through the rows to find the variant that matches the system's current variant for the selected layout.
-            for (let i = 0; i < rowCount(); i++) {
-                const proxyIndex = index(i, 0);
-                const shortName = data(proxyIndex, KItemModels.KRoleNames.role("shortName"));
-                const variantName = data(proxyIndex, KItemModels.KRoleNames.role("variantName"));
-
-                if (shortName === layoutShortName && variantName === currentVariantName) {
-                    console.warn("Found keyboard variant matching system default. Layout:", shortName, "Variant:", variantName);
-                    return i;
-                }
+            const variantIndex = indexOf(layoutName, currentVariantName);
+            if (variantIndex === -1) {
+                console.warn("No keyboard variant matching system default found for layout:", layoutName, "and variant name:", currentVariantName);
             }
-
-            console.warn("No keyboard variant matching system default found for layout:", layoutShortName, "and variant name:", currentVariantName);
-            return -1; // Not found
+            return variantIndex;
         }
     }
 
@@ -191,9 +113,6 @@ PlasmaSetupComponents.SetupModule {
             Kirigami.SearchField {
                 id: searchField
                 Layout.fillWidth: true
-                onAccepted: {
-                    layoutSearchProxy.searchString = searchField.text.trim();
-                }
             }
 
             RowLayout {
@@ -214,14 +133,10 @@ PlasmaSetupComponents.SetupModule {
 
                     contentItem: ListView {
                         id: layoutsView
-                        model: layoutsProxy
+                        model: layoutsModel
                         delegate: LayoutDelegate {}
                         keyNavigationEnabled: true
                         activeFocusOnTab: true
-
-                        onCurrentIndexChanged: {
-                            variantProxy.invalidateFilter();
-                        }
                     }
                 }
 
@@ -239,7 +154,7 @@ PlasmaSetupComponents.SetupModule {
 
                     contentItem: ListView {
                         id: variantView
-                        model: layoutsView.currentItem ? variantProxy : []
+                        model: variantsModel
                         delegate: LayoutDelegate {}
                         keyNavigationEnabled: true
                         activeFocusOnTab: true
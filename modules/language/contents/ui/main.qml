@@ -23,10 +23,22 @@ import org.kde.plasmasetup.components as PlasmaSetupComponents
 PlasmaSetupComponents.SetupModule {
     id: root
 
+    // The chosen language is kept by LanguageUtil, only the search text is lost.
+    unloadable: true
+
     function onPageActivated(): void {
         searchField.forceActiveFocus();
     }
 
+    function onPageDeactivated(): void {
+        Language.LanguageUtil.commitSystemSettings();
+    }
+
+    function onPageReleased(): void {
+        // Rebuilt from the stored catalog if the user comes back to the page
+        Language.LanguageUtil.releaseResources();
+    }
+
     contentItem: ColumnLayout {
         id: mainColumn
 
@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "languagecatalog.h"
+
+#include "cachedirectory.h"
+#include "plasmasetup_languageutil_debug.h"
+
+#include <KLocalizedString>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <utility>
+
+/**
+ * The first line of a catalog file, to be changed whenever the format changes.
+ */
+static constexpr QByteArrayView CATALOG_HEADER = "PlasmaSetupLanguageCatalog 1";
+
+namespace LanguageCatalog
+{
+
+Catalog scan()
+{
+    Catalog catalog;
+    catalog.stamp = localeDirectoriesStamp();
+
+    QStringList codes = KLocalizedString::availableDomainTranslations("plasmashell").values();
+
+    // Ensure we at least have English available
+    if (!codes.contains(QStringLiteral("en_US"))) {
+        codes.append(QStringLiteral("en_US"));
+    }
+
+    codes.sort();
+
+    catalog.languages.reserve(codes.size());
+    for (const QString &code : std::as_const(codes)) {
+        const QLocale locale(code);
+        catalog.languages.append({code, locale.nativeLanguageName(), QLocale::languageToString(locale.language())});
+    }
+
+    return catalog;
+}
+
+QString localeDirectoriesStamp()
+{
+    // The directory of a language often exists already for other applications, so it is the
+    // plasmashell catalogs themselves that tell whether a translation was installed or removed
+    QStringList stamps;
+    const QStringList directories = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("locale"), QStandardPaths::LocateDirectory);
+    for (const QString &directory : directories) {
+        const QStringList languageDirectories = QDir(directory).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QString &languageDirectory : languageDirectories) {
+            const QFileInfo catalog(directory + QLatin1Char('/') + languageDirectory + QStringLiteral("/LC_MESSAGES/plasmashell.mo"));
+            if (catalog.exists()) {
+                stamps << catalog.filePath() + QLatin1Char('@') + QString::number(catalog.lastModified().toMSecsSinceEpoch());
+            }
+        }
+    }
+    return stamps.join(QLatin1Char(':'));
+}
+
+QString path()
+{
+    return CacheDirectory::path() + QStringLiteral("/languagecatalog");
+}
+
+std::optional<Catalog> load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    const uchar *mapped = file.map(0, file.size());
+    if (!mapped) {
+        return parse(file.readAll());
+    }
+
+    std::optional<Catalog> catalog = parse(QByteArrayView(mapped, file.size()));
+    file.unmap(const_cast<uchar *>(mapped));
+    return catalog;
+}
+
+std::optional<Catalog> parse(QByteArrayView data)
+{
+    const auto nextLine = [&data]() {
+        const qsizetype end = data.indexOf('\n');
+        const QByteArrayView line = end < 0 ? data : data.first(end);
+        data = end < 0 ? QByteArrayView() : data.sliced(end + 1);
+        return line;
+    };
+
+    if (nextLine() != CATALOG_HEADER || data.isEmpty()) {
+        return std::nullopt;
+    }
+
+    Catalog catalog;
+    catalog.stamp = QString::fromUtf8(nextLine());
+
+    while (!data.isEmpty()) {
+        const QByteArrayView line = nextLine();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        const qsizetype firstTab = line.indexOf('\t');
+        const qsizetype secondTab = firstTab < 0 ? -1 : line.sliced(firstTab + 1).indexOf('\t');
+        if (secondTab < 0) {
+            qCWarning(PlasmaSetupLanguageUtil) << "Ignoring the malformed language catalog";
+            return std::nullopt;
+        }
+
+        const QByteArrayView rest = line.sliced(firstTab + 1);
+        catalog.languages.append({
+            QString::fromUtf8(line.first(firstTab)),
+            QString::fromUtf8(rest.first(secondTab)),
+            QString::fromUtf8(rest.sliced(secondTab + 1)),
+        });
+    }
+
+    if (catalog.languages.isEmpty()) {
+        return std::nullopt;
+    }
+
+    return catalog;
+}
+
+bool save(const QString &path, const Catalog &catalog)
+{
+    QDir().mkpath(QFileInfo(path).path());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(PlasmaSetupLanguageUtil) << "Unable to write the language catalog to" << path << ':' << file.errorString();
+        return false;
+    }
+
+    QByteArray data = CATALOG_HEADER.toByteArray() + '\n' + catalog.stamp.toUtf8() + '\n';
+    for (const LanguageEntry &language : catalog.languages) {
+        data += language.code.toUtf8() + '\t' + language.nativeName.toUtf8() + '\t' + language.englishName.toUtf8() + '\n';
+    }
+
+    file.write(data);
+    if (!file.commit()) {
+        qCWarning(PlasmaSetupLanguageUtil) << "Unable to write the language catalog to" << path << ':' << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+}
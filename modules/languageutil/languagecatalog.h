@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+
+#include <optional>
+
+/**
+ * A language Plasma is translated to.
+ */
+struct LanguageEntry {
+    /** The locale code, e.g. "pt_BR". */
+    QString code;
+
+    /** The name of the language in the language itself. */
+    QString nativeName;
+
+    /** The name of the language in English. */
+    QString englishName;
+
+    bool operator==(const LanguageEntry &other) const = default;
+};
+
+/**
+ * The catalog of the languages Plasma is translated to, persisted across runs.
+ *
+ * Finding the available translations walks every locale directory on disk, and resolving the
+ * names of the languages is slow on cold boots. The result is stored in the persistent cache
+ * directory, see CacheDirectory, along with a stamp of the installed translations. The stored
+ * catalog is shown right away, checking the stamp costs about as much as finding the
+ * translations, so it is done in the background.
+ */
+namespace LanguageCatalog
+{
+
+struct Catalog {
+    /** The available languages, sorted by code. */
+    QList<LanguageEntry> languages;
+
+    /** The stamp of the locale directories the languages were found in, see localeDirectoriesStamp(). */
+    QString stamp;
+};
+
+/**
+ * Finds the available languages on disk and resolves their names.
+ *
+ * This may block for a long time and can be run off the GUI thread.
+ */
+Catalog scan();
+
+/**
+ * Returns a stamp changing whenever the plasmashell translation of a language is installed, removed or updated.
+ *
+ * Stats the catalog of every language directory, so it is better computed off the GUI thread.
+ */
+QString localeDirectoriesStamp();
+
+/**
+ * Returns where the catalog is stored.
+ */
+QString path();
+
+/**
+ * Loads the catalog stored at the given path, whether it is up to date or not.
+ */
+std::optional<Catalog> load(const QString &path);
+
+/**
+ * Parses the contents of a catalog file.
+ */
+std::optional<Catalog> parse(QByteArrayView data);
+
+/**
+ * Stores the catalog at the given path, replacing the previous one.
+ */
+bool save(const QString &path, const Catalog &catalog);
+
+}
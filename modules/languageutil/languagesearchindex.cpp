@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "languagesearchindex.h"
+
+#include "textsearch.h"
+
+#include <algorithm>
+
+void LanguageSearchIndex::build(const QList<LanguageEntry> &languages)
+{
+    m_text.clear();
+    m_offsets.clear();
+    m_offsets.reserve(languages.size());
+
+    for (const LanguageEntry &language : languages) {
+        const std::array<QString, FieldCount> fields = {
+            TextSearch::fold(language.code),
+            TextSearch::fold(language.nativeName),
+            TextSearch::fold(language.englishName),
+        };
+
+        std::array<qsizetype, FieldCount + 1> offsets;
+        for (int i = 0; i < FieldCount; ++i) {
+            offsets[i] = m_text.size();
+            m_text += fields[i];
+        }
+        offsets[FieldCount] = m_text.size();
+        m_offsets.append(offsets);
+    }
+
+    m_text.squeeze();
+}
+
+qsizetype LanguageSearchIndex::size() const
+{
+    return m_offsets.size();
+}
+
+LanguageSearchIndex::Rank LanguageSearchIndex::rank(qsizetype row, QStringView foldedQuery) const
+{
+    if (row < 0 || row >= m_offsets.size()) {
+        return NoMatch;
+    }
+
+    Rank best = NoMatch;
+    for (int i = 0; i < FieldCount && best != ExactMatch; ++i) {
+        const QStringView text = field(row, static_cast<Field>(i));
+        const bool isCode = i == CodeField;
+
+        Rank fieldRank = NoMatch;
+        switch (TextSearch::match(text, foldedQuery, !isCode)) {
+        case TextSearch::ExactMatch:
+            fieldRank = ExactMatch;
+            break;
+        case TextSearch::PrefixMatch:
+            fieldRank = isCode ? CodePrefixMatch : NamePrefixMatch;
+            break;
+        case TextSearch::WordPrefixMatch:
+            fieldRank = WordPrefixMatch;
+            break;
+        case TextSearch::SubstringMatch:
+            fieldRank = SubstringMatch;
+            break;
+        case TextSearch::NoMatch:
+            break;
+        }
+
+        best = std::min(best, fieldRank);
+    }
+
+    return best;
+}
+
+QStringView LanguageSearchIndex::field(qsizetype row, Field field) const
+{
+    const auto &offsets = m_offsets.at(row);
+    return QStringView(m_text).sliced(offsets[field], offsets[field + 1] - offsets[field]);
+}
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QList>
+#include <QString>
+
+#include "languagecatalog.h"
+
+#include <array>
+
+/**
+ * A search index over the available languages.
+ *
+ * Built once when the languages are loaded, it holds the locale code, native language name and
+ * English language name of every language, folded for matching and stored in a single string.
+ * Matching is case and diacritic insensitive, so "espanol" matches "español".
+ */
+class LanguageSearchIndex
+{
+public:
+    /**
+     * How well a language matches a query, lower is better.
+     */
+    enum Rank {
+        /** The query is the whole code or name. */
+        ExactMatch,
+        /** A name starts with the query. */
+        NamePrefixMatch,
+        /** The code starts with the query. */
+        CodePrefixMatch,
+        /** A word inside a name starts with the query. */
+        WordPrefixMatch,
+        /** The query appears anywhere else. */
+        SubstringMatch,
+        /** The query does not match. */
+        NoMatch,
+    };
+
+    /**
+     * Builds the index for the given languages, replacing the previous contents.
+     *
+     * Rows of the index are in the same order as the given languages.
+     */
+    void build(const QList<LanguageEntry> &languages);
+
+    /**
+     * The number of languages in the index.
+     */
+    qsizetype size() const;
+
+    /**
+     * Returns how well the language at the given row matches the query.
+     *
+     * @param foldedQuery A query folded with TextSearch::fold().
+     */
+    Rank rank(qsizetype row, QStringView foldedQuery) const;
+
+private:
+    enum Field {
+        CodeField,
+        NativeNameField,
+        EnglishNameField,
+        FieldCount,
+    };
+
+    QStringView field(qsizetype row, Field field) const;
+
+    /** The folded fields of all languages, one after the other. */
+    QString m_text;
+
+    /** The offset of every field in m_text, followed by the end of the last field, per row. */
+    QList<std::array<qsizetype, FieldCount + 1>> m_offsets;
+};
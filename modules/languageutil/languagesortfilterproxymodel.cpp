@@ -1,13 +1,22 @@
 // SPDX-FileCopyrightText: 2026 Tiziano Gaia <ti.gaia@proton.me>
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "languagesortfilterproxymodel.h"
 
-#include <QLocale>
+#include "textsearch.h"
 
 LanguageSortFilterProxyModel::LanguageSortFilterProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
 {
+    sort(0);
+}
+
+void LanguageSortFilterProxyModel::setSearchIndex(const LanguageSearchIndex *searchIndex)
+{
+    m_searchIndex = searchIndex;
+    updateRanks(QString());
+    invalidate();
 }
 
 void LanguageSortFilterProxyModel::setFilterString(const QString &filter)
@@ -16,27 +25,71 @@ void LanguageSortFilterProxyModel::setFilterString(const QString &filter)
         return;
     }
 
-    beginFilterChange();
+    const QString previousFoldedFilter = m_foldedFilterString;
     m_filterString = filter;
-    endFilterChange();
+    m_foldedFilterString = TextSearch::fold(filter);
+
+    if (m_foldedFilterString == previousFoldedFilter) {
+        return;
+    }
+
+    updateRanks(previousFoldedFilter);
+
+    // The ranks of the remaining rows may change too, so sort again as well as filtering
+    invalidate();
+}
+
+void LanguageSortFilterProxyModel::updateRanks(const QString &previousFoldedFilter)
+{
+    if (!m_searchIndex || m_foldedFilterString.isEmpty()) {
+        m_ranks.clear();
+        return;
+    }
+
+    const qsizetype rowCount = m_searchIndex->size();
+    const bool narrowing = !previousFoldedFilter.isEmpty() && m_foldedFilterString.startsWith(previousFoldedFilter) && m_ranks.size() == rowCount;
+
+    if (!narrowing) {
+        m_ranks.fill(LanguageSearchIndex::NoMatch, rowCount);
+    }
+
+    for (qsizetype row = 0; row < rowCount; ++row) {
+        // A row not matching a prefix of the filter cannot match the filter
+        if (narrowing && m_ranks.at(row) == LanguageSearchIndex::NoMatch) {
+            continue;
+        }
+        m_ranks[row] = m_searchIndex->rank(row, m_foldedFilterString);
+    }
+}
+
+LanguageSearchIndex::Rank LanguageSortFilterProxyModel::rank(int sourceRow) const
+{
+    return sourceRow < m_ranks.size() ? m_ranks.at(sourceRow) : LanguageSearchIndex::NoMatch;
 }
 
 bool LanguageSortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    if (m_filterString.isEmpty()) {
+    Q_UNUSED(sourceParent)
+
+    if (m_foldedFilterString.isEmpty() || !m_searchIndex) {
         return true;
     }
 
-    const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-    const QString language = sourceModel()->data(index, Qt::DisplayRole).toString();
-
-    const QLocale locale(language);
+    return rank(sourceRow) != LanguageSearchIndex::NoMatch;
+}
 
-    const QString nativeName = locale.nativeLanguageName();
-    const QString englishName = QLocale::languageToString(locale.language());
+bool LanguageSortFilterProxyModel::lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const
+{
+    if (!m_ranks.isEmpty()) {
+        const auto leftRank = rank(sourceLeft.row());
+        const auto rightRank = rank(sourceRight.row());
+        if (leftRank != rightRank) {
+            return leftRank < rightRank;
+        }
+    }
 
-    return language.contains(m_filterString, Qt::CaseInsensitive) || nativeName.contains(m_filterString, Qt::CaseInsensitive)
-        || englishName.contains(m_filterString, Qt::CaseInsensitive);
+    // Keep the order of the source model among equally good matches
+    return sourceLeft.row() < sourceRight.row();
 }
 
 QHash<int, QByteArray> LanguageSortFilterProxyModel::roleNames() const
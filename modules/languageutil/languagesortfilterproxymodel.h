@@ -1,17 +1,23 @@
 // SPDX-FileCopyrightText: 2026 Tiziano Gaia <ti.gaia@proton.me>
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #pragma once
 
+#include <QList>
 #include <QSortFilterProxyModel>
 #include <QString>
 
+#include "languagesearchindex.h"
+
 class QModelIndex;
 class QVariant;
 
 /**
  * A proxy model that filters the list of available languages
  * by locale code, native language name, and English language name.
+ *
+ * Matching languages are sorted by how well they match, see LanguageSearchIndex::Rank.
  */
 class LanguageSortFilterProxyModel : public QSortFilterProxyModel
 {
@@ -20,13 +26,33 @@ class LanguageSortFilterProxyModel : public QSortFilterProxyModel
 public:
     explicit LanguageSortFilterProxyModel(QObject *parent = nullptr);
 
+    /**
+     * Sets the index used for matching, whose rows must be those of the source model.
+     */
+    void setSearchIndex(const LanguageSearchIndex *searchIndex);
+
     void setFilterString(const QString &filter);
 
 protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &sourceLeft, const QModelIndex &sourceRight) const override;
     QHash<int, QByteArray> roleNames() const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
 private:
+    /**
+     * Ranks the rows of the source model against the current filter.
+     *
+     * When the filter only got longer, just the rows that matched the previous filter are looked at again.
+     */
+    void updateRanks(const QString &previousFoldedFilter);
+
+    LanguageSearchIndex::Rank rank(int sourceRow) const;
+
+    const LanguageSearchIndex *m_searchIndex = nullptr;
     QString m_filterString;
+    QString m_foldedFilterString;
+
+    /** The rank of every source row for the current filter, empty when not filtering. */
+    QList<LanguageSearchIndex::Rank> m_ranks;
 };
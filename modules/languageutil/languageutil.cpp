@@ -9,17 +9,48 @@
 
 #include <QCoreApplication>
 #include <QDBusConnection>
-#include <QDBusReply>
+#include <QFutureWatcher>
 #include <QLocale>
 #include <QTimer>
+#include <QtConcurrentRun>
+
+#include <optional>
+
+/**
+ * How long to wait for the user to settle on a language before switching to it, in milliseconds.
+ */
+constexpr int APPLY_LANGUAGE_DELAY = 300;
+
+/**
+ * The key of the system locale in the committed system settings.
+ */
+const QString LOCALE_SETTING = QStringLiteral("locale");
 
 LanguageUtil::LanguageUtil(QObject *parent)
     : QObject(parent)
+    , m_systemSettings(QDBusConnection::systemBus())
 {
-    loadAvailableLanguages();
+    // The session was started with the system locale, so choosing it again needs no write
+    const QString sessionLang = qEnvironmentVariable("LANG");
+    if (!sessionLang.isEmpty()) {
+        m_systemSettings.setCurrentValue(LOCALE_SETTING, QStringList{QStringLiteral("LANG=") + sessionLang});
+    }
+    connect(&m_systemSettings, &SystemSettingsCommitter::committed, this, [](const QString &key, const QString &errorMessage) {
+        Q_UNUSED(key)
+        if (!errorMessage.isEmpty()) {
+            qCWarning(PlasmaSetupLanguageUtil) << "Failed to set system default language:" << errorMessage;
+        } else {
+            qCInfo(PlasmaSetupLanguageUtil) << "Successfully set system default language.";
+        }
+    });
+    connect(&m_systemSettings, &SystemSettingsCommitter::allCommitted, this, &LanguageUtil::systemSettingsCommitted);
+
+    m_applyTimer.setSingleShot(true);
+    m_applyTimer.setInterval(APPLY_LANGUAGE_DELAY);
+    connect(&m_applyTimer, &QTimer::timeout, this, &LanguageUtil::applyPendingLanguage);
 
-    m_languageModel.setStringList(m_availableLanguages);
     m_languageProxyModel.setSourceModel(&m_languageModel);
+    loadAvailableLanguages();
 
     m_currentLanguage = QLocale::system().name();
     qCInfo(PlasmaSetupLanguageUtil) << "System language detected as:" << m_currentLanguage;
@@ -38,6 +69,10 @@ QString LanguageUtil::languageFilter() const
 
 QAbstractItemModel *LanguageUtil::languageModel()
 {
+    if (m_languagesReleased) {
+        m_languagesReleased = false;
+        loadAvailableLanguages();
+    }
     return &m_languageProxyModel;
 }
 
@@ -72,6 +107,18 @@ void LanguageUtil::applyLanguage()
         return;
     }
 
+    m_applyTimer.start();
+}
+
+void LanguageUtil::applyPendingLanguage()
+{
+    m_applyTimer.stop();
+
+    if (m_currentLanguage.isEmpty() || m_currentLanguage == m_appliedLanguage) {
+        return;
+    }
+
+    m_appliedLanguage = m_currentLanguage;
     applyLanguageForCurrentSession();
     applyLanguageAsSystemDefault();
 
@@ -107,29 +154,91 @@ void LanguageUtil::applyLanguageAsSystemDefault()
     const bool interactive = false;
     message << QStringList{lang} << interactive;
 
-    QDBusPendingReply<> reply = QDBusConnection::systemBus().asyncCall(message);
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
-    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=]() {
+    // Written once the user leaves the page, see commitSystemSettings()
+    m_systemSettings.stage(LOCALE_SETTING, QStringList{lang}, message);
+}
+
+void LanguageUtil::commitSystemSettings()
+{
+    applyPendingLanguage();
+    m_systemSettings.commit();
+}
+
+void LanguageUtil::releaseResources()
+{
+    if (m_languagesReleased) {
+        return;
+    }
+
+    qCDebug(PlasmaSetupLanguageUtil) << "Releasing the language model of" << m_languages.size() << "languages";
+    setLanguageFilter(QString());
+    m_languageModel.setStringList({});
+    m_languageSearchIndex.build({});
+    m_languageProxyModel.setSearchIndex(&m_languageSearchIndex);
+    m_languages = {};
+    m_languagesReleased = true;
+}
+
+void LanguageUtil::loadAvailableLanguages()
+{
+    if (const auto catalog = LanguageCatalog::load(LanguageCatalog::path())) {
+        setLanguages(catalog->languages);
+        refreshAvailableLanguages(catalog->stamp);
+        return;
+    }
+
+    // Nothing to show until the languages have been found, so this first scan has to block.
+    // It only happens once, the catalog is kept across boots.
+    const LanguageCatalog::Catalog catalog = LanguageCatalog::scan();
+    setLanguages(catalog.languages);
+    LanguageCatalog::save(LanguageCatalog::path(), catalog);
+}
+
+void LanguageUtil::refreshAvailableLanguages(const QString &storedStamp)
+{
+    using Result = std::optional<LanguageCatalog::Catalog>;
+
+    auto watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+        const Result catalog = watcher->result();
         watcher->deleteLater();
 
-        if (watcher->isError()) {
-            qCWarning(PlasmaSetupLanguageUtil) << "Failed to set system default language:" << watcher->error().message();
-        } else {
-            qCInfo(PlasmaSetupLanguageUtil) << "Successfully set system default language.";
+        // The refreshed catalog was stored, it is what gets loaded if the model is needed again
+        if (!catalog || m_languagesReleased) {
+            return;
+        }
+
+        if (catalog->languages != m_languages) {
+            qCInfo(PlasmaSetupLanguageUtil) << "The available languages changed since the catalog was stored";
+            setLanguages(catalog->languages);
         }
     });
+    watcher->setFuture(QtConcurrent::run([storedStamp]() -> Result {
+        if (storedStamp == LanguageCatalog::localeDirectoriesStamp()) {
+            return std::nullopt;
+        }
+
+        qCDebug(PlasmaSetupLanguageUtil) << "Scanning the available languages";
+        LanguageCatalog::Catalog catalog = LanguageCatalog::scan();
+        LanguageCatalog::save(LanguageCatalog::path(), catalog);
+        return catalog;
+    }));
 }
 
-void LanguageUtil::loadAvailableLanguages()
+void LanguageUtil::setLanguages(const QList<LanguageEntry> &languages)
 {
-    m_availableLanguages = KLocalizedString::availableDomainTranslations("plasmashell").values();
+    m_languages = languages;
 
-    // Ensure we at least have English available
-    if (!m_availableLanguages.contains(QStringLiteral("en_US"))) {
-        m_availableLanguages.append(QStringLiteral("en_US"));
+    m_availableLanguages.clear();
+    m_availableLanguages.reserve(languages.size());
+    for (const LanguageEntry &language : languages) {
+        m_availableLanguages << language.code;
     }
 
-    m_availableLanguages.sort();
+    // The names are folded for matching once here, rather than on every search
+    m_languageSearchIndex.build(m_languages);
+    m_languageModel.setStringList(m_availableLanguages);
+    m_languageProxyModel.setSearchIndex(&m_languageSearchIndex);
 
     Q_EMIT availableLanguagesChanged();
 }
@@ -155,7 +264,8 @@ void LanguageUtil::overrideInitialLanguageIfNeeded()
         m_currentLanguage = QStringLiteral("en_US");
     }
 
-    applyLanguage();
+    // Nothing to wait for, the user has not picked anything yet
+    applyPendingLanguage();
 
     // Small delay because otherwise the QML side won't see the change and scroll to the new language.
     QTimer::singleShot(0, this, [this]() {
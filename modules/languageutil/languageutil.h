@@ -7,8 +7,12 @@
 #include <QObject>
 #include <QQmlEngine>
 #include <QStringListModel>
+#include <QTimer>
 
+#include "languagecatalog.h"
+#include "languagesearchindex.h"
 #include "languagesortfilterproxymodel.h"
+#include "systemsettingscommitter.h"
 
 /**
  * Handles language choice.
@@ -44,7 +48,7 @@ class LanguageUtil : public QObject
      * Search filter applied to the language model.
      *
      * Updating this value filters languages by their code, native name,
-     * or English name.
+     * or English name, ignoring case and diacritics. The best matches come first.
      */
     Q_PROPERTY(QString languageFilter READ languageFilter WRITE setLanguageFilter NOTIFY languageFilterChanged)
 
@@ -66,15 +70,46 @@ public:
 
     /**
      * Applies the chosen language.
+     *
+     * Switching the language retranslates the whole interface, so it is done shortly after the last
+     * call rather than right away. Picking several languages in a row only switches to the last one.
      */
     Q_INVOKABLE void applyLanguage();
 
+    /**
+     * Applies the chosen language right away if it has not been applied yet.
+     */
+    Q_INVOKABLE void applyPendingLanguage();
+
+    /**
+     * Applies the chosen language right away and writes it as the system default.
+     *
+     * Meant to be called when the user leaves the language page, so that only the language
+     * finally chosen is written to the system.
+     */
+    Q_INVOKABLE void commitSystemSettings();
+
+    /**
+     * Drops the language model and search index, e.g. once the language page is released.
+     *
+     * The available languages and the current language are kept. The model is rebuilt from the
+     * stored catalog the next time it is requested.
+     */
+    Q_INVOKABLE void releaseResources();
+
 Q_SIGNALS:
     void availableLanguagesChanged();
     void languageFilterChanged();
     void currentLanguageChanged();
     void initialLanguageOverrideApplied();
 
+    /**
+     * Emitted once the settings written by commitSystemSettings() have been written.
+     *
+     * @param errorMessages The errors of the writes that failed, empty if all succeeded.
+     */
+    void systemSettingsCommitted(const QStringList &errorMessages);
+
 private:
     /**
      * Applies the current language setting for the current user session.
@@ -86,6 +121,7 @@ private:
      *
      * Sets the selected language as the default for the entire system, so that
      * it will apply to new users, the login screen, and other system components.
+     * The change is staged, and written by commitSystemSettings().
      */
     void applyLanguageAsSystemDefault();
 
@@ -93,10 +129,27 @@ private:
      * Loads the available languages from the system.
      *
      * This function populates the availableLanguages list with the languages
-     * that are supported by Plasma.
+     * that are supported by Plasma, and builds the search index over them.
+     *
+     * The catalog stored by a previous run is used if there is one, and refreshed in the
+     * background if languages were installed or removed since. Otherwise the languages are
+     * scanned right away, which only happens on the first run.
      */
     void loadAvailableLanguages();
 
+    /**
+     * Scans the available languages in the background, replacing the ones shown if they changed.
+     *
+     * @param storedStamp The stamp of the stored catalog, the scan is skipped if the installed
+     * translations still match it.
+     */
+    void refreshAvailableLanguages(const QString &storedStamp);
+
+    /**
+     * Shows the given languages, rebuilding the model and search index.
+     */
+    void setLanguages(const QList<LanguageEntry> &languages);
+
     /**
      * Overrides the initial language if it is not available.
      *
@@ -109,8 +162,24 @@ private:
     void overrideInitialLanguageIfNeeded();
 
     QStringList m_availableLanguages;
+    QList<LanguageEntry> m_languages;
     QStringListModel m_languageModel;
+    LanguageSearchIndex m_languageSearchIndex;
     LanguageSortFilterProxyModel m_languageProxyModel;
     QString m_languageFilter;
     QString m_currentLanguage;
+
+    /**
+     * Whether the model and search index were dropped by releaseResources().
+     */
+    bool m_languagesReleased = false;
+
+    /**
+     * The language last applied to the session, empty if none was applied yet.
+     */
+    QString m_appliedLanguage;
+
+    QTimer m_applyTimer;
+
+    SystemSettingsCommitter m_systemSettings;
 };
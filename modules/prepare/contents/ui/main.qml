@@ -15,12 +15,35 @@ import org.kde.plasmasetup.components as PlasmaSetupComponents
 PlasmaSetupComponents.SetupModule {
     id: root
 
+    // The chosen theme and scaling are kept by PrepareUtil, which also reloads the outputs, see onPageActivated().
+    unloadable: true
+
     cardWidth: Math.min(Kirigami.Units.gridUnit * 30, root.contentItem.width - Kirigami.Units.gridUnit * 2)
 
     nextEnabled: true
 
+    function onPageActivated(): void {
+        Prepare.PrepareUtil.loadResources();
+    }
+
+    function onPageDeactivated(): void {
+        // Toggling the switch only previews the color scheme, apply the whole theme once
+        Prepare.PrepareUtil.applyTheme();
+    }
+
+    function onPageReleased(): void {
+        Prepare.PrepareUtil.releaseResources();
+    }
+
     contentItem: ColumnLayout {
 
+        // The scaling applies to the screen the wizard is shown on
+        Binding {
+            target: Prepare.PrepareUtil
+            property: "outputName"
+            value: root.contentItem.Window.window?.screen?.name ?? ""
+        }
+
         ColumnLayout {
             Layout.maximumWidth: root.cardWidth
             Layout.alignment: Qt.AlignCenter
@@ -1,4 +1,5 @@
 // SPDX-FileCopyrightText: 2023 by Devin Lin <devin@kde.org>
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "prepareutil.h"
@@ -10,33 +11,106 @@
 
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
-#include <QProcess>
+#include <QDebug>
+
+#include <utility>
 
 using namespace Qt::StringLiterals;
 
+namespace
+{
+const QString LIGHT_LOOK_AND_FEEL = u"org.kde.breeze.desktop"_s;
+const QString DARK_LOOK_AND_FEEL = u"org.kde.breezedark.desktop"_s;
+const QString LIGHT_COLOR_SCHEME = u"BreezeLight"_s;
+const QString DARK_COLOR_SCHEME = u"BreezeDark"_s;
+
+/**
+ * How long the scaling has to stay the same before it is applied, in milliseconds.
+ *
+ * Reconfiguring the outputs is expensive, so intermediate values while the user
+ * drags the scaling control are dropped.
+ */
+constexpr int APPLY_SCALING_DELAY = 250;
+}
+
 PrepareUtil::PrepareUtil(QObject *parent)
     : QObject{parent}
     , m_colorsSettings{new ColorsSettings(this)}
 {
+    m_scalingTimer.setSingleShot(true);
+    m_scalingTimer.setInterval(APPLY_SCALING_DELAY);
+    connect(&m_scalingTimer, &QTimer::timeout, this, &PrepareUtil::applyScaling);
+
+    loadConfig();
+
+    // set property initially
+    m_appliedColorScheme = m_colorsSettings->colorScheme();
+    m_usingDarkTheme = m_appliedColorScheme == DARK_COLOR_SCHEME;
+    m_appliedLookAndFeel = m_usingDarkTheme ? DARK_LOOK_AND_FEEL : LIGHT_LOOK_AND_FEEL;
+}
+
+PrepareUtil::~PrepareUtil()
+{
+    if (m_colorSchemeProcess) {
+        m_colorSchemeProcess->disconnect(this);
+        m_colorSchemeProcess->waitForFinished();
+    }
+    if (m_lookAndFeelProcess) {
+        m_lookAndFeelProcess->disconnect(this);
+        m_lookAndFeelProcess->waitForFinished();
+    }
+}
+
+void PrepareUtil::loadConfig()
+{
+    m_configReleased = false;
+    if (m_config || m_fetchingConfig) {
+        return;
+    }
+
+    m_fetchingConfig = true;
     connect(new KScreen::GetConfigOperation(), &KScreen::GetConfigOperation::finished, this, [this](auto *op) {
+        m_fetchingConfig = false;
+
+        // Released while it was being fetched
+        if (m_configReleased) {
+            return;
+        }
+
         m_config = qobject_cast<KScreen::GetConfigOperation *>(op)->config();
 
         if (!m_config) {
             return;
         }
 
-        const KScreen::OutputPtr primaryOutput = m_config->primaryOutput();
-        if (primaryOutput) {
-            m_scaling = primaryOutput->scale() * 100;
-        } else {
-            m_scaling = 100;
-        }
+        // Keeps m_config up to date, so it only has to be fetched again after releaseResources()
+        KScreen::ConfigMonitor::instance()->addConfig(m_config);
+        connect(KScreen::ConfigMonitor::instance(), &KScreen::ConfigMonitor::configurationChanged, this, &PrepareUtil::readScaling);
 
-        Q_EMIT scalingChanged();
+        readScaling();
     });
+}
 
-    // set property initially
-    m_usingDarkTheme = m_colorsSettings->colorScheme() == u"BreezeDark"_s;
+void PrepareUtil::releaseResources()
+{
+    // Keeping the output configuration, a scaling change is still being applied
+    if (m_scalingTimer.isActive() || m_setConfigOperation) {
+        return;
+    }
+
+    m_configReleased = true;
+    if (!m_config) {
+        return;
+    }
+
+    KScreen::ConfigMonitor::instance()->removeConfig(m_config);
+    disconnect(KScreen::ConfigMonitor::instance(), &KScreen::ConfigMonitor::configurationChanged, this, &PrepareUtil::readScaling);
+    m_config.reset();
+}
+
+void PrepareUtil::loadResources()
+{
+    loadConfig();
 }
 
 int PrepareUtil::scaling() const
@@ -45,26 +119,117 @@ int PrepareUtil::scaling() const
 }
 
 void PrepareUtil::setScaling(int scaling)
+{
+    if (!m_config || !scalingOutput() || m_scaling == scaling) {
+        return;
+    }
+
+    m_scaling = scaling;
+    Q_EMIT scalingChanged();
+
+    m_scalingTimer.start();
+}
+
+QString PrepareUtil::outputName() const
+{
+    return m_outputName;
+}
+
+void PrepareUtil::setOutputName(const QString &outputName)
+{
+    if (m_outputName == outputName) {
+        return;
+    }
+
+    // Apply a pending value to the output it was chosen for
+    if (m_scalingTimer.isActive()) {
+        m_scalingTimer.stop();
+        applyScaling();
+    }
+
+    m_outputName = outputName;
+    Q_EMIT outputNameChanged();
+
+    readScaling();
+}
+
+bool PrepareUtil::isApplyingScaling() const
+{
+    return m_setConfigOperation != nullptr;
+}
+
+KScreen::OutputPtr PrepareUtil::scalingOutput() const
 {
     if (!m_config) {
+        return {};
+    }
+
+    if (!m_outputName.isEmpty()) {
+        for (const KScreen::OutputPtr &output : m_config->outputs()) {
+            if (output->name() == m_outputName) {
+                return output;
+            }
+        }
+    }
+
+    return m_config->primaryOutput();
+}
+
+void PrepareUtil::readScaling()
+{
+    // Don't replace a value the user chose but which is not applied yet
+    if (m_scalingTimer.isActive() || m_setConfigOperation) {
         return;
     }
 
-    // TODO: Find the display the app is on and only set the scaling for that display instead.
-    // Setting for all displays is not ideal since they can have different densities.
-    const auto output = m_config->primaryOutput();
-    qreal scalingNum = ((double)scaling) / 100;
+    const KScreen::OutputPtr output = scalingOutput();
+    const int scaling = output ? qRound(output->scale() * 100) : 100;
+    if (m_scaling != scaling) {
+        m_scaling = scaling;
+        Q_EMIT scalingChanged();
+    }
+}
+
+void PrepareUtil::applyScaling()
+{
+    if (m_setConfigOperation) {
+        // Applied once the running operation is done, with the value chosen by then
+        m_scalingQueued = true;
+        return;
+    }
+
+    const KScreen::OutputPtr output = scalingOutput();
     if (!output) {
         return;
     }
 
-    output->setScale(scalingNum);
+    const qreal scale = m_scaling / 100.0;
+    if (qFuzzyCompare(output->scale(), scale)) {
+        return;
+    }
 
-    auto setop = new KScreen::SetConfigOperation(m_config, this);
-    setop->exec();
+    output->setScale(scale);
 
-    m_scaling = scaling;
-    Q_EMIT scalingChanged();
+    m_setConfigOperation = new KScreen::SetConfigOperation(m_config, this);
+    connect(m_setConfigOperation, &KScreen::ConfigOperation::finished, this, [this](KScreen::ConfigOperation *operation) {
+        m_setConfigOperation = nullptr;
+
+        const bool success = !operation->hasError();
+        if (!success) {
+            qWarning() << "Failed to apply the scaling:" << operation->errorString();
+        }
+
+        if (std::exchange(m_scalingQueued, false)) {
+            applyScaling();
+        }
+
+        if (!m_setConfigOperation) {
+            Q_EMIT applyingScalingChanged();
+            Q_EMIT scalingApplied(success);
+            readScaling();
+        }
+    });
+    Q_EMIT applyingScalingChanged();
 }
 
 QStringList PrepareUtil::scalingOptions()
@@ -91,15 +256,125 @@ bool PrepareUtil::usingDarkTheme() const
 
 void PrepareUtil::setUsingDarkTheme(bool usingDarkTheme)
 {
-    // use plasma-apply-lookandfeel since it has logic for notifying the shell of changes
-    if (usingDarkTheme) {
-        QProcess::execute(u"plasma-apply-lookandfeel"_s, {QStringLiteral("--apply"), QStringLiteral("org.kde.breezedark.desktop")});
-    } else {
-        QProcess::execute(u"plasma-apply-lookandfeel"_s, {QStringLiteral("--apply"), QStringLiteral("org.kde.breeze.desktop")});
+    if (m_usingDarkTheme == usingDarkTheme) {
+        return;
     }
 
+    previewColorScheme(usingDarkTheme);
+
     m_usingDarkTheme = usingDarkTheme;
     Q_EMIT usingDarkThemeChanged();
 }
 
+bool PrepareUtil::isApplyingTheme() const
+{
+    return m_lookAndFeelProcess != nullptr;
+}
+
+void PrepareUtil::applyTheme()
+{
+    applyLookAndFeel(m_usingDarkTheme ? DARK_LOOK_AND_FEEL : LIGHT_LOOK_AND_FEEL);
+}
+
+void PrepareUtil::previewColorScheme(bool usingDarkTheme)
+{
+    const QString colorScheme = usingDarkTheme ? DARK_COLOR_SCHEME : LIGHT_COLOR_SCHEME;
+
+    // Only the last scheme chosen while one is being applied is applied next
+    if (m_colorSchemeProcess) {
+        m_queuedColorScheme = colorScheme == m_appliedColorScheme ? QString() : colorScheme;
+        return;
+    }
+
+    m_appliedColorScheme = colorScheme;
+
+    // use plasma-apply-colorscheme since it writes the colors of the scheme, not just its name, and notifies applications
+    m_colorSchemeProcess = new QProcess(this);
+    connect(m_colorSchemeProcess, &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+        colorSchemeProcessFinished(exitStatus == QProcess::NormalExit && exitCode == 0);
+    });
+    connect(m_colorSchemeProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        // finished() is not emitted for a process that could not be started
+        if (error == QProcess::FailedToStart) {
+            colorSchemeProcessFinished(false);
+        }
+    });
+    m_colorSchemeProcess->start(u"plasma-apply-colorscheme"_s, {colorScheme});
+}
+
+void PrepareUtil::colorSchemeProcessFinished(bool success)
+{
+    m_colorSchemeProcess->deleteLater();
+    m_colorSchemeProcess = nullptr;
+
+    if (!success) {
+        qWarning() << "Failed to apply the color scheme" << m_appliedColorScheme;
+    }
+
+    if (!m_queuedColorScheme.isEmpty()) {
+        previewColorScheme(std::exchange(m_queuedColorScheme, QString()) == DARK_COLOR_SCHEME);
+    }
+}
+
+void PrepareUtil::applyLookAndFeel(const QString &package)
+{
+    if (m_lookAndFeelProcess) {
+        if (!m_cancellingLookAndFeel && package == m_appliedLookAndFeel) {
+            m_queuedLookAndFeel.clear();
+            return;
+        }
+
+        // The running process is cancelled, and the package applied once it is gone
+        m_queuedLookAndFeel = package;
+        if (!m_cancellingLookAndFeel) {
+            m_cancellingLookAndFeel = true;
+            m_lookAndFeelProcess->terminate();
+        }
+        return;
+    }
+
+    if (package == m_appliedLookAndFeel) {
+        return;
+    }
+
+    m_appliedLookAndFeel = package;
+
+    // use plasma-apply-lookandfeel since it has logic for notifying the shell of changes
+    m_lookAndFeelProcess = new QProcess(this);
+    connect(m_lookAndFeelProcess, &QProcess::finished, this, &PrepareUtil::lookAndFeelProcessFinished);
+    connect(m_lookAndFeelProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        // finished() is not emitted for a process that could not be started
+        if (error == QProcess::FailedToStart) {
+            lookAndFeelProcessFinished(-1, QProcess::CrashExit);
+        }
+    });
+    m_lookAndFeelProcess->start(u"plasma-apply-lookandfeel"_s, {u"--apply"_s, package});
+
+    Q_EMIT applyingThemeChanged();
+}
+
+void PrepareUtil::lookAndFeelProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_lookAndFeelProcess->deleteLater();
+    m_lookAndFeelProcess = nullptr;
+    m_cancellingLookAndFeel = false;
+
+    if (!m_queuedLookAndFeel.isEmpty()) {
+        // Superseded, don't report anything for the cancelled package, which may be half applied
+        m_appliedLookAndFeel.clear();
+        applyLookAndFeel(std::exchange(m_queuedLookAndFeel, QString()));
+        return;
+    }
+
+    const bool success = exitStatus == QProcess::NormalExit && exitCode == 0;
+    if (!success) {
+        qWarning() << "Failed to apply the look-and-feel package" << m_appliedLookAndFeel << "exit code:" << exitCode;
+        // Allow trying again
+        m_appliedLookAndFeel.clear();
+    }
+
+    Q_EMIT applyingThemeChanged();
+    Q_EMIT themeApplied(success);
+}
+
 #include "moc_prepareutil.cpp"
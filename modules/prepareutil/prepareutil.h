@@ -1,13 +1,17 @@
 // SPDX-FileCopyrightText: 2023 by Devin Lin <devin@kde.org>
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #pragma once
 
 #include <QDBusServiceWatcher>
 #include <QObject>
+#include <QProcess>
+#include <QTimer>
 #include <qqmlintegration.h>
 
 #include <kscreen/config.h>
+#include <kscreen/setconfigoperation.h>
 
 #include "colorssettings.h"
 
@@ -17,29 +21,189 @@ class PrepareUtil : public QObject
     QML_ELEMENT
     QML_SINGLETON
 
+    /**
+     * The scaling of the output the wizard is shown on, in percent.
+     *
+     * Changes are applied asynchronously once the value stopped changing for a moment,
+     * so only the last value of a quick succession of changes reconfigures the outputs.
+     */
     Q_PROPERTY(int scaling READ scaling WRITE setScaling NOTIFY scalingChanged)
+
+    /**
+     * The name of the output the scaling applies to, e.g. "eDP-1".
+     *
+     * Meant to be bound to the name of the screen the window is on. When empty or unknown,
+     * the primary output is used.
+     */
+    Q_PROPERTY(QString outputName READ outputName WRITE setOutputName NOTIFY outputNameChanged)
+
+    /**
+     * Whether a scaling change is being applied to the outputs.
+     */
+    Q_PROPERTY(bool applyingScaling READ isApplyingScaling NOTIFY applyingScalingChanged)
     Q_PROPERTY(QStringList scalingOptions READ scalingOptions CONSTANT)
     Q_PROPERTY(bool usingDarkTheme READ usingDarkTheme WRITE setUsingDarkTheme NOTIFY usingDarkThemeChanged)
 
+    /**
+     * Whether a look-and-feel package is being applied in the background.
+     */
+    Q_PROPERTY(bool applyingTheme READ isApplyingTheme NOTIFY applyingThemeChanged)
+
 public:
     explicit PrepareUtil(QObject *parent = nullptr);
 
+    /**
+     * Waits for the look-and-feel package being applied, so that it is not left half applied.
+     */
+    ~PrepareUtil() override;
+
     int scaling() const;
     void setScaling(int scaling);
 
     QStringList scalingOptions();
 
+    QString outputName() const;
+    void setOutputName(const QString &outputName);
+
+    bool isApplyingScaling() const;
+
     bool usingDarkTheme() const;
+
+    /**
+     * Switches between the light and dark theme.
+     *
+     * Only the color scheme is changed right away, which is enough to preview the theme.
+     * The matching look-and-feel package is applied by applyTheme().
+     */
     void setUsingDarkTheme(bool usingDarkTheme);
 
+    bool isApplyingTheme() const;
+
+    /**
+     * Applies the look-and-feel package of the chosen theme in the background.
+     *
+     * Does nothing if it is already applied. If another package is still being applied,
+     * that one is cancelled in favour of the chosen theme.
+     *
+     * Meant to be called when the user leaves the page, so that toggling the theme does
+     * not apply a full look-and-feel package every time.
+     */
+    Q_INVOKABLE void applyTheme();
+
+    /**
+     * Stops following the configuration of the outputs and drops it, e.g. once the page is released.
+     *
+     * Does nothing while a scaling change is still pending or being applied, so it is not lost.
+     */
+    Q_INVOKABLE void releaseResources();
+
+    /**
+     * Fetches the configuration of the outputs again after releaseResources().
+     *
+     * Does nothing if it is already available or being fetched.
+     */
+    Q_INVOKABLE void loadResources();
+
 Q_SIGNALS:
     void scalingChanged();
+    void outputNameChanged();
+    void applyingScalingChanged();
+
+    /**
+     * Emitted once the latest scaling change has been applied to the outputs.
+     *
+     * @param success Whether the outputs were reconfigured.
+     */
+    void scalingApplied(bool success);
     void usingDarkThemeChanged();
+    void applyingThemeChanged();
+
+    /**
+     * Emitted once the look-and-feel package requested by applyTheme() has been applied.
+     *
+     * Not emitted for packages cancelled by a later call to applyTheme().
+     *
+     * @param success Whether plasma-apply-lookandfeel succeeded.
+     */
+    void themeApplied(bool success);
 
 private:
-    int m_scaling;
+    /**
+     * Fetches the configuration of the outputs and keeps it up to date, unless it is already there.
+     */
+    void loadConfig();
+
+    /**
+     * The output the scaling applies to, see outputName.
+     */
+    KScreen::OutputPtr scalingOutput() const;
+
+    /**
+     * Updates scaling from the output it applies to, unless a change is still pending.
+     */
+    void readScaling();
+
+    /**
+     * Applies scaling to its output, or queues it while another change is being applied.
+     */
+    void applyScaling();
+
+    /**
+     * Switches the color scheme of the session, without touching the rest of the look-and-feel.
+     *
+     * Runs plasma-apply-colorscheme in the background, a scheme chosen while another one is
+     * being applied is applied once it is done.
+     */
+    void previewColorScheme(bool usingDarkTheme);
+
+    void colorSchemeProcessFinished(bool success);
+
+    /**
+     * Starts plasma-apply-lookandfeel for the given package, or queues it if another one is running.
+     */
+    void applyLookAndFeel(const QString &package);
+
+    void lookAndFeelProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+    int m_scaling = 100;
     bool m_usingDarkTheme;
 
-    ColorsSettings *m_colorsSettings;
+    QString m_outputName;
+
+    /** Delays applying the scaling until it stopped changing. */
+    QTimer m_scalingTimer;
+
+    /** The operation applying the scaling, if any. */
+    KScreen::SetConfigOperation *m_setConfigOperation = nullptr;
+
+    /** Whether the scaling changed again while m_setConfigOperation was running. */
+    bool m_scalingQueued = false;
+
+    /** The look-and-feel package last applied, or being applied. */
+    QString m_appliedLookAndFeel;
+
+    /** The look-and-feel package to apply once the running process is done. */
+    QString m_queuedLookAndFeel;
+
+    QProcess *m_lookAndFeelProcess = nullptr;
+
+    /** Whether the running process has been asked to stop in favour of m_queuedLookAndFeel. */
+    bool m_cancellingLookAndFeel = false;
+
+    QProcess *m_colorSchemeProcess = nullptr;
+
+    /** The color scheme last applied, or being applied by m_colorSchemeProcess. */
+    QString m_appliedColorScheme;
+
+    /** The color scheme to apply once m_colorSchemeProcess is done. */
+    QString m_queuedColorScheme;
+
+        ColorsSettings *m_colorsSettings;
     KScreen::ConfigPtr m_config;
+
+    /** Whether the configuration of the outputs is being fetched. */
+    bool m_fetchingConfig = false;
+
+    /** Whether releaseResources() was called since the configuration was last requested. */
+    bool m_configReleased = false;
 };
@@ -16,6 +16,13 @@ import org.kde.plasmasetup.components as PlasmaSetupComponents
 PlasmaSetupComponents.SetupModule {
     id: root
 
+    // The chosen time zone is kept by TimeUtil, the selector starts from it again.
+    unloadable: true
+
+    function onPageDeactivated(): void {
+        Time.TimeUtil.commitSystemSettings();
+    }
+
     contentItem: ColumnLayout {
         id: mainColumn
         spacing: Kirigami.Units.gridUnit
@@ -7,31 +7,71 @@
 
 #include "timedate_interface.h"
 
-#include <QDBusPendingCallWatcher>
+#include <QDebug>
 #include <QTimeZone>
 
 using namespace Qt::StringLiterals;
 
+/**
+ * The key of the timezone in the committed system settings.
+ */
+const QString TIMEZONE_SETTING = u"timezone"_s;
+
 TimeUtil::TimeUtil(QObject *parent)
     : QObject{parent}
     , m_dbusInterface(new OrgFreedesktopTimedate1Interface(u"org.freedesktop.timedate1"_s, u"/org/freedesktop/timedate1"_s, QDBusConnection::systemBus(), this))
+    , m_timedate1(m_dbusInterface->service(), m_dbusInterface->path(), m_dbusInterface->interface(), QDBusConnection::systemBus())
+    , m_systemSettings(QDBusConnection::systemBus())
 {
+    // Good enough until timedated answers, and the page never shows an empty selection
+    m_systemSettings.setCurrentValue(TIMEZONE_SETTING, QString::fromUtf8(QTimeZone::systemTimeZoneId()));
+    connect(&m_timedate1, &SystemPropertyCache::loaded, this, &TimeUtil::readSystemTimeZone);
+    connect(&m_timedate1, &SystemPropertyCache::propertiesChanged, this, &TimeUtil::readSystemTimeZone);
+    connect(&m_systemSettings, &SystemSettingsCommitter::committed, this, [](const QString &key, const QString &errorMessage) {
+        Q_UNUSED(key)
+        if (!errorMessage.isEmpty()) {
+            qWarning() << "Failed to set the system timezone:" << errorMessage;
+        }
+    });
+    connect(&m_systemSettings, &SystemSettingsCommitter::allCommitted, this, &TimeUtil::systemSettingsCommitted);
 }
 
 QString TimeUtil::currentTimeZone() const
 {
-    return QString::fromUtf8(QTimeZone::systemTimeZoneId());
+    return m_systemSettings.value(TIMEZONE_SETTING).toString();
 }
 
 void TimeUtil::setCurrentTimeZone(const QString &timeZone)
 {
-    auto reply = m_dbusInterface->SetTimezone(timeZone, false);
-    auto watcher = new QDBusPendingCallWatcher(reply, nullptr);
-    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, reply]() {
-        if (reply.isValid()) {
-            Q_EMIT currentTimeZoneChanged();
-        }
-    });
+    if (timeZone.isEmpty() || timeZone == currentTimeZone()) {
+        return;
+    }
+
+    QDBusMessage message = QDBusMessage::createMethodCall(m_dbusInterface->service(), m_dbusInterface->path(), m_dbusInterface->interface(), u"SetTimezone"_s);
+    const bool interactive = false;
+    message << timeZone << interactive;
+    m_systemSettings.stage(TIMEZONE_SETTING, timeZone, message);
+
+    Q_EMIT currentTimeZoneChanged();
+}
+
+void TimeUtil::commitSystemSettings()
+{
+    m_systemSettings.commit();
+}
+
+void TimeUtil::readSystemTimeZone()
+{
+    const QString timeZone = m_timedate1.value(u"Timezone"_s).toString();
+    if (timeZone.isEmpty()) {
+        return;
+    }
+
+    const QString previousTimeZone = currentTimeZone();
+    m_systemSettings.setCurrentValue(TIMEZONE_SETTING, timeZone);
+    if (currentTimeZone() != previousTimeZone) {
+        Q_EMIT currentTimeZoneChanged();
+    }
 }
 
 #include "moc_timeutil.cpp"
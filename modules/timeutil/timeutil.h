@@ -9,6 +9,9 @@
 
 #include <qqmlregistration.h>
 
+#include "systempropertycache.h"
+#include "systemsettingscommitter.h"
+
 class OrgFreedesktopTimedate1Interface;
 
 /**
@@ -29,7 +32,7 @@ class TimeUtil : public QObject
      * The current system timezone identifier.
      *
      * This property holds the IANA timezone identifier (e.g., "America/New_York")
-     * for the system's current timezone.
+     * for the system's current timezone, or the one chosen to replace it.
      */
     Q_PROPERTY(QString currentTimeZone READ currentTimeZone WRITE setCurrentTimeZone NOTIFY currentTimeZoneChanged)
 
@@ -46,17 +49,39 @@ public:
     /**
      * Sets the system timezone.
      *
+     * The change is staged, and written to the system by commitSystemSettings().
+     *
      * @param timeZone The IANA timezone identifier to set (e.g., "Europe/London").
      */
     void setCurrentTimeZone(const QString &timeZone);
 
+    /**
+     * Writes the chosen timezone to the system.
+     *
+     * Meant to be called when the user leaves the time zone page, so that only the timezone
+     * finally chosen is written.
+     */
+    Q_INVOKABLE void commitSystemSettings();
+
 Q_SIGNALS:
     /**
-     * Emitted when the system timezone has been successfully changed.
+     * Emitted when a different timezone has been chosen.
      */
     void currentTimeZoneChanged();
 
+    /**
+     * Emitted once the settings written by commitSystemSettings() have been written.
+     *
+     * @param errorMessages The errors of the writes that failed, empty if all succeeded.
+     */
+    void systemSettingsCommitted(const QStringList &errorMessages);
+
 private:
+    /**
+     * Reads the timezone from the cached timedated properties.
+     */
+    void readSystemTimeZone();
+
     /**
      * D-Bus interface for communicating with the freedesktop.org timedate1 service.
      *
@@ -64,4 +89,9 @@ private:
      * through the org.freedesktop.timedate1 D-Bus service.
      */
     OrgFreedesktopTimedate1Interface *const m_dbusInterface;
+
+    /** The properties of org.freedesktop.timedate1. */
+    SystemPropertyCache m_timedate1;
+
+    SystemSettingsCommitter m_systemSettings;
 };
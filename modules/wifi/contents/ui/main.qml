@@ -12,10 +12,14 @@ import org.kde.kirigami as Kirigami
 import org.kde.plasma.networkmanagement as PlasmaNM
 
 import org.kde.plasmasetup.components as PlasmaSetupComponents
+import org.kde.plasmasetup.wifiutil as WifiUtil
 
 PlasmaSetupComponents.SetupModule {
     id: root
 
+    // The networks and saved connections are NetworkManager's, a recreated page lists them again.
+    unloadable: true
+
     available: availableDevices.wirelessDeviceAvailable
 
     contentItem: ColumnLayout {
@@ -43,6 +47,12 @@ PlasmaSetupComponents.SetupModule {
             showSavedMode: false
         }
 
+        // Coalesces the scan updates, the lists below never use the models above directly
+        WifiUtil.WifiNetworkModel {
+            id: wifiNetworkModel
+            sourceModel: mobileProxyModel
+        }
+
         ConnectDialog {
             id: connectionDialog
             handler: handler
@@ -72,13 +82,15 @@ PlasmaSetupComponents.SetupModule {
 
                 wrapMode: Text.Wrap
                 horizontalAlignment: Text.AlignHCenter
-                text: i18n("Connect to a WiFi network for network access.")
+                text: wifiNetworkModel.connectedNetwork.length > 0
+                    ? i18nc("%1 is the name of a WiFi network", "Connected to %1.", wifiNetworkModel.connectedNetwork)
+                    : i18n("Connect to a WiFi network for network access.")
             }
 
             ScrollView {
                 id: savedCard
                 Layout.fillWidth: true
-                visible: enabledConnections.wirelessEnabled && count > 0
+                visible: enabledConnections.wirelessEnabled && wifiNetworkModel.knownCount > 0
 
                 Component.onCompleted: {
                     if (background) {
@@ -86,18 +98,6 @@ PlasmaSetupComponents.SetupModule {
                     }
                 }
 
-                // number of visible entries
-                property int count: 0
-                function updateCount() {
-                    count = 0;
-                    for (let i = 0; i < connectedRepeater.count; i++) {
-                        let item = connectedRepeater.itemAt(i);
-                        if (item && item.shouldDisplay) {
-                            count++;
-                        }
-                    }
-                }
-
                 ColumnLayout {
                     id: column
 
@@ -105,14 +105,10 @@ PlasmaSetupComponents.SetupModule {
 
                     Repeater {
                         id: connectedRepeater
-                        model: mobileProxyModel
+                        model: wifiNetworkModel
                         delegate: ConnectionItemDelegate {
                             // connected or saved
-                            property bool shouldDisplay: (Uuid != "") || ConnectionState === PlasmaNM.Enums.Activated
-                            onShouldDisplayChanged: savedCard.updateCount()
-
-                            // separate property for visible since visible is false when the whole card is not visible
-                            visible: (Uuid != "") || ConnectionState === PlasmaNM.Enums.Activated
+                            visible: Known
 
                             Layout.fillWidth: true
 
@@ -135,12 +131,12 @@ PlasmaSetupComponents.SetupModule {
 
                 ListView {
                     clip: true
-                    model: mobileProxyModel
+                    model: wifiNetworkModel
 
                     delegate: ConnectionItemDelegate {
                         width: ListView.view.width
                         height: visible ? implicitHeight : 0
-                        visible: !((Uuid != "") || ConnectionState === PlasmaNM.Enums.Activated)
+                        visible: !Known
 
                         onClicked: {
                             changeState()
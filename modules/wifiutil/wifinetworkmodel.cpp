@@ -0,0 +1,252 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "wifinetworkmodel.h"
+
+#include <QSet>
+
+#include <algorithm>
+#include <tuple>
+
+namespace
+{
+/**
+ * How often the changes of the source model are applied, in milliseconds.
+ */
+constexpr int UPDATE_INTERVAL_MS = 1000;
+
+/**
+ * The value of the ConnectionState role of a connected network, NetworkManager::ActiveConnection::Activated.
+ */
+constexpr int CONNECTION_STATE_ACTIVATED = 2;
+}
+
+WifiNetworkModel::WifiNetworkModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UPDATE_INTERVAL_MS);
+    connect(&m_updateTimer, &QTimer::timeout, this, &WifiNetworkModel::update);
+}
+
+QAbstractItemModel *WifiNetworkModel::sourceModel() const
+{
+    return m_sourceModel;
+}
+
+void WifiNetworkModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (m_sourceModel == sourceModel) {
+        return;
+    }
+
+    if (m_sourceModel) {
+        disconnect(m_sourceModel, nullptr, this, nullptr);
+    }
+
+    beginResetModel();
+    m_sourceModel = sourceModel;
+    m_networks.clear();
+    readRoles();
+    endResetModel();
+
+    if (m_sourceModel) {
+        connect(m_sourceModel, &QAbstractItemModel::dataChanged, this, &WifiNetworkModel::scheduleUpdate);
+        connect(m_sourceModel, &QAbstractItemModel::rowsInserted, this, &WifiNetworkModel::scheduleUpdate);
+        connect(m_sourceModel, &QAbstractItemModel::rowsRemoved, this, &WifiNetworkModel::scheduleUpdate);
+        connect(m_sourceModel, &QAbstractItemModel::rowsMoved, this, &WifiNetworkModel::scheduleUpdate);
+        connect(m_sourceModel, &QAbstractItemModel::layoutChanged, this, &WifiNetworkModel::scheduleUpdate);
+        connect(m_sourceModel, &QAbstractItemModel::modelReset, this, &WifiNetworkModel::scheduleUpdate);
+    }
+
+    // Show what is already known right away, only later changes wait for the interval
+    m_updateTimer.stop();
+    update();
+    Q_EMIT sourceModelChanged();
+}
+
+QString WifiNetworkModel::connectedNetwork() const
+{
+    return m_connectedNetwork;
+}
+
+int WifiNetworkModel::knownCount() const
+{
+    return m_knownCount;
+}
+
+int WifiNetworkModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_networks.size();
+}
+
+QVariant WifiNetworkModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return QVariant();
+    }
+
+    const Network &network = m_networks.at(index.row());
+    if (role == m_knownRole) {
+        return network.known;
+    }
+    return network.values.value(role);
+}
+
+QHash<int, QByteArray> WifiNetworkModel::roleNames() const
+{
+    return m_roleNames;
+}
+
+void WifiNetworkModel::scheduleUpdate()
+{
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void WifiNetworkModel::readRoles()
+{
+    m_roleNames = m_sourceModel ? m_sourceModel->roleNames() : QHash<int, QByteArray>();
+
+    const auto roleFor = [this](const QByteArray &name) {
+        return m_roleNames.key(name, -1);
+    };
+    m_nameRole = roleFor(QByteArrayLiteral("ItemUniqueName"));
+    m_ssidRole = roleFor(QByteArrayLiteral("Ssid"));
+    m_uuidRole = roleFor(QByteArrayLiteral("Uuid"));
+    m_connectionStateRole = roleFor(QByteArrayLiteral("ConnectionState"));
+    m_signalRole = roleFor(QByteArrayLiteral("Signal"));
+
+    const QList<int> roles = m_roleNames.keys();
+    m_knownRole = roles.isEmpty() ? Qt::UserRole : std::max(*std::ranges::max_element(roles) + 1, int(Qt::UserRole));
+    m_roleNames.insert(m_knownRole, QByteArrayLiteral("Known"));
+}
+
+QList<WifiNetworkModel::Network> WifiNetworkModel::readNetworks() const
+{
+    QList<Network> networks;
+    if (!m_sourceModel) {
+        return networks;
+    }
+
+    // The position of each network name in the list
+    QHash<QString, qsizetype> positions;
+
+    const int rows = m_sourceModel->rowCount();
+    for (int row = 0; row < rows; ++row) {
+        const QModelIndex index = m_sourceModel->index(row, 0);
+
+        Network network;
+        for (auto it = m_roleNames.cbegin(); it != m_roleNames.cend(); ++it) {
+            if (it.key() != m_knownRole) {
+                network.values.insert(it.key(), index.data(it.key()));
+            }
+        }
+
+        network.key = network.values.value(m_ssidRole).toString();
+        if (network.key.isEmpty()) {
+            network.key = network.values.value(m_nameRole).toString();
+        }
+        network.connected = network.values.value(m_connectionStateRole).toInt() == CONNECTION_STATE_ACTIVATED;
+        network.known = network.connected || !network.values.value(m_uuidRole).toString().isEmpty();
+        network.signal = network.values.value(m_signalRole).toInt();
+
+        // Of the access points of a network, prefer the one connected to, then a saved one, then the strongest
+        const auto position = positions.constFind(network.key);
+        if (position == positions.cend()) {
+            positions.insert(network.key, networks.size());
+            networks.append(std::move(network));
+            continue;
+        }
+
+        Network &existing = networks[*position];
+        if (std::tuple(network.connected, network.known, network.signal) > std::tuple(existing.connected, existing.known, existing.signal)) {
+            existing = std::move(network);
+        }
+    }
+
+    return networks;
+}
+
+void WifiNetworkModel::update()
+{
+    QList<Network> networks = readNetworks();
+
+    QSet<QString> keys;
+    keys.reserve(networks.size());
+    for (const Network &network : std::as_const(networks)) {
+        keys.insert(network.key);
+    }
+
+    // Remove the networks no longer in range, from the end so the rows stay valid
+    for (qsizetype row = m_networks.size() - 1; row >= 0; --row) {
+        if (!keys.contains(m_networks.at(row).key)) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_networks.removeAt(row);
+            endRemoveRows();
+        }
+    }
+
+    // Bring the remaining networks into the order of the source model, moving rows rather than
+    // recreating them, and add the networks that came into range where they belong
+    for (qsizetype row = 0; row < networks.size(); ++row) {
+        Network &updated = networks[row];
+
+        const auto shown = std::find_if(m_networks.cbegin() + row, m_networks.cend(), [&updated](const Network &network) {
+            return network.key == updated.key;
+        });
+        if (shown == m_networks.cend()) {
+            beginInsertRows(QModelIndex(), row, row);
+            m_networks.insert(row, std::move(updated));
+            endInsertRows();
+            continue;
+        }
+
+        const qsizetype shownRow = shown - m_networks.cbegin();
+        if (shownRow != row) {
+            beginMoveRows(QModelIndex(), shownRow, shownRow, QModelIndex(), row);
+            m_networks.move(shownRow, row);
+            endMoveRows();
+        }
+
+        // Update the network in place
+        Network &network = m_networks[row];
+        QList<int> changedRoles;
+        for (auto it = updated.values.cbegin(); it != updated.values.cend(); ++it) {
+            if (network.values.value(it.key()) != it.value()) {
+                changedRoles.append(it.key());
+            }
+        }
+        if (network.known != updated.known) {
+            changedRoles.append(m_knownRole);
+        }
+
+        network = std::move(updated);
+        if (!changedRoles.isEmpty()) {
+            const QModelIndex index = this->index(row);
+            Q_EMIT dataChanged(index, index, changedRoles);
+        }
+    }
+
+    QString connectedNetwork;
+    int knownCount = 0;
+    for (const Network &network : std::as_const(m_networks)) {
+        if (network.connected && connectedNetwork.isEmpty()) {
+            connectedNetwork = network.values.value(m_nameRole).toString();
+        }
+        knownCount += network.known ? 1 : 0;
+    }
+
+    if (m_connectedNetwork != connectedNetwork) {
+        m_connectedNetwork = connectedNetwork;
+        Q_EMIT connectedNetworkChanged();
+    }
+    if (m_knownCount != knownCount) {
+        m_knownCount = knownCount;
+        Q_EMIT knownCountChanged();
+    }
+}
+
+#include "moc_wifinetworkmodel.cpp"
@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <qqmlintegration.h>
+
+/**
+ * The wireless networks shown on the WiFi page, one per network name.
+ *
+ * Wraps the model of plasma-nm, whose rows change with every scan of NetworkManager. Changes
+ * of the source model are applied at most once per update interval, so a busy radio environment
+ * does not relayout the page continuously. Networks seen through several access points are shown
+ * once. The rows follow the order of the source model: a network staying in range keeps its
+ * row and is moved when the order changes, changes of e.g. its signal strength only update the
+ * row, and networks appearing are inserted where they belong.
+ *
+ * The roles are those of the source model, so the delegates work with either. The "Known"
+ * role tells whether a network is saved or connected.
+ */
+class WifiNetworkModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    /**
+     * The model of plasma-nm listing the networks, usually a PlasmaNM.MobileProxyModel.
+     */
+    Q_PROPERTY(QAbstractItemModel *sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+
+    /**
+     * The name of the network currently connected to, or an empty string.
+     */
+    Q_PROPERTY(QString connectedNetwork READ connectedNetwork NOTIFY connectedNetworkChanged)
+
+    /**
+     * The number of networks that are saved or connected.
+     */
+    Q_PROPERTY(int knownCount READ knownCount NOTIFY knownCountChanged)
+
+public:
+    explicit WifiNetworkModel(QObject *parent = nullptr);
+
+    QAbstractItemModel *sourceModel() const;
+    void setSourceModel(QAbstractItemModel *sourceModel);
+
+    QString connectedNetwork() const;
+    int knownCount() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+Q_SIGNALS:
+    void sourceModelChanged();
+    void connectedNetworkChanged();
+    void knownCountChanged();
+
+private:
+    struct Network {
+        /** Identifies the network across updates, its name. */
+        QString key;
+
+        /** The values of the roles, as read from the source model. */
+        QHash<int, QVariant> values;
+
+        bool connected = false;
+        bool known = false;
+        int signal = 0;
+    };
+
+    /**
+     * Applies the changes of the source model once the update interval elapsed.
+     */
+    void scheduleUpdate();
+
+    /**
+     * Brings the rows in line with the source model.
+     */
+    void update();
+
+    /**
+     * Reads the networks from the source model, keeping the best row of each network name.
+     */
+    QList<Network> readNetworks() const;
+
+    /**
+     * Looks up the roles of the source model the model relies on.
+     */
+    void readRoles();
+
+    QPointer<QAbstractItemModel> m_sourceModel;
+    QList<Network> m_networks;
+
+    /** The roles of the source model, along with the Known role. */
+    QHash<int, QByteArray> m_roleNames;
+
+    int m_knownRole = -1;
+    int m_nameRole = -1;
+    int m_ssidRole = -1;
+    int m_uuidRole = -1;
+    int m_connectionStateRole = -1;
+    int m_signalRole = -1;
+
+    QString m_connectedNetwork;
+    int m_knownCount = 0;
+
+    QTimer m_updateTimer;
+};
@@ -7,55 +7,25 @@
 #include "accountcontroller.h"
 
 #include "config-plasma-setup.h"
+#include "existinguserdetection.h"
 #include "plasmasetup_debug.h"
+#include "systemconfig.h"
 #include "usernamevalidator.h"
 
 #include <KAuth/Action>
 #include <KAuth/ExecuteJob>
-#include <KConfig>
-#include <KConfigGroup>
 #include <KLocalizedString>
 
 #include <QApplication>
-#include <QFile>
+#include <QFutureWatcher>
+#include <QRegularExpression>
 #include <QVariantMap>
-
-#include <pwd.h>
-
-/**
- * @brief Minimum UID for user accounts
- *
- * This value represents the absolute lowest user ID value possible.
- */
-constexpr int MINIMUM_USER_ID = 0;
-/**
- * @brief Maximum UID for local user accounts
- *
- * This value represents the typical highest user ID value possible for
- * local UNIX user accounts.
- */
-constexpr int MAXIMUM_USER_ID = 65535;
-/**
- * @brief Default minimum UID for regular user accounts
- *
- * This value is used as a fallback when LOGIN_DEFS_PATH cannot be read
- * or does not contain a valid UID_MIN setting. UIDs below this threshold
- * are typically reserved for system accounts.
- */
-constexpr int DEFAULT_MIN_REGULAR_USER_ID = 1000;
-/**
- * @brief Default maximum UID for regular user accounts
- *
- * This value is used as a fallback when LOGIN_DEFS_PATH cannot be read
- * or does not contain a valid UID_MAX setting. UIDs above this threshold
- * are typically reserved for dynamic accounts.
- */
-constexpr int DEFAULT_MAX_REGULAR_USER_ID = 65000;
+#include <QtConcurrentRun>
 
 AccountController::AccountController(QObject *parent)
     : QObject(parent)
 {
-    initializeExistingUserFlag();
+    detectExistingUsers();
 }
 
 AccountController::~AccountController() = default;
@@ -113,6 +83,11 @@ void AccountController::setFullName(const QString &fullName)
 }
 
 bool AccountController::createUser()
+{
+    return createUserJob()->exec();
+}
+
+KAuth::ExecuteJob *AccountController::createUserJob()
 {
     qCInfo(PlasmaSetup) << "Creating user" << m_username << "with full name" << m_fullName;
 
@@ -122,26 +97,82 @@ bool AccountController::createUser()
     KAuth::Action action(QStringLiteral("org.kde.plasmasetup.createuser"));
     action.setParentWindow(window);
     action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
-    action.setArguments({
+    QVariantMap arguments = SystemConfig::instance().helperArguments();
+    arguments.insert({
         {QStringLiteral("username"), m_username},
         {QStringLiteral("fullName"), m_fullName},
         {QStringLiteral("password"), m_password},
-        {QStringLiteral("extraGroups"), userGroupsFromConfig()},
+        {QStringLiteral("extraGroups"), extraGroups()},
     });
+    action.setArguments(arguments);
 
     KAuth::ExecuteJob *job = action.execute();
-    if (!job->exec()) {
-        const QString errorMessage =
-            job->errorString().isEmpty() ? QStringLiteral("Authorization or helper failure (code %1)").arg(job->error()) : job->errorString();
-        qCWarning(PlasmaSetup) << "Failed to create user:" << errorMessage;
-        return false;
+    connect(job, &KJob::result, this, [job]() {
+        if (job->error()) {
+            const QString errorMessage =
+                job->errorString().isEmpty() ? QStringLiteral("Authorization or helper failure (code %1)").arg(job->error()) : job->errorString();
+            qCWarning(PlasmaSetup) << "Failed to create user:" << errorMessage;
+            return;
+        }
+
+        const QVariantMap userData = job->data();
+        qCInfo(PlasmaSetup) << "User created successfully. UID:" << userData.value(QStringLiteral("uid")).toLongLong()
+                            << "Home:" << userData.value(QStringLiteral("homePath")).toString();
+    });
+
+    return job;
+}
+
+QVariantMap AccountController::preparationArguments() const
+{
+    QVariantMap arguments = SystemConfig::instance().helperArguments();
+    arguments.insert({
+        {QStringLiteral("username"), m_username},
+        {QStringLiteral("extraGroups"), extraGroups()},
+    });
+    return arguments;
+}
+
+KAuth::ExecuteJob *AccountController::provisionUserJob(const QStringList &operations)
+{
+    qCInfo(PlasmaSetup) << "Provisioning user" << m_username << "with operations" << operations;
+
+    QList<QWindow *> topLevelWindows = QGuiApplication::topLevelWindows();
+    QWindow *window = topLevelWindows.isEmpty() ? nullptr : topLevelWindows.first();
+
+    QVariantMap arguments = SystemConfig::instance().helperArguments();
+    arguments.insert({
+        {QStringLiteral("username"), m_username},
+        {QStringLiteral("operations"), operations},
+    });
+    if (operations.contains(QStringLiteral("createuser"))) {
+        arguments.insert(QStringLiteral("fullName"), m_fullName);
+        arguments.insert(QStringLiteral("password"), m_password);
+        arguments.insert(QStringLiteral("extraGroups"), extraGroups());
     }
 
-    const QVariantMap userData = job->data();
-    qCInfo(PlasmaSetup) << "User created successfully. UID:" << userData.value(QStringLiteral("uid")).toLongLong()
-                        << "Home:" << userData.value(QStringLiteral("homePath")).toString();
+    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.provisionuser"));
+    action.setParentWindow(window);
+    action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
+    action.setArguments(arguments);
 
-    return true;
+    KAuth::ExecuteJob *job = action.execute();
+    connect(job, &KJob::result, this, [job]() {
+        const QVariantMap data = job->data();
+        const QStringList completedOperations = data.value(QStringLiteral("completedOperations")).toStringList();
+        if (job->error()) {
+            qCWarning(PlasmaSetup) << "Failed to provision user:" << job->errorString() << "completed operations:" << completedOperations;
+            return;
+        }
+
+        const QVariantMap userData = data.value(QStringLiteral("results")).toMap().value(QStringLiteral("createuser")).toMap();
+        qCInfo(PlasmaSetup) << "User provisioned successfully. Completed operations:" << completedOperations;
+        if (!userData.isEmpty()) {
+            qCInfo(PlasmaSetup) << "UID:" << userData.value(QStringLiteral("uid")).toLongLong() << "Home:" << userData.value(QStringLiteral("homePath")).toString();
+        }
+    });
+
+    return job;
 }
 
 QString AccountController::password() const
@@ -155,9 +186,20 @@ void AccountController::setPassword(const QString &password)
     Q_EMIT passwordChanged();
 }
 
+QStringList AccountController::extraGroups() const
+{
+    return m_extraGroups.value_or(SystemConfig::instance().userGroups());
+}
+
+void AccountController::setExtraGroups(const QStringList &extraGroups)
+{
+    qCInfo(PlasmaSetup) << "Setting extra groups to" << extraGroups;
+    m_extraGroups = extraGroups;
+}
+
 bool AccountController::isUsernameValid(const QString &username) const
 {
-    return PlasmaSetupValidation::Account::isUsernameValid(username);
+    return m_usernameValidation.result(username) == PlasmaSetupValidation::Account::UsernameValidationResult::Valid;
 }
 
 QString AccountController::sanitizeUsername(const QString &username) const
@@ -179,142 +221,113 @@ QString AccountController::sanitizeUsername(const QString &username) const
 
 QString AccountController::usernameValidationMessage(const QString &username) const
 {
-    const auto result = PlasmaSetupValidation::Account::validateUsername(username);
-
-    return PlasmaSetupValidation::Account::usernameValidationMessage(result);
+    return m_usernameValidation.message(username);
 }
 
-QStringList AccountController::userGroupsFromConfig() const
+bool AccountController::hasExistingUsers() const
 {
-    QStringList parsedGroups;
-
-    const QString configPath = QString::fromUtf8(PLASMA_SETUP_CONFIG_PATH);
-    if (!configPath.isEmpty()) {
-        KConfig config(configPath, KConfig::SimpleConfig);
-        KConfigGroup accountsGroup(&config, QStringLiteral("Accounts"));
-        const QString configuredGroups = accountsGroup.readEntry(QStringLiteral("UserGroups"), QString());
-
-        if (!configuredGroups.isEmpty()) {
-            const auto groupNames = configuredGroups.split(QLatin1Char(','), Qt::SkipEmptyParts);
-            for (const QString &groupName : groupNames) {
-                parsedGroups << groupName.trimmed();
-            }
-        }
-    }
-
-    if (parsedGroups.isEmpty()) {
-        parsedGroups << QStringLiteral("wheel");
-    }
-
-    return parsedGroups;
+    return m_hasExistingUsers;
 }
 
-bool AccountController::hasExistingUsers() const
+bool AccountController::createsUser() const
 {
-    return m_hasExistingUsers;
+    return m_userCreationKept || !m_hasExistingUsers;
 }
 
-void AccountController::initializeExistingUserFlag()
+void AccountController::keepUserCreation()
 {
-    if (isAccountCreationOverrideEnabled()) {
+    if (m_userCreationKept) {
         return;
     }
-
-    const std::pair<int, int> uidRange = regularUserUidRange();
-    const bool hasExistingUsers = detectExistingUsers(uidRange);
-
-    if (!hasExistingUsers) {
-        return;
+    m_userCreationKept = true;
+    qCDebug(PlasmaSetup) << "The account page has been shown, the new user will be created.";
+    if (m_hasExistingUsers) {
+        Q_EMIT createsUserChanged();
     }
-
-    qCInfo(PlasmaSetup) << "Existing users detected, the account module will not be shown.";
-    m_hasExistingUsers = hasExistingUsers;
-    Q_EMIT hasExistingUsersChanged();
 }
 
-bool AccountController::isAccountCreationOverrideEnabled()
+bool AccountController::isDetectingExistingUsers() const
 {
-    if (!qEnvironmentVariableIntValue("PLASMA_SETUP_USER_CREATION_OVERRIDE")) {
-        return false;
-    }
-
-    m_hasExistingUsers = false;
-    Q_EMIT hasExistingUsersChanged();
-    qCInfo(PlasmaSetup) << "PLASMA_SETUP_USER_CREATION_OVERRIDE is set to enable; account creation will be enabled regardless of existing users.";
-    return true;
+    return m_detectingExistingUsers;
 }
 
-std::pair<int, int> AccountController::regularUserUidRange() const
+bool AccountController::takenNamesLoaded() const
 {
-    const QString loginDefsPath = QStringLiteral(LOGIN_DEFS_PATH);
-    QFile loginDefs(loginDefsPath);
-    if (!loginDefs.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCWarning(PlasmaSetup) << "Unable to open" << loginDefs.fileName() << ':' << loginDefs.errorString();
-        return std::pair<int, int>{DEFAULT_MIN_REGULAR_USER_ID, DEFAULT_MAX_REGULAR_USER_ID};
-    }
+    return m_takenNamesLoaded;
+}
 
-    QTextStream stream(&loginDefs);
-    static const QRegularExpression whitespace(QStringLiteral("\\s+"));
+PlasmaSetupValidation::Account::UsernameValidationResult AccountController::validateUsername(QStringView username) const
+{
+    using PlasmaSetupValidation::Account::UsernameValidationResult;
 
-    int uidMinValue = DEFAULT_MIN_REGULAR_USER_ID;
-    int uidMaxValue = DEFAULT_MAX_REGULAR_USER_ID;
-    while (!stream.atEnd()) {
-        const QString trimmedLine = stream.readLine().trimmed();
-        if (trimmedLine.isEmpty() || trimmedLine.startsWith(QLatin1Char('#'))) {
-            continue;
-        }
+    const UsernameValidationResult result = PlasmaSetupValidation::Account::validateUsername(username);
+    if (result == UsernameValidationResult::Valid && m_takenNames.contains(username.trimmed().toString())) {
+        return UsernameValidationResult::AlreadyTaken;
+    }
+    return result;
+}
 
-        const QStringList tokens = trimmedLine.split(whitespace, Qt::SkipEmptyParts);
-        if (tokens.size() >= 2 && tokens.at(0) == QLatin1String("UID_MIN")) {
-            bool ok = false;
-            const int parsedValue = tokens.at(1).toInt(&ok);
-            if (ok && parsedValue >= 0) {
-                uidMinValue = parsedValue;
+void AccountController::detectExistingUsers()
+{
+    const bool overridden = isAccountCreationOverrideEnabled();
+
+    const ExistingUserDetection::Options options{
+        .uidRange = SystemConfig::instance().uidRange(),
+        .queryRemoteUsers = SystemConfig::instance().queryRemoteUsers(),
+    };
+
+    m_detectingExistingUsers = !overridden;
+
+    // Enumerating users may block for a long time on directory-joined machines, keep it off the GUI thread.
+    // The names are needed even when the detection is overridden, to tell whether the username is taken.
+    auto watcher = new QFutureWatcher<ExistingUserDetection::Users>(this);
+    connect(watcher, &QFutureWatcher<ExistingUserDetection::Users>::finished, this, [this, watcher, overridden]() {
+        const ExistingUserDetection::Users users = watcher->result();
+        watcher->deleteLater();
+
+        qCDebug(PlasmaSetup) << "Read" << users.takenNames.size() << "existing user and group names.";
+        m_takenNames = users.takenNames;
+        m_usernameValidation.clear();
+        m_takenNamesLoaded = true;
+
+        const bool hasExistingUsers = !overridden && users.hasRegularUser;
+        if (hasExistingUsers) {
+            if (m_userCreationKept) {
+                qCWarning(PlasmaSetup) << "Existing users detected after the account module was shown, the new user will still be created.";
             } else {
-                qCWarning(PlasmaSetup) << "Invalid UID_MIN value in" << loginDefs.fileName() << ':' << tokens.at(1);
+                qCInfo(PlasmaSetup) << "Existing users detected, the account module will not be shown.";
             }
+            m_hasExistingUsers = true;
         }
-        if (tokens.size() >= 2 && tokens.at(0) == QLatin1String("UID_MAX")) {
-            bool ok = false;
-            const int parsedValue = tokens.at(1).toInt(&ok);
-            if (ok && parsedValue >= 0) {
-                uidMaxValue = parsedValue;
-            } else {
-                qCWarning(PlasmaSetup) << "Invalid UID_MAX value in" << loginDefs.fileName() << ':' << tokens.at(1);
+        m_detectingExistingUsers = false;
+
+        Q_EMIT takenNamesLoadedChanged();
+        if (hasExistingUsers) {
+            Q_EMIT hasExistingUsersChanged();
+            if (!m_userCreationKept) {
+                Q_EMIT createsUserChanged();
             }
         }
-    }
-
-    return std::pair<int, int>{uidMinValue, uidMaxValue};
+        if (!overridden) {
+            Q_EMIT detectingExistingUsersChanged();
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([options]() {
+        return ExistingUserDetection::detect(options);
+    }));
 }
 
-bool AccountController::detectExistingUsers(std::pair<int, int> uidRange) const
+bool AccountController::isAccountCreationOverrideEnabled()
 {
-    struct PasswdScopeGuard {
-        PasswdScopeGuard()
-        {
-            setpwent();
-        }
-        ~PasswdScopeGuard()
-        {
-            endpwent();
-        }
-    } guard;
-
-    const uid_t uidMin = static_cast<uid_t>(std::max(uidRange.first, MINIMUM_USER_ID));
-    const uid_t uidMax = static_cast<uid_t>(std::min(uidRange.second, MAXIMUM_USER_ID));
-    errno = 0;
-    while (passwd *entry = getpwent()) {
-        if (entry->pw_uid >= uidMin && entry->pw_uid <= uidMax) {
-            return true;
-        }
-    }
-
-    if (errno != 0) {
-        qCWarning(PlasmaSetup) << "Failed while enumerating passwd entries:" << QString::fromLocal8Bit(strerror(errno));
+    if (!qEnvironmentVariableIntValue("PLASMA_SETUP_USER_CREATION_OVERRIDE")) {
+        return false;
     }
 
-    return false;
+    m_hasExistingUsers = false;
+    Q_EMIT hasExistingUsersChanged();
+    Q_EMIT createsUserChanged();
+    qCInfo(PlasmaSetup) << "PLASMA_SETUP_USER_CREATION_OVERRIDE is set to enable; account creation will be enabled regardless of existing users.";
+    return true;
 }
 
 #include "moc_accountcontroller.cpp"
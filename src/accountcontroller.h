@@ -6,13 +6,23 @@
 
 #pragma once
 
+#include "usernamevalidator.h"
+
 #include <QObject>
 #include <QQmlEngine>
+#include <QSet>
 #include <QStringList>
+#include <QVariantMap>
 #include <qqmlintegration.h>
 
+#include <optional>
 #include <utility>
 
+namespace KAuth
+{
+class ExecuteJob;
+}
+
 class AccountController : public QObject
 {
     Q_OBJECT
@@ -28,6 +38,30 @@ class AccountController : public QObject
      */
     Q_PROPERTY(bool hasExistingUsers READ hasExistingUsers NOTIFY hasExistingUsersChanged)
 
+    /**
+     * Whether finishing the setup creates the new user.
+     *
+     * True unless existing users were detected before the account page was shown. Once it has
+     * been shown, see keepUserCreation(), the user entered there is created even if existing users
+     * are only detected afterwards.
+     */
+    Q_PROPERTY(bool createsUser READ createsUser NOTIFY createsUserChanged)
+
+    /**
+     * Whether the detection of existing users is still running in the background.
+     *
+     * `hasExistingUsers` is false until the detection is done.
+     */
+    Q_PROPERTY(bool detectingExistingUsers READ isDetectingExistingUsers NOTIFY detectingExistingUsersChanged)
+
+    /**
+     * Whether the names of the existing users and groups are known.
+     *
+     * They are read in the background, until then usernames are not checked against them.
+     * Bindings validating the username should depend on this, to be validated again once loaded.
+     */
+    Q_PROPERTY(bool takenNamesLoaded READ takenNamesLoaded NOTIFY takenNamesLoadedChanged)
+
 public:
     ~AccountController() override;
 
@@ -54,6 +88,14 @@ public:
     QString password() const;
     void setPassword(const QString &password);
 
+    /**
+     * The groups the new user is added to, besides their own.
+     *
+     * Defaults to the groups from the configuration, see SystemConfig::userGroups().
+     */
+    QStringList extraGroups() const;
+    void setExtraGroups(const QStringList &extraGroups);
+
     /**
      * Creates a new user account with the current username, full name, and password.
      *
@@ -61,6 +103,32 @@ public:
      */
     Q_INVOKABLE bool createUser();
 
+    /**
+     * Prepares the job creating the new user account, without starting it.
+     *
+     * The outcome of the job is logged once it finishes.
+     *
+     * @return The KAuth job, owned by KAuth and deleted once it is done.
+     */
+    KAuth::ExecuteJob *createUserJob();
+
+    /**
+     * Prepares the job running the given operations for the new user in a single helper invocation.
+     *
+     * See PlasmaSetupAuthHelper::provisionuser() for the supported operations. If the operations
+     * include "createuser", the account details of this controller are passed along.
+     *
+     * @return The KAuth job, owned by KAuth and deleted once it is done.
+     */
+    KAuth::ExecuteJob *provisionUserJob(const QStringList &operations);
+
+    /**
+     * The arguments of PlasmaSetupAuthHelper::preparenewuser() for the account details chosen so far.
+     *
+     * These are all the user's choices provisioning depends on, apart from the password.
+     */
+    QVariantMap preparationArguments() const;
+
     /**
      * Validates the provided username according to system rules.
      *
@@ -90,11 +158,28 @@ public:
      */
     bool hasExistingUsers() const;
 
+    bool createsUser() const;
+
+    /**
+     * Freezes the decision to create the new user, called once the account page is shown.
+     *
+     * Existing users detected later on no longer skip creating the user, which the person
+     * going through the setup is already entering the details of.
+     */
+    Q_INVOKABLE void keepUserCreation();
+
+    bool isDetectingExistingUsers() const;
+
+    bool takenNamesLoaded() const;
+
 Q_SIGNALS:
     void usernameChanged();
     void fullNameChanged();
     void passwordChanged();
     void hasExistingUsersChanged();
+    void createsUserChanged();
+    void detectingExistingUsersChanged();
+    void takenNamesLoadedChanged();
 
 private:
     /**
@@ -113,48 +198,54 @@ private:
     QString m_fullName;
     QString m_password;
 
+    /** The groups chosen for the new user, those from the configuration if unset. */
+    std::optional<QStringList> m_extraGroups;
+
     /**
      * Cached result of the existing-user detection. Defaults to false so the account page shows.
      */
     bool m_hasExistingUsers = false;
 
+    /** Whether the new user is created regardless of existing users, see keepUserCreation(). */
+    bool m_userCreationKept = false;
+
+    bool m_detectingExistingUsers = false;
+
     /**
-     * Runs the detection routine once during construction to set the existing-user flag.
+     * The names of the existing users and groups, which a new user cannot take.
      */
-    void initializeExistingUserFlag();
+    QSet<QString> m_takenNames;
+
+    bool m_takenNamesLoaded = false;
 
     /**
-     * Checks if overriding account creation behavior via environment variable is requested.
-     *
-     * Reads the PLASMA_SETUP_USER_CREATION_OVERRIDE environment variable, which can be set to
-     * 1 to force account creation to be enabled regardless of existing users. Useful for testing.
-     *
-     * @return true if an override was applied, false otherwise.
+     * The validation of the username last entered, shared by isUsernameValid() and usernameValidationMessage().
      */
-    bool isAccountCreationOverrideEnabled();
+    PlasmaSetupValidation::ValidationCache<PlasmaSetupValidation::Account::UsernameValidationResult> m_usernameValidation{
+        [this](QStringView username) {
+            return validateUsername(username);
+        },
+        PlasmaSetupValidation::Account::usernameValidationMessage,
+    };
 
     /**
-     * Parses the configured login.defs for UID_MIN and UID_MAX, falling back to a sensible default.
-     *
-     * @return pair declaring the UID range for regular users.
+     * Validates the username, including whether it is already taken.
      */
-    std::pair<int, int> regularUserUidRange() const;
+    PlasmaSetupValidation::Account::UsernameValidationResult validateUsername(QStringView username) const;
 
     /**
-     * Enumerates passwd entries to determine if a regular user already exists.
-     *
-     * @param uidRange The pair of UID values to consider as the range for a regular user.
-     * @return true if at least one regular user is found, false otherwise.
+     * Starts the detection routine in the background during construction, which sets the
+     * existing-user flag and reads the names of the existing users and groups in one pass.
      */
-    bool detectExistingUsers(std::pair<int, int> uidRange) const;
+    void detectExistingUsers();
 
     /**
-     * Retrieves from the configuration the list of groups for newly created users.
+     * Checks if overriding account creation behavior via environment variable is requested.
      *
-     * If no groups are specified by the configuration, falls back to the `wheel`
-     * group which most distributions use for admin/sudo access.
+     * Reads the PLASMA_SETUP_USER_CREATION_OVERRIDE environment variable, which can be set to
+     * 1 to force account creation to be enabled regardless of existing users. Useful for testing.
      *
-     * @return A list of group names.
+     * @return true if an override was applied, false otherwise.
      */
-    QStringList userGroupsFromConfig() const;
+    bool isAccountCreationOverrideEnabled();
 };
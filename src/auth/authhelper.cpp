@@ -6,48 +6,106 @@
 #include "../usernamevalidator.h"
 
 #include "config-plasma-setup.h"
+#include "displaymanager.h"
+#include "plasmasetup_auth_debug.h"
 
 #include <KAuth/HelperSupport>
-#include <KConfigGroup>
 #include <KSharedConfig>
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QProcess>
 #include <QRegularExpression>
 #include <QStandardPaths>
+#include <QtDBus/QDBusArgument>
 #include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusObjectPath>
 #include <QtDBus/QDBusPendingReply>
-#include <QtDBus/QDBusReply>
 
 #include <algorithm>
 #include <cerrno>
+#include <cstring>
 #include <exception>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
 #include <grp.h>
 #include <pwd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#if PLASMA_SETUP_ACCOUNTSSERVICE
+#include <crypt.h>
+#endif
+
 /**
- * Minimum UID for regular (non-system) users.
+ * Lowest UID the helper ever accepts for regular users, whatever range it is given.
+ *
+ * Older distributions start regular users at 500, nothing below is ever a regular user.
  */
-constexpr int MIN_REGULAR_USER_UID = 1000;
+constexpr int MIN_REGULAR_USER_UID_FLOOR = 500;
 
+#if PLASMA_SETUP_ACCOUNTSSERVICE
 /**
- * Path to the SDDM autologin configuration file.
+ * D-Bus name, object path and interfaces of AccountsService.
  */
-const QString SDDM_AUTOLOGIN_CONFIG_PATH = QStringLiteral("/etc/sddm.conf.d/99-plasma-setup.conf");
+const QString ACCOUNTS_SERVICE = QStringLiteral("org.freedesktop.Accounts");
+const QString ACCOUNTS_PATH = QStringLiteral("/org/freedesktop/Accounts");
+const QString ACCOUNTS_INTERFACE = QStringLiteral("org.freedesktop.Accounts");
+const QString ACCOUNTS_USER_INTERFACE = QStringLiteral("org.freedesktop.Accounts.User");
 
 /**
- * Path to the PlasmaLogin autologin configuration file.
+ * How long to wait for AccountsService to reply, in milliseconds.
  */
-const QString PLASMALOGIN_AUTOLOGIN_CONFIG_PATH = QStringLiteral("/etc/plasmalogin.conf.d/99-plasma-setup.conf");
+constexpr int ACCOUNTS_SERVICE_TIMEOUT_MS = 30000;
+#endif
 
 /**
  * Path to the Plasma Setup home directory.
  */
 const QString PLASMA_SETUP_HOMEDIR = QStringLiteral("/run/plasma-setup");
 
+/**
+ * The defaults of useradd, which include the directory the home directories are created in.
+ */
+const QString USERADD_DEFAULTS_PATH = QStringLiteral("/etc/default/useradd");
+
+/**
+ * Name of the directory holding the files staged by preparenewuser, next to the home directories.
+ *
+ * Starts with a dot, which no username can, so it is never the home directory of a user.
+ */
+const QString STAGING_DIR_NAME = QStringLiteral(".plasma-setup-staging");
+
+/**
+ * Directory holding the staging directory when the directory of the home directories does not exist yet.
+ */
+const QString FALLBACK_STAGING_PARENT_DIR = QStringLiteral("/var/lib/plasma-setup");
+
+/**
+ * Names of the operations accepted by the provisionuser action.
+ */
+const QString OPERATION_CREATE_USER = QStringLiteral("createuser");
+const QString OPERATION_CREATE_FLAG_FILE = QStringLiteral("createflagfile");
+const QString OPERATION_CREATE_AUTOSTART_HOOK = QStringLiteral("createnewuserautostarthook");
+const QString OPERATION_SET_GLOBAL_THEME = QStringLiteral("setnewuserglobaltheme");
+const QString OPERATION_SET_DISPLAY_SCALING = QStringLiteral("setnewuserdisplayscaling");
+const QString OPERATION_SET_TEMP_AUTOLOGIN = QStringLiteral("setnewusertempautologin");
+const QString OPERATION_SEED_NEW_USER_HOME = QStringLiteral("seednewuserhome");
+
+/**
+ * Operations writing to the home directory of the new user, consecutive ones share a single privilege drop.
+ */
+const QStringList HOME_DIRECTORY_OPERATIONS = {
+    OPERATION_CREATE_AUTOSTART_HOOK,
+    OPERATION_SET_GLOBAL_THEME,
+    OPERATION_SET_DISPLAY_SCALING,
+    OPERATION_SEED_NEW_USER_HOME,
+};
+
 /**
  * RAII guard for temporarily dropping privileges to a specific user.
  *
@@ -105,6 +163,32 @@ private:
  * @param executableName Name of the executable to find (e.g., "useradd")
  * @return Full path to the executable, or empty string if not found
  */
+/**
+ * Returns the directory holding the files staged by preparenewuser, only accessible by root.
+ *
+ * The staged files are renamed into the new home directory, which only works within a filesystem.
+ * They are therefore staged in the directory useradd creates the home directories in, which
+ * may be a partition or a btrfs subvolume of its own.
+ */
+static QString stagingDirectoryPath()
+{
+    QString homeBase = QStringLiteral("/home");
+    QFile defaults(USERADD_DEFAULTS_PATH);
+    if (defaults.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!defaults.atEnd()) {
+            const QByteArray line = defaults.readLine().trimmed();
+            if (line.startsWith("HOME=")) {
+                homeBase = QFile::decodeName(line.sliced(5).trimmed());
+            }
+        }
+    }
+
+    if (QDir::isAbsolutePath(homeBase) && QFileInfo(homeBase).isDir()) {
+        return QDir::cleanPath(homeBase) + QLatin1Char('/') + STAGING_DIR_NAME;
+    }
+    return FALLBACK_STAGING_PARENT_DIR + QStringLiteral("/staging");
+}
+
 static QString findExecutable(const QString &executableName)
 {
     const QStringList searchPaths = {
@@ -190,114 +274,50 @@ ActionReply PlasmaSetupAuthHelper::createuser(const QVariantMap &args)
         return makeErrorReply(QStringLiteral("Password cannot be empty."));
     }
 
-    // Build useradd command arguments
-    QStringList useraddArguments;
-
-    // -m: Create a home directory for the new user
-    useraddArguments << QStringLiteral("-m");
-
-    // -U: Create a group with the same name as the user and add the user to this group
-    useraddArguments << QStringLiteral("-U");
-
-    // -c: Set the user's full name (comment field)
-    if (!fullName.isEmpty()) {
-        useraddArguments << QStringLiteral("-c") << fullName;
-    }
-
-    // The username to create
-    useraddArguments << username;
-
-    // Locate the useradd executable
-    const QString useraddBinary = findExecutable(QStringLiteral("useradd"));
-    if (useraddBinary.isEmpty()) {
-        return makeErrorReply(QStringLiteral("Could not locate useradd executable."));
-    }
-
-    // Execute useradd to create the user account
-    QProcess useraddProcess;
-    useraddProcess.start(useraddBinary, useraddArguments);
-
-    if (!useraddProcess.waitForStarted()) {
-        return makeErrorReply(QStringLiteral("Failed to start useradd: ") + useraddProcess.errorString());
-    }
-
-    if (!useraddProcess.waitForFinished()) {
-        useraddProcess.kill();
-        useraddProcess.waitForFinished();
-        return makeErrorReply(QStringLiteral("useradd timed out."));
-    }
-
-    // Check if useradd completed successfully
-    if (useraddProcess.exitStatus() != QProcess::NormalExit || useraddProcess.exitCode() != 0) {
-        const QString stderrOutput = QString::fromLocal8Bit(useraddProcess.readAllStandardError()).trimmed();
-        const QString stdoutOutput = QString::fromLocal8Bit(useraddProcess.readAllStandardOutput()).trimmed();
-        return makeErrorReply(QStringLiteral("useradd failed with exit code %1: %2 %3").arg(useraddProcess.exitCode()).arg(stderrOutput).arg(stdoutOutput));
-    }
-
-    const ActionReply extraGroupReply = addUserToExtraGroups(username, args.value(QStringLiteral("extraGroups")));
+    QStringList extraGroups;
+    const ActionReply extraGroupReply = validateExtraGroups(args.value(QStringLiteral("extraGroups")), extraGroups);
     if (extraGroupReply.type() != ActionReply::SuccessType) {
+        std::fill(password.begin(), password.end(), '\0');
         return extraGroupReply;
     }
 
-    // We set the password separately using chpasswd to avoid exposing it in command-line arguments
-    // that could be listened to in process listings.
-    //
-    // Locate the chpasswd executable to set the user's password
-    const QString chpasswdBinary = findExecutable(QStringLiteral("chpasswd"));
-    if (chpasswdBinary.isEmpty()) {
-        return makeErrorReply(QStringLiteral("User created but could not locate chpasswd executable."));
-    }
+    const SystemConfig config = SystemConfig::fromHelperArguments(args);
 
-    // Start chpasswd process
-    QProcess chpasswdProcess;
-    chpasswdProcess.start(chpasswdBinary);
+    QElapsedTimer timer;
+    timer.start();
 
-    if (!chpasswdProcess.waitForStarted()) {
-        return makeErrorReply(QStringLiteral("Failed to start chpasswd: ") + chpasswdProcess.errorString());
+    ActionReply creationReply;
+    bool handled = false;
+#if PLASMA_SETUP_ACCOUNTSSERVICE
+    if (config.userBackend() != SystemConfig::UserBackend::Subprocess) {
+        bool serviceAvailable = true;
+        creationReply = createUserWithAccountsService(username, fullName, password, extraGroups, serviceAvailable);
+        handled = serviceAvailable || config.userBackend() == SystemConfig::UserBackend::AccountsService;
+        if (!handled) {
+            qInfo() << "AccountsService is not available, falling back to useradd:" << creationReply.errorDescription();
+        }
     }
-
-    // Prepare password data in the format "username:password\n"
-    QByteArray passwordData = username.toUtf8();
-    passwordData.append(':');
-    passwordData.append(password);
-    passwordData.append('\n');
-
-    // Write password data to chpasswd's stdin
-    if (chpasswdProcess.write(passwordData) != passwordData.size()) {
-        // Writing to chpasswd failed.
-        //
-        // Clear password data from memory for security
-        std::fill(password.begin(), password.end(), '\0');
-        std::fill(passwordData.begin(), passwordData.end(), '\0');
-        // Kill the process and return an error
-        chpasswdProcess.kill();
-        chpasswdProcess.waitForFinished();
-        return makeErrorReply(QStringLiteral("Failed to write password to chpasswd: ") + chpasswdProcess.errorString());
+#else
+    if (config.userBackend() == SystemConfig::UserBackend::AccountsService) {
+        qWarning() << "AccountsService support was disabled at build time, falling back to useradd";
+    }
+#endif
+    if (!handled) {
+        creationReply = createUserWithSubprocesses(username, fullName, password, extraGroups);
     }
-
-    // Close stdin to signal we're done writing
-    chpasswdProcess.closeWriteChannel();
 
     // Clear password data from memory for security
     std::fill(password.begin(), password.end(), '\0');
-    std::fill(passwordData.begin(), passwordData.end(), '\0');
 
-    // Wait for chpasswd to complete
-    if (!chpasswdProcess.waitForFinished()) {
-        chpasswdProcess.kill();
-        chpasswdProcess.waitForFinished();
-        return makeErrorReply(QStringLiteral("chpasswd timed out."));
+    if (creationReply.type() != ActionReply::SuccessType) {
+        return creationReply;
     }
 
-    // Check if chpasswd completed successfully
-    if (chpasswdProcess.exitStatus() != QProcess::NormalExit || chpasswdProcess.exitCode() != 0) {
-        const QString stderrOutput = QString::fromLocal8Bit(chpasswdProcess.readAllStandardError()).trimmed();
-        return makeErrorReply(QStringLiteral("chpasswd failed with exit code %1: %2").arg(chpasswdProcess.exitCode()).arg(stderrOutput));
-    }
+    qCDebug(PlasmaSetupAuth) << "Created user" << username << "in" << timer.elapsed() << "ms";
 
     // Retrieve and return the newly created user's information
     try {
-        UserInfo userInfo = getUserInfo(username);
+        UserInfo userInfo = getUserInfo(username, config);
         ActionReply reply = ActionReply::SuccessReply();
         reply.setData({
             {QStringLiteral("username"), userInfo.username},
@@ -340,6 +360,43 @@ ActionReply PlasmaSetupAuthHelper::createflagfile(const QVariantMap &args)
 }
 
 ActionReply PlasmaSetupAuthHelper::createnewuserautostarthook(const QVariantMap &args)
+{
+    return runHomeDirectoryOperation(OPERATION_CREATE_AUTOSTART_HOOK, args);
+}
+
+ActionReply PlasmaSetupAuthHelper::removeautologin(const QVariantMap &args)
+{
+    QFileInfo fileInfo(QString::fromUtf8(SystemConfig::fromHelperArguments(args).displayManager().autologinConfigPath));
+
+    if (!fileInfo.exists()) {
+        return ActionReply::SuccessReply();
+    }
+
+    QFile file(fileInfo.filePath());
+    if (!file.remove()) {
+        QString errorDetails = file.errorString();
+        return makeErrorReply(QStringLiteral("Unable to remove file ") + fileInfo.filePath() + QStringLiteral(": ") + errorDetails);
+    }
+
+    return ActionReply::SuccessReply();
+}
+
+ActionReply PlasmaSetupAuthHelper::setnewuserglobaltheme(const QVariantMap &args)
+{
+    return runHomeDirectoryOperation(OPERATION_SET_GLOBAL_THEME, args);
+}
+
+ActionReply PlasmaSetupAuthHelper::setnewuserdisplayscaling(const QVariantMap &args)
+{
+    return runHomeDirectoryOperation(OPERATION_SET_DISPLAY_SCALING, args);
+}
+
+ActionReply PlasmaSetupAuthHelper::seednewuserhome(const QVariantMap &args)
+{
+    return runHomeDirectoryOperation(OPERATION_SEED_NEW_USER_HOME, args);
+}
+
+ActionReply PlasmaSetupAuthHelper::setnewusertempautologin(const QVariantMap &args)
 {
     if (!args.contains(QStringLiteral("username")) || !args[QStringLiteral("username")].canConvert<QString>()) {
         return makeErrorReply(QStringLiteral("Username argument is missing or invalid."));
@@ -347,133 +404,208 @@ ActionReply PlasmaSetupAuthHelper::createnewuserautostarthook(const QVariantMap
 
     QString username = args[QStringLiteral("username")].toString();
 
+    // Validate the username. We don't actually need the home directory here,
+    // but this function performs the necessary security checks.
+    const SystemConfig config = SystemConfig::fromHelperArguments(args);
     UserInfo userInfo;
     try {
-        userInfo = getUserInfo(username);
+        userInfo = getUserInfo(username, config);
     } catch (const std::runtime_error &e) {
         return makeErrorReply(QStringLiteral("Failed to get user info: ") + QString::fromStdString(e.what()));
     }
 
-    QString homePath = userInfo.homePath;
+    return writeTempAutologin(userInfo, config.displayManager());
+}
 
-    QString autostartDirPath = QDir::cleanPath(homePath + QStringLiteral("/.config/autostart"));
-    QDir autostartDir(autostartDirPath);
+ActionReply PlasmaSetupAuthHelper::provisionuser(const QVariantMap &args)
+{
+    if (!args.contains(QStringLiteral("username")) || !args[QStringLiteral("username")].canConvert<QString>()) {
+        return makeErrorReply(QStringLiteral("Username argument is missing or invalid."));
+    }
 
-    try {
-        PrivilegeGuard guard(userInfo);
+    const QVariant operationsVariant = args.value(QStringLiteral("operations"));
+    if (!operationsVariant.canConvert<QStringList>()) {
+        return makeErrorReply(QStringLiteral("Operations argument is missing or invalid."));
+    }
+
+    const QStringList operations = operationsVariant.toStringList();
+    const QStringList knownOperations = QStringList{OPERATION_CREATE_USER, OPERATION_CREATE_FLAG_FILE, OPERATION_SET_TEMP_AUTOLOGIN} + HOME_DIRECTORY_OPERATIONS;
 
-        // Ensure the autostart directory exists
-        if (!autostartDir.exists() && !autostartDir.mkpath(QStringLiteral("."))) {
-            return makeErrorReply(QStringLiteral("Unable to create autostart directory: ") + autostartDirPath);
+    // Reject the whole batch up front rather than failing halfway through it
+    for (const QString &operation : operations) {
+        if (!knownOperations.contains(operation)) {
+            return makeErrorReply(QStringLiteral("Unknown operation: ") + operation);
         }
+    }
+    if (operations.indexOf(OPERATION_CREATE_USER) > 0) {
+        return makeErrorReply(QStringLiteral("User creation must be the first operation."));
+    }
+
+    const QString username = args[QStringLiteral("username")].toString().trimmed();
+    const SystemConfig config = SystemConfig::fromHelperArguments(args);
 
-        // Create the desktop entry file
-        QString desktopFilePath = autostartDir.filePath(QStringLiteral("remove-autologin.desktop"));
-        QFile desktopFile(desktopFilePath);
-        if (!desktopFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            return makeErrorReply(QStringLiteral("Unable to open file for writing: ") + desktopFilePath + QStringLiteral(" error:")
-                                  + desktopFile.errorString());
+    QVariantMap results;
+    QStringList completedOperations;
+    std::optional<UserInfo> userInfo;
+
+    // Reports the operations as they complete, so the caller can show how far provisioning got
+    qsizetype reportedOperations = 0;
+    const auto reportProgress = [&]() {
+        while (reportedOperations < completedOperations.size()) {
+            HelperSupport::progressStep(QVariantMap{{QStringLiteral("completedOperation"), completedOperations.at(reportedOperations++)}});
         }
+    };
 
-        QString plasmaSetupExecutablePath = QStringLiteral(PLASMA_SETUP_LIBEXECDIR) + QStringLiteral("/plasma-setup");
-        if (plasmaSetupExecutablePath.isEmpty()) {
-            desktopFile.close();
-            return makeErrorReply(QStringLiteral("Unable to find the Plasma Setup executable path."));
+    // Runs the operations in order and stops at the first one that fails. The reply lists
+    // the operations that completed, so the caller can retry only the remaining ones.
+    const auto finish = [&](const QString &failedOperation, const ActionReply &failedReply) {
+        ActionReply reply = failedOperation.isEmpty() ? ActionReply::SuccessReply() : failedReply;
+        if (!failedOperation.isEmpty()) {
+            reply.setErrorDescription(failedOperation + QStringLiteral(": ") + failedReply.errorDescription());
         }
+        reply.setData({
+            {QStringLiteral("results"), results},
+            {QStringLiteral("completedOperations"), completedOperations},
+        });
+        return reply;
+    };
 
-        QTextStream stream(&desktopFile);
-        stream << "[Desktop Entry]\n";
-        stream << "Type=Application\n";
-        stream << "Name=Remove Plasma Setup Autologin\n";
-        stream << "Exec=sh -c \"" << plasmaSetupExecutablePath << " --remove-autologin && rm --force '" << desktopFilePath << "'\"\n";
-        stream << "X-KDE-StartupNotify=false\n";
-        stream << "NoDisplay=true\n";
-        desktopFile.close();
+    for (qsizetype i = 0; i < operations.size(); ++i) {
+        const QString &operation = operations.at(i);
 
-        ActionReply reply = ActionReply::SuccessReply();
-        reply.setData({{QStringLiteral("autostartFilePath"), desktopFilePath}});
-        return reply;
-    } catch (const std::runtime_error &e) {
-        return makeErrorReply(QStringLiteral("Failed to drop privileges: ") + QString::fromStdString(e.what()));
-    }
-}
+        if (operation == OPERATION_CREATE_USER) {
+            const ActionReply reply = createuser(args);
+            results.insert(operation, reply.data());
+            if (reply.type() != ActionReply::SuccessType) {
+                return finish(operation, reply);
+            }
 
-ActionReply PlasmaSetupAuthHelper::removeautologin(const QVariantMap &args)
-{
-    Q_UNUSED(args);
+            // The reply already contains everything getUserInfo() would look up again
+            const QVariantMap userData = reply.data();
+            userInfo = UserInfo{
+                .username = userData.value(QStringLiteral("username")).toString(),
+                .homePath = userData.value(QStringLiteral("homePath")).toString(),
+                .uid = userData.value(QStringLiteral("uid")).toInt(),
+                .gid = userData.value(QStringLiteral("gid")).toInt(),
+            };
+            completedOperations << operation;
+            reportProgress();
+            continue;
+        }
 
-    QFileInfo fileInfo(displayManagerConfigPath());
+        if (operation == OPERATION_CREATE_FLAG_FILE) {
+            const ActionReply reply = createflagfile({});
+            if (reply.type() != ActionReply::SuccessType) {
+                return finish(operation, reply);
+            }
+            completedOperations << operation;
+            reportProgress();
+            continue;
+        }
 
-    if (!fileInfo.exists()) {
-        return ActionReply::SuccessReply();
-    }
+        if (!userInfo) {
+            try {
+                userInfo = getUserInfo(username, config);
+            } catch (const std::runtime_error &e) {
+                return finish(operation, makeErrorReply(QStringLiteral("Failed to get user info: ") + QString::fromStdString(e.what())));
+            }
+        }
 
-    QFile file(fileInfo.filePath());
-    if (!file.remove()) {
-        QString errorDetails = file.errorString();
-        return makeErrorReply(QStringLiteral("Unable to remove file ") + fileInfo.filePath() + QStringLiteral(": ") + errorDetails);
+        if (operation == OPERATION_SET_TEMP_AUTOLOGIN) {
+            const ActionReply reply = writeTempAutologin(*userInfo, config.displayManager());
+            if (reply.type() != ActionReply::SuccessType) {
+                return finish(operation, reply);
+            }
+            completedOperations << operation;
+            reportProgress();
+            continue;
+        }
+
+        // Group the following home directory operations so they share one privilege drop
+        QStringList homeDirectoryOperations;
+        while (i < operations.size() && HOME_DIRECTORY_OPERATIONS.contains(operations.at(i))) {
+            homeDirectoryOperations << operations.at(i);
+            ++i;
+        }
+        --i;
+
+        QString failedOperation;
+        const ActionReply reply = runHomeDirectoryOperations(*userInfo, config, homeDirectoryOperations, results, completedOperations, failedOperation);
+        reportProgress();
+        if (reply.type() != ActionReply::SuccessType) {
+            return finish(failedOperation, reply);
+        }
     }
 
-    return ActionReply::SuccessReply();
+    return finish(QString(), ActionReply::SuccessReply());
 }
 
-ActionReply PlasmaSetupAuthHelper::setnewuserglobaltheme(const QVariantMap &args)
+ActionReply PlasmaSetupAuthHelper::preparenewuser(const QVariantMap &args)
 {
     if (!args.contains(QStringLiteral("username")) || !args[QStringLiteral("username")].canConvert<QString>()) {
         return makeErrorReply(QStringLiteral("Username argument is missing or invalid."));
     }
 
-    QString username = args[QStringLiteral("username")].toString();
-
-    UserInfo userInfo;
-    try {
-        userInfo = getUserInfo(username);
-    } catch (const std::runtime_error &e) {
-        return makeErrorReply(QStringLiteral("Failed to get user info: ") + QString::fromStdString(e.what()));
+    const QString username = args[QStringLiteral("username")].toString().trimmed();
+    const auto validationResult = PlasmaSetupValidation::Account::validateUsername(username);
+    if (validationResult != PlasmaSetupValidation::Account::UsernameValidationResult::Valid) {
+        return makeErrorReply(PlasmaSetupValidation::Account::usernameValidationMessage(validationResult));
     }
 
-    QString homePath = userInfo.homePath;
+    // Asks the name service, which also knows the users the wizard cannot list itself
+    struct passwd pwd;
+    struct passwd *result = nullptr;
+    const QByteArray usernameBytes = username.toLocal8Bit();
+    const long bufsize = sysconf(_SC_GETPW_R_SIZE_MAX);
+    QByteArray buf(static_cast<int>(bufsize > 0 ? bufsize : 16384), 0);
+    if (getpwnam_r(usernameBytes.constData(), &pwd, buf.data(), buf.size(), &result) == 0 && result) {
+        return makeErrorReply(QStringLiteral("A user named %1 already exists.").arg(username));
+    }
 
-    // Copy the file to a temp file while we still have privileges
-    QString sourceFilePath = PLASMA_SETUP_HOMEDIR + QStringLiteral("/.config/kdeglobals");
-    std::unique_ptr<QTemporaryFile> tempFile;
-    try {
-        tempFile = copyToTempFile(sourceFilePath);
-    } catch (const std::runtime_error &e) {
-        return makeErrorReply(QStringLiteral("Error copying file to temporary location: ") + QString::fromStdString(e.what()));
+    QStringList extraGroups;
+    const ActionReply extraGroupReply = validateExtraGroups(args.value(QStringLiteral("extraGroups")), extraGroups);
+    if (extraGroupReply.type() != ActionReply::SuccessType) {
+        return extraGroupReply;
     }
 
+    // Copy the files for the new home directory now, finishing then only moves them into place
+    const SystemConfig config = SystemConfig::fromHelperArguments(args);
+    std::vector<HomeFiles::HomeEntry> entries;
+    QSet<QString> collectedPaths;
+    const QString stagingPath = stagingDirectoryPath();
     try {
-        PrivilegeGuard guard(userInfo);
-
-        // Ensure the .config directory exists in the new user's home
-        //
-        // TODO: Make creating the .config directory (or just "createNewUserDirs" or whatever) a separate
-        // action that is called explicitly before all others, since it will definitely be needed for
-        // any other configuration actions. This will also avoid redundant error handling code in each
-        // action.
-        QString configDirPath = QDir::cleanPath(homePath + QStringLiteral("/.config"));
-        QDir configDir(configDirPath);
-
-        if (!configDir.exists() && !configDir.mkpath(QStringLiteral("."))) {
-            return makeErrorReply(QStringLiteral("Unable to create .config directory: ") + configDirPath);
+        const FileDescriptor homeDirectory = HomeFiles::openDirectory(PLASMA_SETUP_HOMEDIR);
+        for (const QString &operation : HOME_DIRECTORY_OPERATIONS) {
+            for (const HomeFiles::HomePath &homePath : homePathsForOperation(operation, config)) {
+                HomeFiles::collectHomeEntries(homeDirectory, homePath, entries, collectedPaths);
+            }
         }
 
-        // Set the global theme for the new user
-        QString destFilePath = QDir::cleanPath(configDirPath + QStringLiteral("/kdeglobals"));
-
-        if (!tempFile->copy(destFilePath)) {
-            return makeErrorReply(QStringLiteral("Unable to copy file to destination: ") + tempFile->fileName() + QStringLiteral(" to ") + destFilePath
-                                  + QStringLiteral(" -- Error message: ") + tempFile->errorString());
+        if (QFileInfo(stagingPath).path() == FALLBACK_STAGING_PARENT_DIR) {
+            if (mkdir(QFile::encodeName(FALLBACK_STAGING_PARENT_DIR).constData(), 0700) != 0 && errno != EEXIST) {
+                throw std::runtime_error("Unable to create directory: " + FALLBACK_STAGING_PARENT_DIR.toStdString() + " -- Error: " + strerror(errno));
+            }
+            if (!HomeFiles::openStagingDirectory(FALLBACK_STAGING_PARENT_DIR).isValid()) {
+                throw std::runtime_error("Unable to open directory: " + FALLBACK_STAGING_PARENT_DIR.toStdString());
+            }
         }
-
-        return ActionReply::SuccessReply();
+        const FileDescriptor stagingDirectory = HomeFiles::createStagingDirectory(stagingPath);
+        HomeFiles::stageEntries(stagingDirectory, entries);
     } catch (const std::runtime_error &e) {
-        return makeErrorReply(QStringLiteral("Failed to drop privileges: ") + QString::fromStdString(e.what()));
+        HomeFiles::removeStagingDirectory(stagingPath);
+        return makeErrorReply(QString::fromStdString(e.what()));
     }
+
+    ActionReply reply = ActionReply::SuccessReply();
+    reply.setData({
+        {QStringLiteral("extraGroups"), extraGroups},
+        {QStringLiteral("homeEntries"), qsizetype(entries.size())},
+        {QStringLiteral("displayManager"), QString::fromUtf8(config.displayManager().name)},
+    });
+    return reply;
 }
 
-ActionReply PlasmaSetupAuthHelper::setnewuserdisplayscaling(const QVariantMap &args)
+ActionReply PlasmaSetupAuthHelper::runHomeDirectoryOperation(const QString &operation, const QVariantMap &args)
 {
     if (!args.contains(QStringLiteral("username")) || !args[QStringLiteral("username")].canConvert<QString>()) {
         return makeErrorReply(QStringLiteral("Username argument is missing or invalid."));
@@ -481,101 +613,498 @@ ActionReply PlasmaSetupAuthHelper::setnewuserdisplayscaling(const QVariantMap &a
 
     QString username = args[QStringLiteral("username")].toString();
 
+    const SystemConfig config = SystemConfig::fromHelperArguments(args);
+
     UserInfo userInfo;
     try {
-        userInfo = getUserInfo(username);
+        userInfo = getUserInfo(username, config);
     } catch (const std::runtime_error &e) {
         return makeErrorReply(QStringLiteral("Failed to get user info: ") + QString::fromStdString(e.what()));
     }
 
-    QString homePath = userInfo.homePath;
-
-    QStringList filesToCopy = {
-        QStringLiteral("kwinoutputconfig.json"),
-        QStringLiteral("kwinrc"),
-    };
+    QVariantMap results;
+    QStringList completedOperations;
+    QString failedOperation;
+    ActionReply reply = runHomeDirectoryOperations(userInfo, config, {operation}, results, completedOperations, failedOperation);
+    if (reply.type() == ActionReply::SuccessType) {
+        reply.setData(results.value(operation).toMap());
+    }
+    return reply;
+}
 
-    QString sourceBasePath = PLASMA_SETUP_HOMEDIR + QStringLiteral("/.config");
+ActionReply PlasmaSetupAuthHelper::runHomeDirectoryOperations(const UserInfo &userInfo,
+                                                              const SystemConfig &config,
+                                                              const QStringList &operations,
+                                                              QVariantMap &results,
+                                                              QStringList &completedOperations,
+                                                              QString &failedOperation)
+{
+    // Open the source files while we still have privileges, they are read
+    // from the open descriptors once privileges have been dropped.
+    std::map<QString, std::vector<HomeFiles::HomeEntry>> operationEntries;
+    QSet<QString> collectedPaths;
+    FileDescriptor homeDirectory;
+    for (const QString &operation : operations) {
+        std::vector<HomeFiles::HomeEntry> &entries = operationEntries[operation];
+        for (const HomeFiles::HomePath &homePath : homePathsForOperation(operation, config)) {
+            try {
+                if (!homeDirectory.isValid()) {
+                    homeDirectory = HomeFiles::openDirectory(PLASMA_SETUP_HOMEDIR);
+                }
+                HomeFiles::collectHomeEntries(homeDirectory, homePath, entries, collectedPaths);
+            } catch (const std::runtime_error &e) {
+                failedOperation = operation;
+                return makeErrorReply(QString::fromStdString(e.what()));
+            }
+        }
+    }
 
-    // Copy files to temp files while we still have privileges
-    std::map<QString, std::unique_ptr<QTemporaryFile>> tempFiles;
-    for (const QString &fileName : filesToCopy) {
-        QString sourceFilePath = QDir::cleanPath(sourceBasePath + QStringLiteral("/") + fileName);
-        try {
-            tempFiles[fileName] = copyToTempFile(sourceFilePath);
-        } catch (const std::runtime_error &e) {
-            return makeErrorReply(QStringLiteral("Error copying file to temporary location: ") + QString::fromStdString(e.what()));
+    // Files staged by preparenewuser whose sources did not change since are moved instead of copied
+    const QString stagingPath = stagingDirectoryPath();
+    FileDescriptor stagingDirectory;
+    FileDescriptor userHomeDirectory;
+    QSet<QString> stagedFiles;
+    try {
+        stagingDirectory = HomeFiles::openStagingDirectory(stagingPath);
+        if (stagingDirectory.isValid()) {
+            userHomeDirectory = HomeFiles::openDirectory(userInfo.homePath);
+            struct stat stagingStat;
+            struct stat userHomeStat;
+            if (fstat(stagingDirectory.get(), &stagingStat) == 0 && fstat(userHomeDirectory.get(), &userHomeStat) == 0
+                && stagingStat.st_dev == userHomeStat.st_dev) {
+                for (const auto &[operation, entries] : operationEntries) {
+                    stagedFiles.unite(HomeFiles::stagedFiles(stagingDirectory, entries));
+                }
+            } else {
+                qInfo() << "The staged files are not on the filesystem of" << userInfo.homePath << ", copying the files instead";
+            }
         }
+    } catch (const std::runtime_error &e) {
+        qWarning() << "Not using the staged files:" << e.what();
+        stagedFiles.clear();
     }
 
+    std::map<QString, QVariantMap> operationData;
     try {
         PrivilegeGuard guard(userInfo);
 
-        // Ensure the config directory exists
-        QString destBasePath = QDir::cleanPath(homePath + QStringLiteral("/.config"));
-        QDir destDir(destBasePath);
-        if (!destDir.exists()) {
-            destDir.mkpath(destBasePath);
+        // Create the whole directory tree once for all operations. Sorting the
+        // paths ensures parent directories are created before their children.
+        std::map<QString, mode_t> directories = {{QStringLiteral(".config"), 0700}};
+        for (const auto &[operation, entries] : operationEntries) {
+            for (const HomeFiles::HomeEntry &entry : entries) {
+                if (S_ISDIR(entry.sourceStat.st_mode)) {
+                    directories[entry.relativePath] = entry.sourceStat.st_mode & 0777;
+                }
+                QString parentPath = QFileInfo(entry.relativePath).path();
+                while (parentPath != QLatin1String(".") && !directories.contains(parentPath)) {
+                    directories.emplace(parentPath, 0700);
+                    parentPath = QFileInfo(parentPath).path();
+                }
+            }
         }
 
-        // Copy display scaling configuration files to the new user from temp files
-        for (const QString &fileName : filesToCopy) {
-            QString destFilePath = QDir::cleanPath(destBasePath + QStringLiteral("/") + fileName);
+        for (const auto &[relativePath, mode] : directories) {
+            const QString directoryPath = QDir::cleanPath(userInfo.homePath + QLatin1Char('/') + relativePath);
+            if (mkdir(QFile::encodeName(directoryPath).constData(), mode) != 0 && errno != EEXIST) {
+                failedOperation = operations.first();
+                return makeErrorReply(QStringLiteral("Unable to create directory %1: %2").arg(directoryPath, QString::fromLocal8Bit(strerror(errno))));
+            }
 
-            auto tempFile = tempFiles[fileName].get();
-            if (!tempFile->copy(destFilePath)) {
-                return makeErrorReply(QStringLiteral("Unable to copy file to destination: ") + tempFile->fileName() + QStringLiteral(" to ") + destFilePath
-                                      + QStringLiteral(" -- Error message: ") + tempFile->errorString());
+            struct stat directoryStat;
+            if (lstat(QFile::encodeName(directoryPath).constData(), &directoryStat) != 0 || !S_ISDIR(directoryStat.st_mode)) {
+                failedOperation = operations.first();
+                return makeErrorReply(QStringLiteral("Not a directory: ") + directoryPath);
             }
         }
 
-        return ActionReply::SuccessReply();
+        const QString configDirPath = QDir::cleanPath(userInfo.homePath + QStringLiteral("/.config"));
+
+        for (const QString &operation : operations) {
+            QVariantMap &data = operationData[operation];
+
+            if (operation == OPERATION_CREATE_AUTOSTART_HOOK) {
+                QString desktopFilePath;
+                const ActionReply reply = writeAutostartHook(configDirPath, desktopFilePath);
+                if (reply.type() != ActionReply::SuccessType) {
+                    failedOperation = operation;
+                    return reply;
+                }
+                data.insert(QStringLiteral("autostartFilePath"), desktopFilePath);
+            }
+
+            // Copy the files of the operation to the new user, skipping the ones that are already up to date
+            int copiedFiles = 0;
+            int skippedFiles = 0;
+            for (const HomeFiles::HomeEntry &entry : operationEntries[operation]) {
+                if (!entry.source.isValid() || stagedFiles.contains(entry.relativePath)) {
+                    continue;
+                }
+
+                const QString destFilePath = QDir::cleanPath(userInfo.homePath + QLatin1Char('/') + entry.relativePath);
+                try {
+                    if (HomeFiles::hasSameContents(entry.source, entry.sourceStat, destFilePath)) {
+                        ++skippedFiles;
+                        continue;
+                    }
+                    HomeFiles::copyToFile(entry.source, destFilePath);
+                    ++copiedFiles;
+                } catch (const std::runtime_error &e) {
+                    failedOperation = operation;
+                    return makeErrorReply(QStringLiteral("Unable to copy file to destination: ") + destFilePath + QStringLiteral(" -- Error message: ")
+                                          + QString::fromStdString(e.what()));
+                }
+            }
+
+            data.insert(QStringLiteral("copiedFiles"), copiedFiles);
+            data.insert(QStringLiteral("skippedFiles"), skippedFiles);
+        }
     } catch (const std::runtime_error &e) {
+        failedOperation = operations.first();
         return makeErrorReply(QStringLiteral("Failed to drop privileges: ") + QString::fromStdString(e.what()));
     }
+
+    // Moved back with admin privileges, the new user cannot access the staging directory
+    for (const QString &operation : operations) {
+        int movedFiles = 0;
+        for (const HomeFiles::HomeEntry &entry : operationEntries[operation]) {
+            if (!stagedFiles.contains(entry.relativePath)) {
+                continue;
+            }
+            try {
+                HomeFiles::moveStagedFile(stagingDirectory, entry.relativePath, userHomeDirectory, userInfo.uid, userInfo.gid);
+                ++movedFiles;
+            } catch (const std::runtime_error &e) {
+                failedOperation = operation;
+                return makeErrorReply(QString::fromStdString(e.what()));
+            }
+        }
+
+        QVariantMap &data = operationData[operation];
+        data.insert(QStringLiteral("movedFiles"), movedFiles);
+        results.insert(operation, data);
+        completedOperations << operation;
+    }
+
+    if (stagingDirectory.isValid()) {
+        HomeFiles::removeStagingDirectory(stagingPath);
+    }
+
+    return ActionReply::SuccessReply();
 }
 
-ActionReply PlasmaSetupAuthHelper::setnewusertempautologin(const QVariantMap &args)
+QList<HomeFiles::HomePath> PlasmaSetupAuthHelper::homePathsForOperation(const QString &operation, const SystemConfig &config)
 {
-    if (!args.contains(QStringLiteral("username")) || !args[QStringLiteral("username")].canConvert<QString>()) {
-        return makeErrorReply(QStringLiteral("Username argument is missing or invalid."));
+    if (operation == OPERATION_SET_GLOBAL_THEME) {
+        return {{QStringLiteral(".config/kdeglobals"), false}};
     }
+    if (operation == OPERATION_SET_DISPLAY_SCALING) {
+        return {
+            {QStringLiteral(".config/kwinoutputconfig.json"), false},
+            {QStringLiteral(".config/kwinrc"), false},
+        };
+    }
+    if (operation == OPERATION_SEED_NEW_USER_HOME) {
+        QList<HomeFiles::HomePath> homePaths;
+        const QStringList manifest = newUserHomeManifest(config);
+        for (const QString &path : manifest) {
+            homePaths.append({path, true});
+        }
+        return homePaths;
+    }
+    return {};
+}
 
-    QString username = args[QStringLiteral("username")].toString();
+QStringList PlasmaSetupAuthHelper::newUserHomeManifest(const SystemConfig &config)
+{
+    const QStringList manifest = config.newUserHomePaths();
+    if (!manifest.isEmpty()) {
+        return manifest;
+    }
 
-    // Validate the username. We don't actually need the home directory here,
-    // but this function performs the necessary security checks.
-    try {
-        UserInfo userInfo = getUserInfo(username);
-    } catch (const std::runtime_error &e) {
-        return makeErrorReply(QStringLiteral("Failed to get user info: ") + QString::fromStdString(e.what()));
+    return {
+        QStringLiteral(".config/kdeglobals"),
+        QStringLiteral(".config/kwinoutputconfig.json"),
+        QStringLiteral(".config/kwinrc"),
+    };
+}
+
+ActionReply PlasmaSetupAuthHelper::writeAutostartHook(const QString &configDirPath, QString &desktopFilePath)
+{
+    QString autostartDirPath = QDir::cleanPath(configDirPath + QStringLiteral("/autostart"));
+    QDir autostartDir(autostartDirPath);
+
+    // Ensure the autostart directory exists
+    if (!autostartDir.exists() && !autostartDir.mkpath(QStringLiteral("."))) {
+        return makeErrorReply(QStringLiteral("Unable to create autostart directory: ") + autostartDirPath);
+    }
+
+    // Create the desktop entry file
+    desktopFilePath = autostartDir.filePath(QStringLiteral("remove-autologin.desktop"));
+    QFile desktopFile(desktopFilePath);
+    if (!desktopFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return makeErrorReply(QStringLiteral("Unable to open file for writing: ") + desktopFilePath + QStringLiteral(" error:") + desktopFile.errorString());
     }
 
-    const QString displayManagerConfig = displayManagerConfigPath();
+    QString plasmaSetupExecutablePath = QStringLiteral(PLASMA_SETUP_LIBEXECDIR) + QStringLiteral("/plasma-setup");
+
+    QTextStream stream(&desktopFile);
+    stream << "[Desktop Entry]\n";
+    stream << "Type=Application\n";
+    stream << "Name=Remove Plasma Setup Autologin\n";
+    stream << "Exec=sh -c \"" << plasmaSetupExecutablePath << " --remove-autologin && rm --force '" << desktopFilePath << "'\"\n";
+    stream << "X-KDE-StartupNotify=false\n";
+    stream << "NoDisplay=true\n";
+    desktopFile.close();
+
+    return ActionReply::SuccessReply();
+}
+
+ActionReply PlasmaSetupAuthHelper::writeTempAutologin(const UserInfo &userInfo, const DisplayManager &displayManager)
+{
+    const QString displayManagerConfig = QString::fromUtf8(displayManager.autologinConfigPath);
 
     QFile file(displayManagerConfig);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         return makeErrorReply(QStringLiteral("Unable to open file ") + displayManagerConfig + QStringLiteral(" for writing: ") + file.errorString());
     }
 
-    QTextStream stream(&file);
-    stream << "[Autologin]\n";
-    stream << "User=" << username << "\n";
-    stream << "Session=plasma\n";
-    stream << "Relogin=true\n"; // Set Relogin to true for temporary autologin
+    // Log back in when the session ends, for temporary autologin
+    const std::string config = displayManager.autologinConfig(userInfo.username.toStdString(), "plasma", true);
+    file.write(config.data(), config.size());
     file.close();
 
     return ActionReply::SuccessReply();
 }
 
-ActionReply PlasmaSetupAuthHelper::addUserToExtraGroups(const QString &username, const QVariant &extraGroupsVariant)
+ActionReply PlasmaSetupAuthHelper::createUserWithSubprocesses(const QString &username,
+                                                              const QString &fullName,
+                                                              const QByteArray &password,
+                                                              const QStringList &extraGroups)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Build useradd command arguments
+    QStringList useraddArguments;
+
+    // -m: Create a home directory for the new user
+    useraddArguments << QStringLiteral("-m");
+
+    // -U: Create a group with the same name as the user and add the user to this group
+    useraddArguments << QStringLiteral("-U");
+
+    // -G: Add the user to the supplementary groups right away, saving a separate usermod run
+    if (!extraGroups.isEmpty()) {
+        useraddArguments << QStringLiteral("-G") << extraGroups.join(QLatin1Char(','));
+    }
+
+    // -c: Set the user's full name (comment field)
+    if (!fullName.isEmpty()) {
+        useraddArguments << QStringLiteral("-c") << fullName;
+    }
+
+    // The username to create
+    useraddArguments << username;
+
+    // Locate the useradd executable
+    const QString useraddBinary = findExecutable(QStringLiteral("useradd"));
+    if (useraddBinary.isEmpty()) {
+        return makeErrorReply(QStringLiteral("Could not locate useradd executable."));
+    }
+
+    // Execute useradd to create the user account
+    QProcess useraddProcess;
+    useraddProcess.start(useraddBinary, useraddArguments);
+
+    if (!useraddProcess.waitForStarted()) {
+        return makeErrorReply(QStringLiteral("Failed to start useradd: ") + useraddProcess.errorString());
+    }
+
+    if (!useraddProcess.waitForFinished()) {
+        useraddProcess.kill();
+        useraddProcess.waitForFinished();
+        return makeErrorReply(QStringLiteral("useradd timed out."));
+    }
+
+    // Check if useradd completed successfully
+    if (useraddProcess.exitStatus() != QProcess::NormalExit || useraddProcess.exitCode() != 0) {
+        const QString stderrOutput = QString::fromLocal8Bit(useraddProcess.readAllStandardError()).trimmed();
+        const QString stdoutOutput = QString::fromLocal8Bit(useraddProcess.readAllStandardOutput()).trimmed();
+        return makeErrorReply(QStringLiteral("useradd failed with exit code %1: %2 %3").arg(useraddProcess.exitCode()).arg(stderrOutput).arg(stdoutOutput));
+    }
+
+    qCDebug(PlasmaSetupAuth) << "useradd took" << timer.restart() << "ms";
+
+    // We set the password separately using chpasswd to avoid exposing it in command-line arguments
+    // that could be listened to in process listings.
+    //
+    // Locate the chpasswd executable to set the user's password
+    const QString chpasswdBinary = findExecutable(QStringLiteral("chpasswd"));
+    if (chpasswdBinary.isEmpty()) {
+        return makeErrorReply(QStringLiteral("User created but could not locate chpasswd executable."));
+    }
+
+    // Start chpasswd process
+    QProcess chpasswdProcess;
+    chpasswdProcess.start(chpasswdBinary);
+
+    if (!chpasswdProcess.waitForStarted()) {
+        return makeErrorReply(QStringLiteral("Failed to start chpasswd: ") + chpasswdProcess.errorString());
+    }
+
+    // Prepare password data in the format "username:password\n"
+    QByteArray passwordData = username.toUtf8();
+    passwordData.append(':');
+    passwordData.append(password);
+    passwordData.append('\n');
+
+    // Write password data to chpasswd's stdin
+    if (chpasswdProcess.write(passwordData) != passwordData.size()) {
+        // Writing to chpasswd failed.
+        //
+        // Clear password data from memory for security
+        std::fill(passwordData.begin(), passwordData.end(), '\0');
+        // Kill the process and return an error
+        chpasswdProcess.kill();
+        chpasswdProcess.waitForFinished();
+        return makeErrorReply(QStringLiteral("Failed to write password to chpasswd: ") + chpasswdProcess.errorString());
+    }
+
+    // Close stdin to signal we're done writing
+    chpasswdProcess.closeWriteChannel();
+
+    // Clear password data from memory for security
+    std::fill(passwordData.begin(), passwordData.end(), '\0');
+
+    // Wait for chpasswd to complete
+    if (!chpasswdProcess.waitForFinished()) {
+        chpasswdProcess.kill();
+        chpasswdProcess.waitForFinished();
+        return makeErrorReply(QStringLiteral("chpasswd timed out."));
+    }
+
+    // Check if chpasswd completed successfully
+    if (chpasswdProcess.exitStatus() != QProcess::NormalExit || chpasswdProcess.exitCode() != 0) {
+        const QString stderrOutput = QString::fromLocal8Bit(chpasswdProcess.readAllStandardError()).trimmed();
+        return makeErrorReply(QStringLiteral("chpasswd failed with exit code %1: %2").arg(chpasswdProcess.exitCode()).arg(stderrOutput));
+    }
+
+    qCDebug(PlasmaSetupAuth) << "chpasswd took" << timer.elapsed() << "ms";
+
+    return ActionReply::SuccessReply();
+}
+
+#if PLASMA_SETUP_ACCOUNTSSERVICE
+/**
+ * Hashes a password for the shadow database, with the preferred method of the system.
+ *
+ * @return The hashed password, or an empty string if hashing failed.
+ */
+static QByteArray hashPassword(const QByteArray &password)
+{
+    char salt[CRYPT_GENSALT_OUTPUT_SIZE];
+    if (!crypt_gensalt_rn(nullptr, 0, nullptr, 0, salt, sizeof(salt))) {
+        return {};
+    }
+
+    // crypt_data is large, keep it off the stack
+    auto data = std::make_unique<crypt_data>();
+    const char *hash = crypt_rn(password.constData(), salt, data.get(), sizeof(crypt_data));
+    QByteArray result = (hash && hash[0] != '*') ? QByteArray(hash) : QByteArray();
+    explicit_bzero(data.get(), sizeof(crypt_data));
+    return result;
+}
+
+/**
+ * Calls a method of AccountsService on the system bus and waits for its reply.
+ */
+static QDBusMessage callAccountsService(const QString &path, const QString &interface, const QString &method, const QVariantList &arguments)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(ACCOUNTS_SERVICE, path, interface, method);
+    message.setArguments(arguments);
+    return QDBusConnection::systemBus().call(message, QDBus::Block, ACCOUNTS_SERVICE_TIMEOUT_MS);
+}
+
+ActionReply PlasmaSetupAuthHelper::createUserWithAccountsService(const QString &username,
+                                                                 const QString &fullName,
+                                                                 const QByteArray &password,
+                                                                 const QStringList &extraGroups,
+                                                                 bool &serviceAvailable)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    serviceAvailable = true;
+
+    QByteArray passwordHash = hashPassword(password);
+    if (passwordHash.isEmpty()) {
+        return makeErrorReply(QStringLiteral("Failed to hash the password."));
+    }
+    qCDebug(PlasmaSetupAuth) << "Hashing the password took" << timer.restart() << "ms";
+
+    // AccountsService creates the account, its group and home directory in one go. The standard
+    // account type is used, the administrator groups come from the configured extra groups.
+    const QDBusMessage createReply = callAccountsService(ACCOUNTS_PATH, ACCOUNTS_INTERFACE, QStringLiteral("CreateUser"), {username, fullName, 0});
+    if (createReply.type() != QDBusMessage::ReplyMessage) {
+        std::fill(passwordHash.begin(), passwordHash.end(), '\0');
+        serviceAvailable =
+            createReply.errorName() != QLatin1String("org.freedesktop.DBus.Error.ServiceUnknown") && QDBusConnection::systemBus().isConnected();
+        return makeErrorReply(QStringLiteral("AccountsService failed to create the user: ") + createReply.errorMessage());
+    }
+    const QString userPath = qdbus_cast<QDBusObjectPath>(createReply.arguments().value(0)).path();
+    qCDebug(PlasmaSetupAuth) << "AccountsService CreateUser took" << timer.restart() << "ms";
+
+    // Only the hash goes over the bus, never the password itself
+    const QDBusMessage passwordReply =
+        callAccountsService(userPath, ACCOUNTS_USER_INTERFACE, QStringLiteral("SetPassword"), {QString::fromLatin1(passwordHash), QString()});
+    std::fill(passwordHash.begin(), passwordHash.end(), '\0');
+    if (passwordReply.type() != QDBusMessage::ReplyMessage) {
+        const QString error = passwordReply.errorMessage();
+        deleteAccountsServiceUser(userPath);
+        return makeErrorReply(QStringLiteral("AccountsService failed to set the password: ") + error);
+    }
+    qCDebug(PlasmaSetupAuth) << "AccountsService SetPassword took" << timer.restart() << "ms";
+
+    // AccountsService has no API for arbitrary supplementary groups
+    const ActionReply groupsReply = addUserToExtraGroups(username, extraGroups);
+    if (groupsReply.type() != ActionReply::SuccessType) {
+        deleteAccountsServiceUser(userPath);
+        return groupsReply;
+    }
+    if (!extraGroups.isEmpty()) {
+        qCDebug(PlasmaSetupAuth) << "Adding the user to extra groups took" << timer.elapsed() << "ms";
+    }
+
+    return ActionReply::SuccessReply();
+}
+
+void PlasmaSetupAuthHelper::deleteAccountsServiceUser(const QString &userPath)
+{
+    // Roll back the half-created account, so that creating it can be retried
+    const QDBusMessage uidReply = callAccountsService(userPath,
+                                                      QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                      QStringLiteral("Get"),
+                                                      {ACCOUNTS_USER_INTERFACE, QStringLiteral("Uid")});
+    if (uidReply.type() != QDBusMessage::ReplyMessage) {
+        qWarning() << "Unable to look up the user to roll back:" << uidReply.errorMessage();
+        return;
+    }
+
+    const qint64 uid = qdbus_cast<QDBusVariant>(uidReply.arguments().value(0)).variant().toLongLong();
+    const QDBusMessage deleteReply = callAccountsService(ACCOUNTS_PATH, ACCOUNTS_INTERFACE, QStringLiteral("DeleteUser"), {uid, true});
+    if (deleteReply.type() != QDBusMessage::ReplyMessage) {
+        qWarning() << "Unable to roll back the creation of the user:" << deleteReply.errorMessage();
+    }
+}
+#endif
+
+ActionReply PlasmaSetupAuthHelper::validateExtraGroups(const QVariant &extraGroupsVariant, QStringList &extraGroups)
 {
     if (!extraGroupsVariant.canConvert<QStringList>()) {
         return makeErrorReply(QStringLiteral("Extra groups argument is missing or invalid."));
     }
 
-    QStringList extraGroups;
-
     const QStringList extraGroupsVariantList = extraGroupsVariant.toStringList();
     extraGroups.reserve(extraGroupsVariantList.size());
 
@@ -590,6 +1119,11 @@ ActionReply PlasmaSetupAuthHelper::addUserToExtraGroups(const QString &username,
         }
     }
 
+    return ActionReply::SuccessReply();
+}
+
+ActionReply PlasmaSetupAuthHelper::addUserToExtraGroups(const QString &username, const QStringList &extraGroups)
+{
     if (extraGroups.isEmpty()) {
         return ActionReply::SuccessReply();
     }
@@ -628,40 +1162,7 @@ ActionReply PlasmaSetupAuthHelper::addUserToExtraGroups(const QString &username,
     return ActionReply::SuccessReply();
 }
 
-std::unique_ptr<QTemporaryFile> PlasmaSetupAuthHelper::copyToTempFile(const QString &sourceFilePath)
-{
-    // Create a temporary file
-    auto tempFile = std::make_unique<QTemporaryFile>();
-
-    if (!tempFile->open()) {
-        throw std::runtime_error("Unable to create temporary file: " + tempFile->errorString().toStdString());
-    }
-
-    // Copy the source file to the temp file
-    QFile sourceFile(sourceFilePath);
-    if (!sourceFile.open(QIODevice::ReadOnly)) {
-        throw std::runtime_error("Unable to open source file: " + sourceFilePath.toStdString() + " -- Error: " + sourceFile.errorString().toStdString());
-    }
-
-    QByteArray data = sourceFile.readAll();
-    sourceFile.close();
-
-    if (tempFile->write(data) != data.size()) {
-        throw std::runtime_error("Unable to write to temporary file: " + tempFile->errorString().toStdString());
-    }
-
-    tempFile->flush();
-
-    // Set file permissions to be readable by everyone, so the new user can access it.
-    QString tempFilePath = tempFile->fileName();
-    if (chmod(tempFilePath.toUtf8().constData(), 0644) != 0) {
-        throw std::runtime_error("Unable to set permissions on temporary file: error code " + std::to_string(errno));
-    }
-
-    return tempFile;
-}
-
-UserInfo PlasmaSetupAuthHelper::getUserInfo(const QString &username)
+UserInfo PlasmaSetupAuthHelper::getUserInfo(const QString &username, const SystemConfig &config)
 {
     struct passwd pwd;
     struct passwd *result = nullptr;
@@ -682,9 +1183,14 @@ UserInfo PlasmaSetupAuthHelper::getUserInfo(const QString &username)
         }
     }
 
-    if (pwd.pw_uid < MIN_REGULAR_USER_UID) {
+    // The range comes from the caller, never trust it to exclude system users on its own
+    const auto [uidMin, uidMax] = config.uidRange();
+    if (pwd.pw_uid == 0 || pwd.pw_uid < static_cast<uid_t>(std::max(uidMin, MIN_REGULAR_USER_UID_FLOOR))) {
         throw std::runtime_error("Refusing to perform action for system user: " + username.toStdString());
     }
+    if (uidMax >= 0 && pwd.pw_uid > static_cast<uid_t>(uidMax)) {
+        throw std::runtime_error("Refusing to perform action for user outside of the regular UID range: " + username.toStdString());
+    }
 
     UserInfo userInfo;
     userInfo.username = QString::fromLocal8Bit(pwd.pw_name);
@@ -702,21 +1208,6 @@ ActionReply PlasmaSetupAuthHelper::makeErrorReply(const QString &errorDescriptio
     return reply;
 }
 
-QString PlasmaSetupAuthHelper::displayManagerConfigPath()
-{
-    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.systemd1"),
-                                                      QStringLiteral("/org/freedesktop/systemd1"),
-                                                      QStringLiteral("org.freedesktop.systemd1.Manager"),
-                                                      QStringLiteral("GetUnitFileState"));
-    msg << QStringLiteral("plasmalogin.service");
-
-    QDBusReply<QString> usingPlasmaLoginQuery = QDBusConnection::systemBus().call(msg);
-    if (usingPlasmaLoginQuery.value() == QLatin1String("enabled")) {
-        return PLASMALOGIN_AUTOLOGIN_CONFIG_PATH;
-    }
-    return SDDM_AUTOLOGIN_CONFIG_PATH;
-}
-
 KAUTH_HELPER_MAIN("org.kde.plasmasetup", PlasmaSetupAuthHelper)
 
 #include "moc_authhelper.cpp"
@@ -4,11 +4,19 @@
 
 #pragma once
 
+#include "config-plasma-setup.h"
+#include "homefiles.h"
+#include "systemconfig.h"
+
 #include <KAuth/ActionReply>
 
-#include <QTemporaryFile>
+#include <QSet>
 #include <QVariant>
 
+#include <sys/stat.h>
+
+#include <vector>
+
 using namespace KAuth;
 
 /**
@@ -70,7 +78,8 @@ public Q_SLOTS:
     /**
      * Removes the configuration file that enables autologin for Plasma Setup.
      *
-     * @param args The arguments passed to the action (not used here).
+     * @param args The arguments passed to the action, which may include:
+     * - String: "displayManager": The display manager detected by the application, see SystemConfig::helperArguments().
      * @return An ActionReply indicating success or failure.
      */
     ActionReply removeautologin(const QVariantMap &args);
@@ -98,6 +107,22 @@ public Q_SLOTS:
      */
     ActionReply setnewuserdisplayscaling(const QVariantMap &args);
 
+    /**
+     * Copies the files and directories listed in the configuration from the plasma-setup user to the new user.
+     *
+     * The paths are read from the `Paths` key of the `[NewUserHome]` group of plasmasetuprc, relative to
+     * the home directory, and default to the files copied by `setnewuserglobaltheme` and
+     * `setnewuserdisplayscaling`. Directories are copied recursively, paths that do not exist or go
+     * through a symbolic link are skipped. The directory tree is created once, permissions and timestamps
+     * are kept, and files whose contents are already identical are not written again.
+     *
+     * @param args The arguments passed to the action, which should include:
+     * - String: "username": The username of the newly created user.
+     * @return An ActionReply indicating success or failure, whose data contains the number of
+     * "copiedFiles", "skippedFiles" and "movedFiles", the latter staged by `preparenewuser`.
+     */
+    ActionReply seednewuserhome(const QVariantMap &args);
+
     /**
      * Sets the configuration for the newly created user to login automatically.
      *
@@ -110,24 +135,134 @@ public Q_SLOTS:
      */
     ActionReply setnewusertempautologin(const QVariantMap &args);
 
+    /**
+     * Runs several of the actions above for the new user in a single helper invocation.
+     *
+     * The user is only looked up once, and consecutive operations writing to the new user's
+     * home directory share a single privilege drop. The operations are run in the given order,
+     * stopping at the first one that fails.
+     *
+     * @param args The arguments passed to the action, which should include:
+     * - String: "username": The username of the new user.
+     * - StringList: "operations": The names of the actions to run, any of "createuser",
+     *   "setnewuserglobaltheme", "setnewuserdisplayscaling", "seednewuserhome", "setnewusertempautologin",
+     *   "createnewuserautostarthook" and "createflagfile". "createuser" may only be the first one.
+     * - The arguments of `createuser` if the user is to be created.
+     * @return An ActionReply indicating success or failure, whose data contains:
+     * - Map: "results": The data returned by each completed operation, keyed by operation name.
+     * - StringList: "completedOperations": The operations that succeeded, in order.
+     */
+    ActionReply provisionuser(const QVariantMap &args);
+
+    /**
+     * Checks ahead of time what provisioning the new user depends on, and stages the files of their home directory.
+     *
+     * Meant to run while the user is still in the wizard, so that problems with the choices made
+     * are found before finishing rather than halfway through it. The username must not be taken
+     * yet, the extra groups must exist, and the files copied to the new home directory must be
+     * readable. Looking them up also fills the caches of the name service for the actual run.
+     *
+     * The files are copied to a staging directory only root can access, next to the home
+     * directories so they are on the same filesystem, replacing those of a previous call. Finishing then moves the staged files whose sources did not change since into
+     * the new home directory, and copies the others.
+     *
+     * @param args The arguments passed to the action, which should include:
+     * - String: "username": The username of the new user.
+     * - StringList: "extraGroups": The groups the new user is to be added to.
+     * - The arguments of SystemConfig::helperArguments().
+     * @return An ActionReply indicating success or failure, whose data contains the "extraGroups"
+     * the user will be added to, the number of "homeEntries" to be copied and the "displayManager".
+     */
+    ActionReply preparenewuser(const QVariantMap &args);
+
 private:
     /**
-     * Adds a user to the provided supplementary groups using usermod.
+     * Looks up the user given in the arguments and runs a single home directory operation for it.
      */
-    ActionReply addUserToExtraGroups(const QString &username, const QVariant &extraGroupsVariant);
+    ActionReply runHomeDirectoryOperation(const QString &operation, const QVariantMap &args);
 
     /**
-     * Copies a source file to a temporary file with permissions that allow the new user to read it.
+     * Runs the given operations writing to the home directory of the user.
      *
-     * Creates a temporary file, copies the contents from the source file, and sets permissions
-     * so that the specified user can access it. The temporary file is automatically cleaned up
-     * when the returned QTemporaryFile object is destroyed.
+     * The needed files are opened while still privileged, then privileges are dropped once for all
+     * operations and the directory tree they need is created in one go. The files staged by
+     * preparenewuser() are moved into place afterwards, with admin privileges again.
      *
-     * @param sourceFilePath The path to the source file to copy.
-     * @return A unique pointer to the QTemporaryFile on success.
-     * @throws std::runtime_error if any operation fails.
+     * @param userInfo The user whose home directory is written to.
+     * @param operations The operations to run, in order.
+     * @param results Receives the data of each completed operation.
+     * @param completedOperations Receives the names of the completed operations.
+     * @param failedOperation Receives the name of the operation that failed, if any.
+     * @param config The configuration passed along with the action.
+     * @return An ActionReply indicating success or failure.
      */
-    std::unique_ptr<QTemporaryFile> copyToTempFile(const QString &sourceFilePath);
+    ActionReply runHomeDirectoryOperations(const UserInfo &userInfo,
+                                           const SystemConfig &config,
+                                           const QStringList &operations,
+                                           QVariantMap &results,
+                                           QStringList &completedOperations,
+                                           QString &failedOperation);
+
+    /**
+     * Returns the paths copied from the plasma-setup user by the given operation.
+     */
+    static QList<HomeFiles::HomePath> homePathsForOperation(const QString &operation, const SystemConfig &config);
+
+    /**
+     * Returns the paths copied by `seednewuserhome`, relative to the home directory.
+     */
+    static QStringList newUserHomeManifest(const SystemConfig &config);
+
+    /**
+     * Writes the autostart entry removing the autologin configuration, must be called with the user's privileges.
+     *
+     * @param configDirPath The .config directory of the user.
+     * @param desktopFilePath Receives the path of the created desktop entry.
+     */
+    ActionReply writeAutostartHook(const QString &configDirPath, QString &desktopFilePath);
+
+    /**
+     * Writes the display manager configuration logging in the given user automatically once.
+     */
+    ActionReply writeTempAutologin(const UserInfo &userInfo, const DisplayManager &displayManager);
+
+    /**
+     * Creates the user account with useradd, then sets its password with chpasswd.
+     */
+    ActionReply createUserWithSubprocesses(const QString &username, const QString &fullName, const QByteArray &password, const QStringList &extraGroups);
+
+#if PLASMA_SETUP_ACCOUNTSSERVICE
+    /**
+     * Creates the user account through AccountsService, which writes the account databases in one go.
+     *
+     * The account is deleted again if it cannot be fully set up.
+     *
+     * @param serviceAvailable Set to false if AccountsService is not running, in which case
+     *                         another backend can be used instead.
+     */
+    ActionReply createUserWithAccountsService(const QString &username,
+                                              const QString &fullName,
+                                              const QByteArray &password,
+                                              const QStringList &extraGroups,
+                                              bool &serviceAvailable);
+
+    /**
+     * Deletes the account at the given AccountsService object path, along with its home directory.
+     */
+    void deleteAccountsServiceUser(const QString &userPath);
+#endif
+
+    /**
+     * Validates the supplementary groups passed by the caller.
+     *
+     * @param extraGroups Receives the trimmed group names.
+     */
+    ActionReply validateExtraGroups(const QVariant &extraGroupsVariant, QStringList &extraGroups);
+
+    /**
+     * Adds a user to the provided supplementary groups using usermod.
+     */
+    ActionReply addUserToExtraGroups(const QString &username, const QStringList &extraGroups);
 
     /**
      * Validates the given username and retrieves information about the user.
@@ -137,10 +272,11 @@ private:
      * on invalid users (e.g., system users or non-existent users).
      *
      * @param username The username to look up.
+     * @param config The configuration passed along with the action, giving the range of regular UIDs.
      * @return A UserInfo struct containing information about the user.
      * @throws std::runtime_error if the username is invalid or the user does not exist.
      */
-    UserInfo getUserInfo(const QString &username);
+    UserInfo getUserInfo(const QString &username, const SystemConfig &config);
 
     /**
      * Helper function to create an error ActionReply with the given description.
@@ -149,9 +285,4 @@ private:
      * @return An ActionReply representing the error.
      */
     ActionReply makeErrorReply(const QString &errorDescription);
-
-    /**
-     * Path to the config to the active display manager (sddm or plasmalogin)
-     */
-    static QString displayManagerConfigPath();
 };
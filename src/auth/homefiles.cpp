@@ -0,0 +1,534 @@
+// SPDX-FileCopyrightText: 2025 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "homefiles.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Size of the buffer used when a file cannot be copied within the kernel.
+ */
+constexpr size_t COPY_CHUNK_SIZE = 128 * 1024;
+
+FileDescriptor::FileDescriptor(int fd)
+    : m_fd(fd)
+{
+}
+
+FileDescriptor::~FileDescriptor()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+FileDescriptor::FileDescriptor(FileDescriptor &&other) noexcept
+    : m_fd(std::exchange(other.m_fd, -1))
+{
+}
+
+FileDescriptor &FileDescriptor::operator=(FileDescriptor &&other) noexcept
+{
+    if (this != &other) {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+        m_fd = std::exchange(other.m_fd, -1);
+    }
+    return *this;
+}
+
+int FileDescriptor::get() const
+{
+    return m_fd;
+}
+
+bool FileDescriptor::isValid() const
+{
+    return m_fd >= 0;
+}
+
+/**
+ * Names of the files of a staging directory, the staged files are in the latter.
+ */
+constexpr const char *STAGING_INDEX_NAME = "index.json";
+constexpr const char *STAGING_FILES_NAME = "home";
+
+/**
+ * Returns what identifies the contents of a source file, changing whenever the file is written to.
+ */
+static QString sourceIdentity(const struct stat &sourceStat)
+{
+    return QStringLiteral("%1:%2:%3:%4.%5:%6")
+        .arg(sourceStat.st_dev)
+        .arg(sourceStat.st_ino)
+        .arg(sourceStat.st_size)
+        .arg(sourceStat.st_mtim.tv_sec)
+        .arg(sourceStat.st_mtim.tv_nsec)
+        .arg(sourceStat.st_mode);
+}
+
+/**
+ * Opens the directory at the given relative path, one component at a time without following symbolic links.
+ *
+ * @param create Whether to create the missing directories, only accessible by their owner.
+ */
+static FileDescriptor openDirectoryAt(int parentFd, const QStringList &components, bool create)
+{
+    FileDescriptor directory(fcntl(parentFd, F_DUPFD_CLOEXEC, 0));
+    for (const QString &component : components) {
+        const QByteArray name = QFile::encodeName(component);
+        if (create && mkdirat(directory.get(), name.constData(), 0700) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Unable to create directory: " + component.toStdString() + " -- Error: " + strerror(errno));
+        }
+        FileDescriptor child(openat(directory.get(), name.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (!child.isValid()) {
+            throw std::runtime_error("Unable to open directory: " + component.toStdString() + " -- Error: " + strerror(errno));
+        }
+        directory = std::move(child);
+    }
+    return directory;
+}
+
+/**
+ * Checks that a staging directory cannot be read or written to by anyone but the current effective user.
+ */
+static void checkStagingDirectory(const FileDescriptor &directory, const QString &path)
+{
+    struct stat directoryStat;
+    if (fstat(directory.get(), &directoryStat) != 0) {
+        throw std::runtime_error("Unable to stat staging directory: " + path.toStdString() + " -- Error: " + strerror(errno));
+    }
+    if (!S_ISDIR(directoryStat.st_mode) || directoryStat.st_uid != geteuid() || (directoryStat.st_mode & 0077) != 0) {
+        throw std::runtime_error("The staging directory must only be accessible by its owner: " + path.toStdString());
+    }
+}
+
+/**
+ * Copies the contents, permission bits and timestamps of an open source file to an open destination file.
+ */
+static void copyToDescriptor(const FileDescriptor &source, const struct stat &sourceStat, int destFd)
+{
+    // Copy from the start, the same descriptor may be copied to several destinations
+    if (lseek(source.get(), 0, SEEK_SET) != 0) {
+        throw std::runtime_error(std::string("Unable to rewind source file: ") + strerror(errno));
+    }
+
+    HomeFiles::streamFile(source.get(), destFd);
+
+    // The mode passed to open() only applies to new files and is subject to the umask
+    if (fchmod(destFd, sourceStat.st_mode & 0777) != 0) {
+        throw std::runtime_error(std::string("Unable to set permissions on destination file: ") + strerror(errno));
+    }
+
+    const struct timespec times[2] = {sourceStat.st_atim, sourceStat.st_mtim};
+    if (futimens(destFd, times) != 0) {
+        throw std::runtime_error(std::string("Unable to set timestamps on destination file: ") + strerror(errno));
+    }
+}
+
+/**
+ * Returns the names of the entries of the given directory, sorted.
+ */
+static std::vector<QByteArray> directoryEntries(int directoryFd)
+{
+    // closedir() closes the descriptor it was given, so it gets a duplicate
+    DIR *directory = fdopendir(fcntl(directoryFd, F_DUPFD_CLOEXEC, 0));
+    if (!directory) {
+        throw std::runtime_error(std::string("Unable to list directory: ") + strerror(errno));
+    }
+    rewinddir(directory);
+
+    std::vector<QByteArray> names;
+    while (const dirent *entry = readdir(directory)) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    closedir(directory);
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+/**
+ * Opens the entry with the given name of a directory of the home, recursing into it if it is a directory.
+ */
+static void collectHomeEntry(int parentFd,
+                             const QByteArray &name,
+                             const QString &relativePath,
+                             bool optional,
+                             std::vector<HomeFiles::HomeEntry> &entries,
+                             QSet<QString> &collectedPaths)
+{
+    if (collectedPaths.contains(relativePath)) {
+        return;
+    }
+
+    HomeFiles::HomeEntry entry;
+    entry.relativePath = relativePath;
+    if (fstatat(parentFd, name.constData(), &entry.sourceStat, AT_SYMLINK_NOFOLLOW) != 0) {
+        if (errno == ENOENT && optional) {
+            return;
+        }
+        throw std::runtime_error("Unable to open source file: " + relativePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+
+    // Never follow symbolic links, they could point to files the new user must not be able to read
+    if (S_ISLNK(entry.sourceStat.st_mode) || (!S_ISREG(entry.sourceStat.st_mode) && !S_ISDIR(entry.sourceStat.st_mode))) {
+        return;
+    }
+
+    const int flags = O_RDONLY | O_CLOEXEC | O_NOFOLLOW | (S_ISDIR(entry.sourceStat.st_mode) ? O_DIRECTORY : O_NONBLOCK);
+    FileDescriptor source(openat(parentFd, name.constData(), flags));
+    if (!source.isValid()) {
+        // Replaced by a symbolic link since
+        if (errno == ELOOP || errno == ENOTDIR) {
+            return;
+        }
+        throw std::runtime_error("Unable to open source file: " + relativePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+
+    // What was opened is what was looked at, and not something swapped in between
+    struct stat openedStat;
+    if (fstat(source.get(), &openedStat) != 0) {
+        throw std::runtime_error("Unable to stat source file: " + relativePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+    if (openedStat.st_dev != entry.sourceStat.st_dev || openedStat.st_ino != entry.sourceStat.st_ino) {
+        throw std::runtime_error("Source file changed while being opened: " + relativePath.toStdString());
+    }
+    entry.sourceStat = openedStat;
+
+    collectedPaths.insert(relativePath);
+
+    if (S_ISREG(entry.sourceStat.st_mode)) {
+        // Only needed to not block on a FIFO swapped in, reads are blocking again
+        fcntl(source.get(), F_SETFL, fcntl(source.get(), F_GETFL) & ~O_NONBLOCK);
+        entry.source = std::move(source);
+        entries.push_back(std::move(entry));
+        return;
+    }
+
+    entries.push_back(std::move(entry));
+
+    for (const QByteArray &child : directoryEntries(source.get())) {
+        collectHomeEntry(source.get(), child, relativePath + QLatin1Char('/') + QFile::decodeName(child), true, entries, collectedPaths);
+    }
+}
+
+namespace HomeFiles
+{
+
+FileDescriptor openDirectory(const QString &path)
+{
+    FileDescriptor directory(open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (!directory.isValid()) {
+        throw std::runtime_error("Unable to open directory: " + path.toStdString() + " -- Error: " + strerror(errno));
+    }
+    return directory;
+}
+
+void collectHomeEntries(const FileDescriptor &homeDirectory, const HomePath &homePath, std::vector<HomeEntry> &entries, QSet<QString> &collectedPaths)
+{
+    // Only accept paths inside the home directory
+    const QString relativePath = QDir::cleanPath(homePath.relativePath.trimmed());
+    if (relativePath.isEmpty() || relativePath == QLatin1String(".") || QDir::isAbsolutePath(relativePath) || relativePath == QLatin1String("..")
+        || relativePath.startsWith(QLatin1String("../"))) {
+        throw std::runtime_error("Invalid path in the new user home manifest: " + homePath.relativePath.toStdString());
+    }
+
+    if (collectedPaths.contains(relativePath)) {
+        return;
+    }
+
+    // Walk down to the parent directory one component at a time, refusing symbolic links on the way
+    const QStringList components = relativePath.split(QLatin1Char('/'));
+    FileDescriptor parent;
+    int parentFd = homeDirectory.get();
+    for (qsizetype i = 0; i < components.size() - 1; ++i) {
+        FileDescriptor directory(openat(parentFd, QFile::encodeName(components.at(i)).constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+        if (!directory.isValid()) {
+            if (errno == ELOOP || (errno == ENOTDIR && homePath.optional) || (errno == ENOENT && homePath.optional)) {
+                return;
+            }
+            throw std::runtime_error("Unable to open source directory: " + components.first(i + 1).join(QLatin1Char('/')).toStdString()
+                                     + " -- Error: " + strerror(errno));
+        }
+        parent = std::move(directory);
+        parentFd = parent.get();
+    }
+
+    collectHomeEntry(parentFd, QFile::encodeName(components.last()), relativePath, homePath.optional, entries, collectedPaths);
+}
+
+bool hasSameContents(const FileDescriptor &source, const struct stat &sourceStat, const QString &destFilePath)
+{
+    const FileDescriptor destFile(open(QFile::encodeName(destFilePath).constData(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW));
+    if (!destFile.isValid()) {
+        return false;
+    }
+
+    struct stat destStat;
+    if (fstat(destFile.get(), &destStat) != 0 || !S_ISREG(destStat.st_mode) || destStat.st_size != sourceStat.st_size
+        || (destStat.st_mode & 0777) != (sourceStat.st_mode & 0777)) {
+        return false;
+    }
+
+    std::vector<char> sourceBuffer(COPY_CHUNK_SIZE);
+    std::vector<char> destBuffer(COPY_CHUNK_SIZE);
+    for (off_t offset = 0; offset < sourceStat.st_size;) {
+        const ssize_t sourceRead = pread(source.get(), sourceBuffer.data(), sourceBuffer.size(), offset);
+        if (sourceRead <= 0) {
+            return false;
+        }
+        const ssize_t destRead = pread(destFile.get(), destBuffer.data(), sourceRead, offset);
+        if (destRead != sourceRead || memcmp(sourceBuffer.data(), destBuffer.data(), sourceRead) != 0) {
+            return false;
+        }
+        offset += sourceRead;
+    }
+
+    return true;
+}
+
+std::unique_ptr<QTemporaryFile> copyToTempFile(const QString &sourceFilePath)
+{
+    // Create a temporary file
+    auto tempFile = std::make_unique<QTemporaryFile>();
+
+    if (!tempFile->open()) {
+        throw std::runtime_error("Unable to create temporary file: " + tempFile->errorString().toStdString());
+    }
+
+    // Stream the source file to the temp file
+    const FileDescriptor sourceFile = openSourceFile(sourceFilePath);
+    streamFile(sourceFile.get(), tempFile->handle());
+
+    // Set file permissions to be readable by everyone, so the new user can access it.
+    if (fchmod(tempFile->handle(), 0644) != 0) {
+        throw std::runtime_error("Unable to set permissions on temporary file: error code " + std::to_string(errno));
+    }
+
+    return tempFile;
+}
+
+FileDescriptor openSourceFile(const QString &sourceFilePath)
+{
+    FileDescriptor sourceFile(open(QFile::encodeName(sourceFilePath).constData(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW));
+    if (!sourceFile.isValid()) {
+        throw std::runtime_error("Unable to open source file: " + sourceFilePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+    return sourceFile;
+}
+
+void copyToFile(const FileDescriptor &source, const QString &destFilePath)
+{
+    struct stat sourceStat;
+    if (fstat(source.get(), &sourceStat) != 0) {
+        throw std::runtime_error(std::string("Unable to stat source file: ") + strerror(errno));
+    }
+
+    const FileDescriptor destFile(
+        open(QFile::encodeName(destFilePath).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, sourceStat.st_mode & 0777));
+    if (!destFile.isValid()) {
+        throw std::runtime_error("Unable to open destination file: " + destFilePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+
+    copyToDescriptor(source, sourceStat, destFile.get());
+}
+
+FileDescriptor createStagingDirectory(const QString &path)
+{
+    // Start over from an empty directory, so only files staged by this call are in it
+    removeStagingDirectory(path);
+    if (mkdir(QFile::encodeName(path).constData(), 0700) != 0) {
+        throw std::runtime_error("Unable to create staging directory: " + path.toStdString() + " -- Error: " + strerror(errno));
+    }
+
+    FileDescriptor directory = openDirectory(path);
+    checkStagingDirectory(directory, path);
+    return directory;
+}
+
+FileDescriptor openStagingDirectory(const QString &path)
+{
+    FileDescriptor directory(open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+    if (!directory.isValid()) {
+        if (errno == ENOENT) {
+            return directory;
+        }
+        throw std::runtime_error("Unable to open staging directory: " + path.toStdString() + " -- Error: " + strerror(errno));
+    }
+
+    checkStagingDirectory(directory, path);
+    return directory;
+}
+
+void removeStagingDirectory(const QString &path)
+{
+    QDir(path).removeRecursively();
+}
+
+void stageEntries(const FileDescriptor &stagingDirectory, const std::vector<HomeEntry> &entries)
+{
+    const FileDescriptor filesDirectory = openDirectoryAt(stagingDirectory.get(), {QString::fromLatin1(STAGING_FILES_NAME)}, true);
+
+    QJsonObject index;
+    for (const HomeEntry &entry : entries) {
+        if (!entry.source.isValid()) {
+            continue;
+        }
+
+        QStringList components = entry.relativePath.split(QLatin1Char('/'));
+        const QByteArray name = QFile::encodeName(components.takeLast());
+        const FileDescriptor parent = openDirectoryAt(filesDirectory.get(), components, true);
+        const FileDescriptor destFile(openat(parent.get(), name.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC | O_NOFOLLOW, 0600));
+        if (!destFile.isValid()) {
+            throw std::runtime_error("Unable to stage file: " + entry.relativePath.toStdString() + " -- Error: " + strerror(errno));
+        }
+
+        // Identified as it was opened, a source modified since is not taken from the staging directory
+        copyToDescriptor(entry.source, entry.sourceStat, destFile.get());
+        index.insert(entry.relativePath, sourceIdentity(entry.sourceStat));
+    }
+
+    // Written last, files staged by an interrupted call are never used
+    const QByteArray indexData = QJsonDocument(index).toJson(QJsonDocument::Compact);
+    const FileDescriptor indexFile(openat(stagingDirectory.get(), STAGING_INDEX_NAME, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC | O_NOFOLLOW, 0600));
+    if (!indexFile.isValid() || write(indexFile.get(), indexData.constData(), indexData.size()) != indexData.size()) {
+        throw std::runtime_error(std::string("Unable to write the staging index: ") + strerror(errno));
+    }
+}
+
+QSet<QString> stagedFiles(const FileDescriptor &stagingDirectory, const std::vector<HomeEntry> &entries)
+{
+    QSet<QString> staged;
+
+    const FileDescriptor indexFile(openat(stagingDirectory.get(), STAGING_INDEX_NAME, O_RDONLY | O_CLOEXEC | O_NOFOLLOW));
+    if (!indexFile.isValid()) {
+        return staged;
+    }
+
+    QByteArray indexData;
+    char buffer[16384];
+    ssize_t bytesRead;
+    while ((bytesRead = read(indexFile.get(), buffer, sizeof(buffer))) != 0) {
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return staged;
+        }
+        indexData.append(buffer, bytesRead);
+    }
+    const QJsonObject index = QJsonDocument::fromJson(indexData).object();
+
+    for (const HomeEntry &entry : entries) {
+        if (entry.source.isValid() && index.value(entry.relativePath).toString() == sourceIdentity(entry.sourceStat)) {
+            staged.insert(entry.relativePath);
+        }
+    }
+    return staged;
+}
+
+void moveStagedFile(const FileDescriptor &stagingDirectory, const QString &relativePath, const FileDescriptor &destDirectory, uid_t uid, gid_t gid)
+{
+    QStringList components = relativePath.split(QLatin1Char('/'));
+    const QByteArray name = QFile::encodeName(components.takeLast());
+    const FileDescriptor sourceParent = openDirectoryAt(stagingDirectory.get(), QStringList{QString::fromLatin1(STAGING_FILES_NAME)} + components, false);
+    const FileDescriptor destParent = openDirectoryAt(destDirectory.get(), components, false);
+
+    if (fchownat(sourceParent.get(), name.constData(), uid, gid, AT_SYMLINK_NOFOLLOW) != 0) {
+        throw std::runtime_error("Unable to change the owner of staged file: " + relativePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+    if (renameat(sourceParent.get(), name.constData(), destParent.get(), name.constData()) != 0) {
+        throw std::runtime_error("Unable to move staged file: " + relativePath.toStdString() + " -- Error: " + strerror(errno));
+    }
+}
+
+void streamFile(int sourceFd, int destFd)
+{
+    // Let the kernel copy the data, possibly without it ever reaching userspace
+    bool inKernelCopy = true;
+    while (inKernelCopy) {
+        const ssize_t copied = copy_file_range(sourceFd, nullptr, destFd, nullptr, COPY_CHUNK_SIZE * 8, 0);
+        if (copied > 0) {
+            continue;
+        }
+        if (copied == 0) {
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP && errno != EBADF) {
+            throw std::runtime_error(std::string("Unable to copy file contents: ") + strerror(errno));
+        }
+        inKernelCopy = false;
+    }
+
+    // copy_file_range() is not supported for these files, sendfile() still avoids the userspace copy
+    bool sendfileCopy = true;
+    while (sendfileCopy) {
+        const ssize_t copied = sendfile(destFd, sourceFd, nullptr, COPY_CHUNK_SIZE * 8);
+        if (copied > 0) {
+            continue;
+        }
+        if (copied == 0) {
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EINVAL && errno != ENOSYS) {
+            throw std::runtime_error(std::string("Unable to copy file contents: ") + strerror(errno));
+        }
+        sendfileCopy = false;
+    }
+
+    // Fall back to copying in fixed-size chunks
+    std::vector<char> buffer(COPY_CHUNK_SIZE);
+    while (true) {
+        const ssize_t bytesRead = read(sourceFd, buffer.data(), buffer.size());
+        if (bytesRead == 0) {
+            return;
+        }
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Unable to read source file: ") + strerror(errno));
+        }
+
+        ssize_t bytesWritten = 0;
+        while (bytesWritten < bytesRead) {
+            const ssize_t written = write(destFd, buffer.data() + bytesWritten, bytesRead - bytesWritten);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Unable to write destination file: ") + strerror(errno));
+            }
+            bytesWritten += written;
+        }
+    }
+}
+
+}
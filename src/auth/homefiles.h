@@ -0,0 +1,194 @@
+// SPDX-FileCopyrightText: 2025 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QTemporaryFile>
+
+#include <sys/stat.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * Owns a file descriptor and closes it when going out of scope.
+ */
+class FileDescriptor
+{
+public:
+    explicit FileDescriptor(int fd = -1);
+    ~FileDescriptor();
+
+    FileDescriptor(FileDescriptor &&other) noexcept;
+    FileDescriptor &operator=(FileDescriptor &&other) noexcept;
+
+    /** The file descriptor, or -1 if none is held. */
+    int get() const;
+
+    bool isValid() const;
+
+private:
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    int m_fd;
+};
+
+/**
+ * Copying of the files of the plasma-setup home directory to the new user, used by the auth helper.
+ *
+ * Errors are reported by throwing std::runtime_error.
+ */
+namespace HomeFiles
+{
+
+/**
+ * A path in the plasma-setup home directory copied by a home directory operation.
+ */
+struct HomePath {
+    /** The path relative to the home directory. */
+    QString relativePath;
+
+    /** Whether the path is skipped if it does not exist, instead of failing the operation. */
+    bool optional;
+};
+
+/**
+ * A file or directory of the plasma-setup home copied to the new user.
+ */
+struct HomeEntry {
+    /** The path relative to the home directory. */
+    QString relativePath;
+
+    /** The opened source file, invalid for directories. */
+    FileDescriptor source;
+
+    /** The metadata of the source, applied to the copy. */
+    struct stat sourceStat;
+};
+
+/**
+ * Opens the given directory to read files from it with collectHomeEntries().
+ *
+ * @throws std::runtime_error if the path is not a directory or is a symbolic link.
+ */
+FileDescriptor openDirectory(const QString &path);
+
+/**
+ * Opens the given path of a home directory, recursing into directories.
+ *
+ * Every component of the path is opened relative to its parent directory without following
+ * symbolic links, so the path cannot lead outside of the home directory. Paths going through
+ * a symbolic link are skipped, they could point to files the new user must not be able to read.
+ *
+ * @param homeDirectory The home directory, see openDirectory().
+ * @param homePath The path to collect.
+ * @param entries Receives the opened files and directories.
+ * @param collectedPaths The paths collected so far, which are not collected again.
+ * @throws std::runtime_error if the path is invalid or a file cannot be opened.
+ */
+void collectHomeEntries(const FileDescriptor &homeDirectory, const HomePath &homePath, std::vector<HomeEntry> &entries, QSet<QString> &collectedPaths);
+
+/**
+ * Returns whether the destination is a regular file with the same contents and permissions as the source.
+ */
+bool hasSameContents(const FileDescriptor &source, const struct stat &sourceStat, const QString &destFilePath);
+
+/**
+ * Copies a source file to a temporary file with permissions that allow the new user to read it.
+ *
+ * Creates a temporary file, copies the contents from the source file, and sets permissions
+ * so that the specified user can access it. The temporary file is automatically cleaned up
+ * when the returned QTemporaryFile object is destroyed.
+ *
+ * Prefer passing the descriptor from openSourceFile() to copyToFile() instead, which
+ * avoids the intermediate copy.
+ *
+ * @param sourceFilePath The path to the source file to copy.
+ * @return A unique pointer to the QTemporaryFile on success.
+ * @throws std::runtime_error if any operation fails.
+ */
+std::unique_ptr<QTemporaryFile> copyToTempFile(const QString &sourceFilePath);
+
+/**
+ * Opens a source file for reading, to be copied later on with copyToFile().
+ *
+ * Meant to be called while still privileged, the descriptor stays readable after
+ * privileges have been dropped.
+ *
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+FileDescriptor openSourceFile(const QString &sourceFilePath);
+
+/**
+ * Copies the contents of an open source file to the given path, replacing it if it exists.
+ *
+ * The file gets the permission bits and timestamps of the source, and is owned by the current
+ * effective user. Symbolic links at the destination are not followed.
+ *
+ * @throws std::runtime_error if any operation fails.
+ */
+void copyToFile(const FileDescriptor &source, const QString &destFilePath);
+
+/**
+ * Creates an empty staging directory at the given path, removing a previous one.
+ *
+ * Files are copied to the staging directory ahead of time with stageEntries(), so they only
+ * need to be moved into place once the new user exists, see moveStagedFile().
+ *
+ * @throws std::runtime_error if the directory cannot be created, or is not only accessible by the
+ * current effective user.
+ */
+FileDescriptor createStagingDirectory(const QString &path);
+
+/**
+ * Opens the staging directory created by createStagingDirectory(), or returns an invalid descriptor if there is none.
+ *
+ * @throws std::runtime_error if the directory is not only accessible by the current effective user.
+ */
+FileDescriptor openStagingDirectory(const QString &path);
+
+/**
+ * Removes the given staging directory along with its contents.
+ */
+void removeStagingDirectory(const QString &path);
+
+/**
+ * Copies the files of the given entries to a staging directory, keeping their permissions and timestamps.
+ *
+ * The identity of each source file is recorded alongside, for stagedFiles() to check it later on.
+ *
+ * @throws std::runtime_error if any operation fails.
+ */
+void stageEntries(const FileDescriptor &stagingDirectory, const std::vector<HomeEntry> &entries);
+
+/**
+ * Returns the relative paths of the entries whose files are staged and whose sources did not change since.
+ */
+QSet<QString> stagedFiles(const FileDescriptor &stagingDirectory, const std::vector<HomeEntry> &entries);
+
+/**
+ * Moves a staged file to the same path relative to the given directory, replacing the file there.
+ *
+ * The parent directories must already exist, they are opened without following symbolic links.
+ * The file is given to the given owner before being moved.
+ *
+ * @throws std::runtime_error if any operation fails, such as the directories being on different filesystems.
+ */
+void moveStagedFile(const FileDescriptor &stagingDirectory, const QString &relativePath, const FileDescriptor &destDirectory, uid_t uid, gid_t gid);
+
+/**
+ * Streams the remaining contents of one file descriptor to another.
+ *
+ * Uses copy_file_range() so the data can stay in the kernel, or is even reflinked, falling
+ * back to sendfile() and then to plain chunked reads and writes if that is not supported.
+ *
+ * @throws std::runtime_error if any operation fails.
+ */
+void streamFile(int sourceFd, int destFd);
+
+}
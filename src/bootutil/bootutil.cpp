@@ -3,106 +3,133 @@
 
 #include "bootutil.h"
 
-#include "plasmasetup_bootutil_debug.h"
+#include "displaymanager.h"
 
-#include <KConfig>
-#include <KConfigGroup>
-#include <KSharedConfig>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
 
-#include <QDBusConnection>
-#include <QDBusReply>
-#include <QDir>
-#include <QFile>
-#include <QFileInfo>
-#include <QProcess>
-#include <QTextStream>
+namespace fs = std::filesystem;
 
 /**
- * Path to the SDDM autologin configuration file.
+ * The SDDM configuration written by the SDDM KCM, which may contain an empty autologin entry.
  */
-const QString SDDM_AUTOLOGIN_CONFIG_PATH = QStringLiteral("/etc/sddm.conf.d/99-plasma-setup.conf");
+const fs::path SDDM_KDE_SETTINGS_PATH = "/etc/sddm.conf.d/kde_settings.conf";
 
 /**
- * Path to the PlasmaLogin autologin configuration file.
+ * Returns the given line without leading and trailing whitespace.
  */
-const QString PLASMALOGIN_AUTOLOGIN_CONFIG_PATH = QStringLiteral("/etc/plasmalogin.conf.d/99-plasma-setup.conf");
-
-/**
- * Path to the config to the active display manager (sddm or plasmalogin)
- */
-static QString displayManagerConfigPath()
+static std::string_view trimmed(std::string_view line)
 {
-    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.systemd1"),
-                                                      QStringLiteral("/org/freedesktop/systemd1"),
-                                                      QStringLiteral("org.freedesktop.systemd1.Manager"),
-                                                      QStringLiteral("GetUnitFileState"));
-    msg << QStringLiteral("plasmalogin.service");
-
-    QDBusReply<QString> usingPlasmaLoginQuery = QDBusConnection::systemBus().call(msg);
-    if (usingPlasmaLoginQuery.value() == QLatin1String("enabled")) {
-        return PLASMALOGIN_AUTOLOGIN_CONFIG_PATH;
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+        return {};
     }
-    return SDDM_AUTOLOGIN_CONFIG_PATH;
-}
-
-BootUtil::BootUtil(QObject *parent)
-    : QObject(parent)
-{
+    const auto last = line.find_last_not_of(" \t\r");
+    return line.substr(first, last - first + 1);
 }
 
 bool BootUtil::writeDisplayManagerAutologin(const bool autoLogin)
 {
-    // Make sure the directory exists
-    const QString configFilePath = displayManagerConfigPath();
-    QFileInfo fileInfo(configFilePath);
-    QDir dir = fileInfo.dir();
+    const fs::path configFilePath = DisplayManager::active().autologinConfigPath;
+    std::error_code error;
 
     // If autologin is to be disabled, remove the file if it exists
     if (!autoLogin) {
-        if (fileInfo.exists()) {
-            if (!QFile::remove(fileInfo.filePath())) {
-                qCWarning(PlasmaSetupBootUtil) << "Failed to remove file:" << fileInfo.filePath();
-                return false;
-            }
+        fs::remove(configFilePath, error);
+        if (error) {
+            std::cerr << "Failed to remove file: " << configFilePath << ": " << error.message() << '\n';
+            return false;
         }
         return true;
     }
 
-    if (!dir.exists() && !dir.mkpath(QStringLiteral("."))) {
-        qCWarning(PlasmaSetupBootUtil) << "Failed to create directory:" << dir.absolutePath();
+    // Make sure the directory exists
+    fs::create_directories(configFilePath.parent_path(), error);
+    if (error) {
+        std::cerr << "Failed to create directory: " << configFilePath.parent_path() << ": " << error.message() << '\n';
         return false;
     }
 
-    QFile file(configFilePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qCWarning(PlasmaSetupBootUtil) << "Failed to open file for writing:" << file.fileName();
+    // Write the autologin configuration
+    const std::string autologinConfig = DisplayManager::active().autologinConfig("plasma-setup", "plasma", false);
+    if (!writeFileAtomically(configFilePath, autologinConfig)) {
         return false;
     }
 
-    // Write the autologin configuration
-    QTextStream stream(&file);
-    stream << "[Autologin]\n";
-    stream << "User=plasma-setup\n";
-    stream << "Session=plasma\n";
-    file.close();
-
     removeEmptyAutologinEntry();
 
-    qCInfo(PlasmaSetupBootUtil) << "Display Manager autologin configuration written successfully.";
+    std::cout << "Display Manager autologin configuration written successfully.\n";
     return true;
 }
 
 void BootUtil::removeEmptyAutologinEntry()
 {
-    const QString configFilePath = QStringLiteral("/etc/sddm.conf.d/kde_settings.conf");
+    std::ifstream input(SDDM_KDE_SETTINGS_PATH);
+    if (!input) {
+        // Nothing to clean up
+        return;
+    }
 
-    KSharedConfigPtr config = KSharedConfig::openConfig(configFilePath);
-    config->deleteGroup(QStringLiteral("Autologin"));
-    config->sync();
+    // Copy everything but the [Autologin] group, which ends at the next group header
+    std::string contents;
+    std::string line;
+    bool inAutologinGroup = false;
+    bool removed = false;
+    while (std::getline(input, line)) {
+        const std::string_view key = trimmed(line);
+        if (key.starts_with('[')) {
+            inAutologinGroup = key == "[Autologin]";
+            removed = removed || inAutologinGroup;
+        }
+        if (!inAutologinGroup) {
+            contents += line;
+            contents += '\n';
+        }
+    }
+    input.close();
 
-    qCInfo(PlasmaSetupBootUtil) << "Removed empty autologin group from SDDM configuration.";
+    if (!removed) {
+        return;
+    }
+
+    if (writeFileAtomically(SDDM_KDE_SETTINGS_PATH, contents)) {
+        std::cout << "Removed empty autologin group from SDDM configuration.\n";
+    }
 }
 
-#include "bootutil.moc"
+bool BootUtil::writeFileAtomically(const fs::path &path, std::string_view contents)
+{
+    fs::path temporaryPath = path;
+    temporaryPath += ".new";
+
+    {
+        std::ofstream output(temporaryPath, std::ios::out | std::ios::trunc);
+        output << contents;
+        output.close();
+        if (!output) {
+            std::cerr << "Failed to write file: " << temporaryPath << '\n';
+            std::error_code ignored;
+            fs::remove(temporaryPath, ignored);
+            return false;
+        }
+    }
+
+    std::error_code error;
 
-#include "moc_bootutil.cpp"
+    // Keep the permissions of the file being replaced
+    const fs::file_status status = fs::status(path, error);
+    if (!error && fs::exists(status)) {
+        fs::permissions(temporaryPath, status.permissions(), error);
+    }
+
+    fs::rename(temporaryPath, path, error);
+    if (error) {
+        std::cerr << "Failed to replace file: " << path << ": " << error.message() << '\n';
+        fs::remove(temporaryPath, error);
+        return false;
+    }
+
+    return true;
+}
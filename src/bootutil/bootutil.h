@@ -3,15 +3,18 @@
 
 #pragma once
 
-#include <QObject>
+#include <filesystem>
+#include <string_view>
 
-class BootUtil : public QObject
+/**
+ * Sets up the display manager so that it logs into the Plasma Setup session.
+ *
+ * This runs before the display manager starts, so it directly adds to the boot time. It is
+ * therefore kept free of Qt, KConfig and D-Bus, and only touches a few small files.
+ */
+class BootUtil
 {
-    Q_OBJECT
-
 public:
-    explicit BootUtil(QObject *parent = nullptr);
-
     /**
      * Writes the autologin configuration.
      *
@@ -31,4 +34,11 @@ private:
      * from being applied correctly.
      */
     void removeEmptyAutologinEntry();
+
+    /**
+     * Replaces the contents of a file, so that readers see either the old or the new contents.
+     *
+     * The contents are written to a temporary file next to it, which is then renamed over the file.
+     */
+    static bool writeFileAtomically(const std::filesystem::path &path, std::string_view contents);
 };
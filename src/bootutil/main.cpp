@@ -3,24 +3,26 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "bootutil.h"
-#include "plasmasetup_bootutil_debug.h"
 
-#include <QCoreApplication>
-#include <QDebug>
+#include <chrono>
+#include <iostream>
 
 /**
     Small utility that sets up the environment for Plasma Setup to run at boot time.
 
     Should be run early in the boot sequence, before the display manager starts.
  */
-int main(int argc, char *argv[])
+int main()
 {
-    qCInfo(PlasmaSetupBootUtil) << "Plasma Setup Boot Utility started.";
-
-    QCoreApplication app(argc, argv);
+    const auto start = std::chrono::steady_clock::now();
+    std::cout << "Plasma Setup Boot Utility started.\n";
 
     BootUtil bootUtil;
-
     bootUtil.writeDisplayManagerAutologin(true);
+
+    // The unit delays the display manager, so keep an eye on how long this takes
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Plasma Setup Boot Utility finished in " << elapsed.count() / 1000.0 << " ms.\n";
+
     return 0;
 }
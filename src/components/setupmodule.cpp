@@ -23,6 +23,20 @@ void SetupModule::setNextEnabled(bool nextEnabled)
     Q_EMIT nextEnabledChanged();
 }
 
+bool SetupModule::unloadable() const
+{
+    return m_unloadable;
+}
+
+void SetupModule::setUnloadable(bool unloadable)
+{
+    if (m_unloadable == unloadable) {
+        return;
+    }
+    m_unloadable = unloadable;
+    Q_EMIT unloadableChanged();
+}
+
 bool SetupModule::available() const
 {
     return m_available;
@@ -37,6 +51,20 @@ void SetupModule::setAvailable(bool available)
     Q_EMIT availableChanged();
 }
 
+bool SetupModule::availabilityPending() const
+{
+    return m_availabilityPending;
+}
+
+void SetupModule::setAvailabilityPending(bool availabilityPending)
+{
+    if (m_availabilityPending == availabilityPending) {
+        return;
+    }
+    m_availabilityPending = availabilityPending;
+    Q_EMIT availabilityPendingChanged();
+}
+
 QQuickItem *SetupModule::contentItem() const
 {
     return m_contentItem;
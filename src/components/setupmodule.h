@@ -15,8 +15,30 @@ class SetupModule : public QObject
     QML_ELEMENT
 
     Q_PROPERTY(bool available READ available WRITE setAvailable NOTIFY availableChanged)
+
+    /**
+     * Whether the module is still working out if it is available.
+     *
+     * Modules whose availability depends on slow work (e.g. enumerating users) can set this
+     * to true until `available` is final. The wizard only starts once every pending module
+     * has settled, or once the availability timeout of the pages model has passed.
+     */
+    Q_PROPERTY(bool availabilityPending READ availabilityPending WRITE setAvailabilityPending NOTIFY availabilityPendingChanged)
     Q_PROPERTY(qreal cardWidth READ cardWidth WRITE setCardWidth NOTIFY cardWidthChanged)
     Q_PROPERTY(bool nextEnabled READ nextEnabled WRITE setNextEnabled NOTIFY nextEnabledChanged)
+
+    /**
+     * Whether the wizard may destroy this page while it is far behind the current page, and
+     * recreate it when the user navigates back to it.
+     *
+     * Only enable this for modules that keep their state in a backend (e.g. a util singleton)
+     * rather than in their own items, since that state is lost when the page is destroyed.
+     *
+     * Before the page is destroyed, the wizard calls its onPageReleased() function if it has one.
+     * Modules use it to drop what their backend only keeps for the page, such as models, which
+     * the backend then rebuilds when the page is recreated.
+     */
+    Q_PROPERTY(bool unloadable READ unloadable WRITE setUnloadable NOTIFY unloadableChanged)
     Q_PROPERTY(QQuickItem *contentItem READ contentItem WRITE setContentItem REQUIRED NOTIFY contentItemChanged)
     Q_PROPERTY(QQmlListProperty<QObject> children READ children CONSTANT)
     Q_CLASSINFO("DefaultProperty", "children")
@@ -27,6 +49,9 @@ public:
     [[nodiscard]] bool available() const;
     void setAvailable(bool available);
 
+    [[nodiscard]] bool availabilityPending() const;
+    void setAvailabilityPending(bool availabilityPending);
+
     [[nodiscard]] qreal cardWidth() const;
     void setCardWidth(qreal cardWidth);
 
@@ -36,17 +61,24 @@ public:
     [[nodiscard]] bool nextEnabled() const;
     void setNextEnabled(bool nextEnabled);
 
+    [[nodiscard]] bool unloadable() const;
+    void setUnloadable(bool unloadable);
+
     [[nodiscard]] QQmlListProperty<QObject> children();
 
 Q_SIGNALS:
     void availableChanged();
+    void availabilityPendingChanged();
     void contentItemChanged();
     void nextEnabledChanged();
     void cardWidthChanged();
+    void unloadableChanged();
 
 private:
     bool m_available{true};
+    bool m_availabilityPending = false;
     bool m_nextEnabled = true;
+    bool m_unloadable = false;
     QQuickItem *m_contentItem{nullptr};
     QList<QObject *> m_children;
     qreal m_cardWidth;
@@ -4,6 +4,7 @@
 
 #include "displayutil.h"
 #include "plasmasetup_debug.h"
+#include "systemconfig.h"
 
 #include <KAuth/Action>
 #include <KAuth/ExecuteJob>
@@ -19,14 +20,7 @@ DisplayUtil::DisplayUtil(QObject *parent)
 
 void DisplayUtil::setGlobalThemeForNewUser(QWindow *window, QString userName)
 {
-    qCInfo(PlasmaSetup) << "Setting global theme for new user.";
-
-    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.setnewuserglobaltheme"));
-    action.setParentWindow(window);
-    action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
-    action.addArgument(QStringLiteral("username"), userName);
-
-    KAuth::ExecuteJob *job = action.execute();
+    KAuth::ExecuteJob *job = globalThemeForNewUserJob(window, userName);
 
     if (!job->exec()) {
         qCWarning(PlasmaSetup) << "Failed to set global theme for new user:" << job->errorString();
@@ -36,21 +30,40 @@ void DisplayUtil::setGlobalThemeForNewUser(QWindow *window, QString userName)
 }
 
 void DisplayUtil::setScalingForNewUser(QWindow *window, QString userName)
+{
+    KAuth::ExecuteJob *job = scalingForNewUserJob(window, userName);
+
+    if (!job->exec()) {
+        qCWarning(PlasmaSetup) << "Failed to set scaling for new user:" << job->errorString();
+    } else {
+        qCInfo(PlasmaSetup) << "Set scaling for new user.";
+    }
+}
+
+KAuth::ExecuteJob *DisplayUtil::globalThemeForNewUserJob(QWindow *window, const QString &userName)
+{
+    qCInfo(PlasmaSetup) << "Setting global theme for new user.";
+
+    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.setnewuserglobaltheme"));
+    action.setParentWindow(window);
+    action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
+    action.setArguments(SystemConfig::instance().helperArguments());
+    action.addArgument(QStringLiteral("username"), userName);
+
+    return action.execute();
+}
+
+KAuth::ExecuteJob *DisplayUtil::scalingForNewUserJob(QWindow *window, const QString &userName)
 {
     qCInfo(PlasmaSetup) << "Setting scaling for new user:" << userName;
 
     KAuth::Action action(QStringLiteral("org.kde.plasmasetup.setnewuserdisplayscaling"));
     action.setParentWindow(window);
     action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
+    action.setArguments(SystemConfig::instance().helperArguments());
     action.addArgument(QStringLiteral("username"), userName);
 
-    KAuth::ExecuteJob *job = action.execute();
-
-    if (!job->exec()) {
-        qCWarning(PlasmaSetup) << "Failed to set scaling for new user:" << job->errorString();
-    } else {
-        qCInfo(PlasmaSetup) << "Set scaling for new user.";
-    }
+    return action.execute();
 }
 
 #include "moc_displayutil.cpp"
@@ -7,6 +7,11 @@
 #include <QObject>
 #include <QWindow>
 
+namespace KAuth
+{
+class ExecuteJob;
+}
+
 /**
  * Utility class for managing display settings for new users.
  */
@@ -20,6 +25,16 @@ public:
     void setGlobalThemeForNewUser(QWindow *window, QString userName);
     void setScalingForNewUser(QWindow *window, QString userName);
 
+    /**
+     * Prepares the job applying the global theme of this session to the new user, without starting it.
+     */
+    static KAuth::ExecuteJob *globalThemeForNewUserJob(QWindow *window, const QString &userName);
+
+    /**
+     * Prepares the job applying the display scaling of this session to the new user, without starting it.
+     */
+    static KAuth::ExecuteJob *scalingForNewUserJob(QWindow *window, const QString &userName);
+
 private:
     QString getGlobalTheme();
 };
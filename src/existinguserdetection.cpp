@@ -0,0 +1,443 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "existinguserdetection.h"
+
+#include "plasmasetup_debug.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopeGuard>
+#include <QStandardPaths>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <grp.h>
+#include <poll.h>
+#include <pwd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief Minimum UID for user accounts
+ *
+ * This value represents the absolute lowest user ID value possible.
+ */
+constexpr int MINIMUM_USER_ID = 0;
+/**
+ * @brief Maximum UID for local user accounts
+ *
+ * This value represents the typical highest user ID value possible for
+ * local UNIX user accounts.
+ */
+constexpr int MAXIMUM_USER_ID = 65535;
+
+/**
+ * Path to the local passwd file.
+ */
+const QString PASSWD_PATH = QStringLiteral("/etc/passwd");
+
+/**
+ * Path to the local group file.
+ */
+const QString GROUP_PATH = QStringLiteral("/etc/group");
+
+/**
+ * Directories in which systemd-userdb looks for user records, see nss-systemd(8).
+ */
+const QStringList USERDB_DIRECTORIES = {
+    QStringLiteral("/etc/userdb"),
+    QStringLiteral("/run/userdb"),
+    QStringLiteral("/run/host/userdb"),
+    QStringLiteral("/usr/local/lib/userdb"),
+    QStringLiteral("/usr/lib/userdb"),
+};
+
+/**
+ * The userdb varlink socket of systemd-homed, see systemd-homed.service(8).
+ */
+const QString HOMED_SOCKET_PATH = QStringLiteral("/run/systemd/userdb/io.systemd.Home");
+
+/**
+ * Directory holding the homes managed by systemd-homed, whose users are not in the passwd file.
+ */
+const QString HOMED_HOME_DIRECTORY = QStringLiteral("/home");
+
+/**
+ * How long to wait for systemd-homed to list its users.
+ */
+constexpr int HOMED_TIMEOUT_MS = 2000;
+
+/**
+ * Clamps the range of regular UIDs to the range of local user accounts.
+ */
+static std::pair<uid_t, uid_t> clampedUidRange(std::pair<int, int> uidRange)
+{
+    return {static_cast<uid_t>(std::max(uidRange.first, MINIMUM_USER_ID)), static_cast<uid_t>(std::min(uidRange.second, MAXIMUM_USER_ID))};
+}
+
+/**
+ * Returns the identifier of the current boot, or an empty string if it is not known.
+ */
+static QByteArray bootId()
+{
+    QFile file(QStringLiteral("/proc/sys/kernel/random/boot_id"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll().trimmed();
+}
+
+/**
+ * Returns a key changing whenever a local user database is modified.
+ */
+static QString localDatabasesStamp()
+{
+    QStringList stamps;
+    for (const QString &path : QStringList{PASSWD_PATH, GROUP_PATH, HOMED_HOME_DIRECTORY} + USERDB_DIRECTORIES) {
+        const QFileInfo info(path);
+        stamps << (info.exists() ? QString::number(info.lastModified().toMSecsSinceEpoch()) : QStringLiteral("-"));
+    }
+    return stamps.join(QLatin1Char(':'));
+}
+
+/**
+ * Returns the key identifying a cached detection result.
+ */
+static QString cacheKey(const ExistingUserDetection::Options &options)
+{
+    return QStringLiteral("%1-%2:%3:%4").arg(options.uidRange.first).arg(options.uidRange.second).arg(options.queryRemoteUsers).arg(localDatabasesStamp());
+}
+
+static QString cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/existingusers");
+}
+
+/**
+ * Calls the given function for each entry of a passwd or group file, until it returns false.
+ *
+ * @param readEntry fgetpwent_r() or fgetgrent_r().
+ */
+template<typename Entry, typename ReadEntry, typename Callback>
+static void forEachFileEntry(const QString &path, ReadEntry readEntry, Callback callback)
+{
+    FILE *file = fopen(QFile::encodeName(path).constData(), "re");
+    if (!file) {
+        qCWarning(PlasmaSetup) << "Unable to open" << path << ':' << QString::fromLocal8Bit(strerror(errno));
+        return;
+    }
+
+    Entry entry;
+    Entry *result = nullptr;
+    std::vector<char> buffer(4096);
+
+    while (true) {
+        const int ret = readEntry(file, &entry, buffer.data(), buffer.size(), &result);
+        if (ret == ERANGE && buffer.size() < 1024 * 1024) {
+            // The stream is rewound to the start of the entry, retry with a larger buffer
+            buffer.resize(buffer.size() * 2);
+            continue;
+        }
+        if (ret != 0 || !callback(*result)) {
+            break;
+        }
+    }
+
+    fclose(file);
+}
+
+/**
+ * Calls the given function with each user record of systemd-homed, until it returns false.
+ *
+ * Enumerates the records with the io.systemd.UserDatabase.GetUserRecord varlink method,
+ * whose messages are JSON objects terminated by a NUL byte. Does nothing if systemd-homed
+ * is not running.
+ */
+template<typename Callback>
+static void forEachHomedRecord(const QString &socketPath, Callback callback)
+{
+    const QByteArray encodedPath = QFile::encodeName(socketPath);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (encodedPath.size() >= qsizetype(sizeof(address.sun_path))) {
+        return;
+    }
+    memcpy(address.sun_path, encodedPath.constData(), encodedPath.size());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return;
+    }
+    const auto closeSocket = qScopeGuard([fd]() {
+        close(fd);
+    });
+
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        // Not using systemd-homed is the common case
+        if (errno != ENOENT && errno != ECONNREFUSED) {
+            qCWarning(PlasmaSetup) << "Unable to connect to" << socketPath << ':' << QString::fromLocal8Bit(strerror(errno));
+        }
+        return;
+    }
+
+    QByteArray request = QByteArrayLiteral(R"({"method":"io.systemd.UserDatabase.GetUserRecord","parameters":{"service":"io.systemd.Home"},"more":true})");
+    request.append('\0');
+    if (send(fd, request.constData(), request.size(), MSG_NOSIGNAL) != request.size()) {
+        qCWarning(PlasmaSetup) << "Unable to query" << socketPath << ':' << QString::fromLocal8Bit(strerror(errno));
+        return;
+    }
+
+    const QDeadlineTimer deadline(HOMED_TIMEOUT_MS);
+    QByteArray buffer;
+    char chunk[16384];
+    while (true) {
+        qsizetype end;
+        while ((end = buffer.indexOf('\0')) < 0) {
+            pollfd pollFd{.fd = fd, .events = POLLIN, .revents = 0};
+            const int ready = poll(&pollFd, 1, int(deadline.remainingTime()));
+            if (ready == 0) {
+                qCWarning(PlasmaSetup) << "Timed out listing the users of systemd-homed";
+                return;
+            }
+            const ssize_t received = ready < 0 ? -1 : recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                if (received < 0) {
+                    qCWarning(PlasmaSetup) << "Unable to read from" << socketPath << ':' << QString::fromLocal8Bit(strerror(errno));
+                }
+                return;
+            }
+            buffer.append(chunk, received);
+        }
+
+        const QJsonObject reply = QJsonDocument::fromJson(buffer.first(end)).object();
+        buffer.remove(0, end + 1);
+
+        const QString error = reply.value(QStringLiteral("error")).toString();
+        if (!error.isEmpty()) {
+            // Returned when there are no users at all
+            if (error != QLatin1String("io.systemd.UserDatabase.NoRecordFound")) {
+                qCWarning(PlasmaSetup) << "systemd-homed failed to list its users:" << error;
+            }
+            return;
+        }
+
+        const QJsonObject record = reply.value(QStringLiteral("parameters")).toObject().value(QStringLiteral("record")).toObject();
+        if (!callback(record) || !reply.value(QStringLiteral("continues")).toBool()) {
+            return;
+        }
+    }
+}
+
+namespace ExistingUserDetection
+{
+
+Users detect(const Options &options)
+{
+    const QByteArray currentBootId = bootId();
+    const QString key = cacheKey(options);
+
+    KConfig cache(cachePath(), KConfig::SimpleConfig);
+    KConfigGroup cacheGroup(&cache, QStringLiteral("ExistingUsers"));
+    if (!currentBootId.isEmpty() && cacheGroup.readEntry("BootId", QByteArray()) == currentBootId && cacheGroup.readEntry("Key", QString()) == key) {
+        Users users;
+        users.hasRegularUser = cacheGroup.readEntry("HasExistingUsers", false);
+        const QStringList takenNames = cacheGroup.readEntry("TakenNames", QStringList());
+        users.takenNames = QSet<QString>(takenNames.cbegin(), takenNames.cend());
+        qCDebug(PlasmaSetup) << "Using the existing user detection result cached for this boot:" << users.hasRegularUser;
+        return users;
+    }
+
+    const auto [uidMin, uidMax] = clampedUidRange(options.uidRange);
+    Users users;
+    const auto addUser = [&users, uidMin, uidMax](const QString &name, qint64 uid) {
+        users.takenNames.insert(name);
+        users.hasRegularUser = users.hasRegularUser || (uid >= uidMin && uid <= uidMax);
+    };
+
+    forEachFileEntry<passwd>(PASSWD_PATH, fgetpwent_r, [&addUser](const passwd &entry) {
+        addUser(QString::fromLocal8Bit(entry.pw_name), entry.pw_uid);
+        return true;
+    });
+    forEachFileEntry<group>(GROUP_PATH, fgetgrent_r, [&users](const group &entry) {
+        users.takenNames.insert(QString::fromLocal8Bit(entry.gr_name));
+        return true;
+    });
+
+    // Records are usually linked both as <name>.user and <uid>.user, the same goes for groups
+    for (const QString &directoryPath : USERDB_DIRECTORIES) {
+        const QDir directory(directoryPath);
+        if (!directory.exists()) {
+            continue;
+        }
+
+        const QStringList records = directory.entryList({QStringLiteral("*.user"), QStringLiteral("*.group")}, QDir::Files | QDir::System);
+        for (const QString &record : records) {
+            const QString name = record.left(record.lastIndexOf(u'.'));
+            const bool isUser = record.endsWith(QLatin1String(".user"));
+            bool isId = false;
+            const uint id = name.toUInt(&isId);
+            if (isId) {
+                users.hasRegularUser = users.hasRegularUser || (isUser && id >= uidMin && id <= uidMax);
+                continue;
+            }
+
+            users.takenNames.insert(name);
+
+            // Without the link by UID, the record has to be read to know whether the user is regular
+            if (isUser && !users.hasRegularUser) {
+                QFile file(directory.filePath(record));
+                if (file.open(QIODevice::ReadOnly)) {
+                    const qint64 uid = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("uid")).toInteger(-1);
+                    users.hasRegularUser = uid >= uidMin && uid <= uidMax;
+                }
+            }
+        }
+    }
+
+    // The group of a homed user is named after them
+    forEachHomedRecord(HOMED_SOCKET_PATH, [&addUser](const QJsonObject &record) {
+        const QString name = record.value(QStringLiteral("userName")).toString();
+        if (!name.isEmpty()) {
+            addUser(name, record.value(QStringLiteral("uid")).toInteger(-1));
+        }
+        return true;
+    });
+
+    if (options.queryRemoteUsers) {
+        setpwent();
+        errno = 0;
+        while (passwd *entry = getpwent()) {
+            addUser(QString::fromLocal8Bit(entry->pw_name), entry->pw_uid);
+        }
+        if (errno != 0) {
+            qCWarning(PlasmaSetup) << "Failed while enumerating passwd entries:" << QString::fromLocal8Bit(strerror(errno));
+        }
+        endpwent();
+
+        setgrent();
+        while (group *entry = getgrent()) {
+            users.takenNames.insert(QString::fromLocal8Bit(entry->gr_name));
+        }
+        endgrent();
+    }
+
+    if (!currentBootId.isEmpty()) {
+        QDir().mkpath(QFileInfo(cachePath()).path());
+        cacheGroup.writeEntry("BootId", currentBootId);
+        cacheGroup.writeEntry("Key", key);
+        cacheGroup.writeEntry("HasExistingUsers", users.hasRegularUser);
+        cacheGroup.writeEntry("TakenNames", QStringList(users.takenNames.cbegin(), users.takenNames.cend()));
+        if (!cache.sync()) {
+            qCWarning(PlasmaSetup) << "Unable to cache the existing user detection result in" << cachePath();
+        }
+    }
+
+    return users;
+}
+
+bool passwdFileHasRegularUser(const QString &path, std::pair<int, int> uidRange)
+{
+    const auto [uidMin, uidMax] = clampedUidRange(uidRange);
+
+    bool found = false;
+    forEachFileEntry<passwd>(path, fgetpwent_r, [&](const passwd &entry) {
+        found = entry.pw_uid >= uidMin && entry.pw_uid <= uidMax;
+        return !found;
+    });
+    return found;
+}
+
+bool userdbHasRegularUser(std::pair<int, int> uidRange)
+{
+    const auto [uidMin, uidMax] = clampedUidRange(uidRange);
+
+    for (const QString &directoryPath : USERDB_DIRECTORIES) {
+        const QDir directory(directoryPath);
+        if (!directory.exists()) {
+            continue;
+        }
+
+        const QStringList records = directory.entryList({QStringLiteral("*.user")}, QDir::Files | QDir::System);
+        for (const QString &record : records) {
+            // Records are usually also linked as <uid>.user, which avoids reading them
+            bool isUid = false;
+            const uint uid = QStringView(record).chopped(5).toUInt(&isUid);
+            if (isUid) {
+                if (uid >= uidMin && uid <= uidMax) {
+                    return true;
+                }
+                continue;
+            }
+
+            QFile file(directory.filePath(record));
+            if (!file.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+            const QJsonObject object = QJsonDocument::fromJson(file.readAll()).object();
+            const qint64 recordUid = object.value(QStringLiteral("uid")).toInteger(-1);
+            if (recordUid >= uidMin && recordUid <= uidMax) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool homedHasRegularUser(std::pair<int, int> uidRange, const QString &socketPath)
+{
+    const auto [uidMin, uidMax] = clampedUidRange(uidRange);
+
+    bool found = false;
+    forEachHomedRecord(socketPath.isEmpty() ? HOMED_SOCKET_PATH : socketPath, [&](const QJsonObject &record) {
+        const qint64 uid = record.value(QStringLiteral("uid")).toInteger(-1);
+        found = uid >= uidMin && uid <= uidMax;
+        return !found;
+    });
+    return found;
+}
+
+bool nssHasRegularUser(std::pair<int, int> uidRange)
+{
+    struct PasswdScopeGuard {
+        PasswdScopeGuard()
+        {
+            setpwent();
+        }
+        ~PasswdScopeGuard()
+        {
+            endpwent();
+        }
+    } guard;
+
+    const auto [uidMin, uidMax] = clampedUidRange(uidRange);
+    errno = 0;
+    while (passwd *entry = getpwent()) {
+        if (entry->pw_uid >= uidMin && entry->pw_uid <= uidMax) {
+            return true;
+        }
+    }
+
+    if (errno != 0) {
+        qCWarning(PlasmaSetup) << "Failed while enumerating passwd entries:" << QString::fromLocal8Bit(strerror(errno));
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QSet>
+#include <QString>
+
+#include <utility>
+
+/**
+ * Detection of regular users already existing on the system.
+ *
+ * The following local sources are read:
+ * - the passwd and group files, parsed directly rather than through NSS
+ * - the systemd-userdb drop-in directories
+ * - the users of systemd-homed, queried over its varlink socket
+ *
+ * Enumerating all users through NSS may go over the network when the system is joined to a
+ * directory (sss, ldap, ...), so it is only done if explicitly requested.
+ *
+ * The functions here may block and are meant to be run off the GUI thread.
+ */
+namespace ExistingUserDetection
+{
+
+struct Options {
+    /** The range of UIDs of regular users, inclusive. */
+    std::pair<int, int> uidRange;
+
+    /** Whether to also enumerate the users of all NSS sources, including remote ones. */
+    bool queryRemoteUsers = false;
+};
+
+/**
+ * The users and groups found by detect().
+ */
+struct Users {
+    /** Whether at least one regular user exists. */
+    bool hasRegularUser = false;
+
+    /**
+     * The names of all users and groups, regular or not.
+     *
+     * Groups are included because useradd also creates a group named after the user.
+     */
+    QSet<QString> takenNames;
+};
+
+/**
+ * Enumerates the users and groups of every source once, to find both whether a regular user
+ * exists and which names are taken.
+ *
+ * The result is cached for the current boot, and only computed again if the options or
+ * the local user databases changed since.
+ */
+Users detect(const Options &options);
+
+/**
+ * Returns whether the given passwd file contains a regular user.
+ */
+bool passwdFileHasRegularUser(const QString &path, std::pair<int, int> uidRange);
+
+/**
+ * Returns whether one of the systemd-userdb drop-in directories defines a regular user.
+ */
+bool userdbHasRegularUser(std::pair<int, int> uidRange);
+
+/**
+ * Returns whether systemd-homed manages a regular user.
+ *
+ * Gives up after a short timeout if systemd-homed does not answer.
+ *
+ * @param socketPath The userdb socket of systemd-homed, the default one if empty.
+ */
+bool homedHasRegularUser(std::pair<int, int> uidRange, const QString &socketPath = QString());
+
+/**
+ * Returns whether any NSS source knows a regular user, enumerating all of them if needed.
+ */
+bool nssHasRegularUser(std::pair<int, int> uidRange);
+
+}
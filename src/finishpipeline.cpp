@@ -0,0 +1,215 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "finishpipeline.h"
+#include "plasmasetup_debug.h"
+#include "tracer.h"
+
+#include <KAuth/ExecuteJob>
+#include <KLocalizedString>
+
+#include <algorithm>
+
+FinishPipeline::FinishPipeline(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FinishPipeline::addStep(const QString &id, const QString &description, const QStringList &dependencies, JobFactory factory)
+{
+    Q_ASSERT(!m_running);
+    Q_ASSERT(!findStep(id));
+
+    m_steps.append(Step{
+        .id = id,
+        .description = description,
+        .dependencies = dependencies,
+        .factory = std::move(factory),
+    });
+}
+
+void FinishPipeline::setStepProgress(const QString &id, qreal progress, const QString &description)
+{
+    Step *step = findStep(id);
+    if (!step || step->state != StepState::Running) {
+        return;
+    }
+
+    step->progress = std::clamp<qreal>(progress, 0, 1);
+    step->currentDescription = description;
+    Q_EMIT progressChanged();
+}
+
+void FinishPipeline::start()
+{
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_errors.clear();
+
+    // Retry the steps that failed last time, and the ones that were blocked by them
+    for (Step &step : m_steps) {
+        if (step.state == StepState::Failed) {
+            step.state = StepState::Pending;
+        }
+    }
+
+    Q_EMIT progressChanged();
+    scheduleSteps();
+}
+
+bool FinishPipeline::isRunning() const
+{
+    return m_running;
+}
+
+qreal FinishPipeline::progress() const
+{
+    if (m_steps.isEmpty()) {
+        return m_running ? 0 : 1;
+    }
+
+    qreal done = 0;
+    for (const Step &step : m_steps) {
+        if (step.state == StepState::Succeeded) {
+            done += 1;
+        } else if (step.state == StepState::Running) {
+            done += step.progress;
+        }
+    }
+    return done / m_steps.size();
+}
+
+QString FinishPipeline::currentDescription() const
+{
+    for (const Step &step : m_steps) {
+        if (step.state == StepState::Running) {
+            return step.currentDescription;
+        }
+    }
+    return {};
+}
+
+QStringList FinishPipeline::errors() const
+{
+    return m_errors;
+}
+
+void FinishPipeline::scheduleSteps()
+{
+    // Steps without a job succeed right away, which may unblock further steps
+    bool startedStep = true;
+    while (startedStep) {
+        startedStep = false;
+        for (Step &step : m_steps) {
+            if (step.state == StepState::Pending && dependenciesSucceeded(step)) {
+                startStep(step);
+                startedStep = true;
+            }
+        }
+    }
+
+    const bool stepRunning = std::ranges::any_of(m_steps, [](const Step &step) {
+        return step.state == StepState::Running;
+    });
+    if (stepRunning || !m_running) {
+        return;
+    }
+
+    for (Step &step : m_steps) {
+        if (step.state == StepState::Pending && dependencyFailed(step)) {
+            qCWarning(PlasmaSetup) << "Skipping step" << step.id << "because one of its dependencies failed.";
+        }
+    }
+
+    m_running = false;
+    const bool success = std::ranges::all_of(m_steps, [](const Step &step) {
+        return step.state == StepState::Succeeded;
+    });
+    qCInfo(PlasmaSetup) << "Finish pipeline done, success:" << success;
+    Q_EMIT finished(success);
+}
+
+void FinishPipeline::startStep(Step &step)
+{
+    KAuth::ExecuteJob *job = step.factory ? step.factory() : nullptr;
+    if (!job) {
+        step.state = StepState::Succeeded;
+        Q_EMIT stepFinished(step.id, true, QString());
+        Q_EMIT progressChanged();
+        return;
+    }
+
+    qCInfo(PlasmaSetup) << "Starting finish step" << step.id;
+    step.state = StepState::Running;
+    step.progress = 0;
+    step.currentDescription = step.description;
+
+    const QString id = step.id;
+    const qint64 traceStart = Tracer::timestamp();
+    connect(job, &KJob::result, this, [this, id, job, traceStart]() {
+        Tracer::addSpan(job->action().name(), QStringLiteral("kauth"), traceStart);
+        const QString errorString = job->errorString().isEmpty() ? i18n("Authorization or helper failure (code %1)", job->error()) : job->errorString();
+        finishStep(id, job->error() == KJob::NoError, errorString);
+    });
+    job->start();
+
+    Q_EMIT stepStarted(step.id, step.description);
+    Q_EMIT progressChanged();
+}
+
+void FinishPipeline::finishStep(const QString &id, bool success, const QString &errorString)
+{
+    Step *step = findStep(id);
+    if (!step || step->state != StepState::Running) {
+        return;
+    }
+
+    if (success) {
+        qCInfo(PlasmaSetup) << "Finish step" << id << "succeeded.";
+        step->state = StepState::Succeeded;
+        Q_EMIT stepFinished(id, true, QString());
+    } else {
+        qCWarning(PlasmaSetup) << "Finish step" << id << "failed:" << errorString;
+        step->state = StepState::Failed;
+        m_errors.append(errorString);
+        Q_EMIT stepFinished(id, false, errorString);
+    }
+
+    Q_EMIT progressChanged();
+    scheduleSteps();
+}
+
+FinishPipeline::Step *FinishPipeline::findStep(const QString &id)
+{
+    for (Step &step : m_steps) {
+        if (step.id == id) {
+            return &step;
+        }
+    }
+    return nullptr;
+}
+
+bool FinishPipeline::dependenciesSucceeded(const Step &step)
+{
+    return std::ranges::all_of(step.dependencies, [this](const QString &dependencyId) {
+        const Step *dependency = findStep(dependencyId);
+        return dependency && dependency->state == StepState::Succeeded;
+    });
+}
+
+bool FinishPipeline::dependencyFailed(const Step &step)
+{
+    return std::ranges::any_of(step.dependencies, [this](const QString &dependencyId) {
+        const Step *dependency = findStep(dependencyId);
+        if (!dependency || dependency->state == StepState::Failed) {
+            return true;
+        }
+        return dependency->state == StepState::Pending && dependencyFailed(*dependency);
+    });
+}
+
+#include "moc_finishpipeline.cpp"
@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+#include <functional>
+
+namespace KAuth
+{
+class ExecuteJob;
+}
+
+/**
+ * Runs the privileged steps needed to finish the initial setup without blocking the UI.
+ *
+ * Each step starts a KAuth job and may depend on other steps, e.g. applying the global theme
+ * for the new user depends on the user having been created. A step is started as soon as all of
+ * its dependencies have succeeded, so independent steps run concurrently. If a step fails, the
+ * steps depending on it are not run and the pipeline finishes unsuccessfully.
+ *
+ * Steps that succeeded are remembered, calling start() again after a failure only retries the
+ * steps that did not succeed.
+ */
+class FinishPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates the job of a step, or returns nullptr if there is nothing to do for it.
+     *
+     * The returned job must not have been started yet.
+     */
+    using JobFactory = std::function<KAuth::ExecuteJob *()>;
+
+    explicit FinishPipeline(QObject *parent = nullptr);
+
+    /**
+     * Adds a step to the pipeline.
+     *
+     * @param id Unique identifier of the step, used to declare dependencies.
+     * @param description Localized text shown to the user while the step runs.
+     * @param dependencies Identifiers of the steps that must succeed before this one is started.
+     * @param factory Creates the KAuth job for the step.
+     */
+    void addStep(const QString &id, const QString &description, const QStringList &dependencies, JobFactory factory);
+
+    /**
+     * Reports how far a running step got, for steps whose job runs several operations.
+     *
+     * Does nothing if the step is not running.
+     *
+     * @param id The identifier of the step.
+     * @param progress The fraction of the step that is done, between 0 and 1.
+     * @param description Localized text describing what the step does next.
+     */
+    void setStepProgress(const QString &id, qreal progress, const QString &description);
+
+    /**
+     * Starts all steps that have not succeeded yet.
+     *
+     * Does nothing while the pipeline is running.
+     */
+    void start();
+
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * The fraction of steps done so far, between 0 and 1, including the progress of the running steps.
+     */
+    [[nodiscard]] qreal progress() const;
+
+    /**
+     * The description of a step that is currently running, or an empty string.
+     */
+    [[nodiscard]] QString currentDescription() const;
+
+    /**
+     * The error messages of the steps that failed during the last run.
+     */
+    [[nodiscard]] QStringList errors() const;
+
+Q_SIGNALS:
+    void stepStarted(const QString &id, const QString &description);
+    void stepFinished(const QString &id, bool success, const QString &errorString);
+    void progressChanged();
+
+    /**
+     * Emitted once no step is running and no further step can be started.
+     *
+     * @param success true if every step succeeded.
+     */
+    void finished(bool success);
+
+private:
+    enum class StepState {
+        Pending,
+        Running,
+        Succeeded,
+        Failed,
+    };
+
+    struct Step {
+        QString id;
+        QString description;
+        QStringList dependencies;
+        JobFactory factory;
+        StepState state = StepState::Pending;
+
+        /** The fraction of the step done while it is running, see setStepProgress(). */
+        qreal progress = 0;
+
+        /** What the step does next while it is running, the description by default. */
+        QString currentDescription;
+    };
+
+    /**
+     * Starts every pending step whose dependencies have succeeded, and finishes the
+     * pipeline once nothing is left to run.
+     */
+    void scheduleSteps();
+
+    void startStep(Step &step);
+    void finishStep(const QString &id, bool success, const QString &errorString);
+
+    [[nodiscard]] Step *findStep(const QString &id);
+    [[nodiscard]] bool dependenciesSucceeded(const Step &step);
+    [[nodiscard]] bool dependencyFailed(const Step &step);
+
+    QList<Step> m_steps;
+    QStringList m_errors;
+    bool m_running = false;
+};
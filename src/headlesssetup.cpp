@@ -0,0 +1,277 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "headlesssetup.h"
+
+#include "accountcontroller.h"
+#include "initialstartutil.h"
+#include "keyboardutil.h"
+#include "plasmasetup_debug.h"
+#include "tracer.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QFileInfo>
+#include <QHash>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QTextStream>
+#include <QTimeZone>
+
+#include <memory>
+
+namespace
+{
+/**
+ * The module of the singletons built into the application, such as KeyboardUtil.
+ */
+const QString APPLICATION_URI = QStringLiteral("org.kde.plasmasetup");
+}
+
+HeadlessSetup::HeadlessSetup(QQmlEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+{
+}
+
+QString HeadlessSetup::load(const QString &answersPath)
+{
+    if (!QFileInfo(answersPath).isReadable()) {
+        return QStringLiteral("The answers file %1 does not exist or cannot be read.").arg(answersPath);
+    }
+
+    const KConfig answers(answersPath, KConfig::SimpleConfig);
+
+    if (answers.hasGroup(QStringLiteral("Language"))) {
+        const QString language = answers.group(QStringLiteral("Language")).readEntry("Language");
+        QObject *languageUtil = singleton(QStringLiteral("org.kde.plasmasetup.languageutil"), QStringLiteral("LanguageUtil"));
+        addSystemSettingsStep(QStringLiteral("language"), languageUtil, [languageUtil, language]() {
+            if (language.isEmpty()) {
+                return QStringLiteral("No language given.");
+            }
+            languageUtil->setProperty("currentLanguage", language);
+            QMetaObject::invokeMethod(languageUtil, "applyLanguage");
+            return QString();
+        });
+    }
+
+    if (answers.hasGroup(QStringLiteral("Keyboard"))) {
+        const KConfigGroup group = answers.group(QStringLiteral("Keyboard"));
+        const QString layout = group.readEntry("Layout");
+        const QString variant = group.readEntry("Variant");
+        const QString options = group.readEntry("Options");
+        auto keyboardUtil = qobject_cast<KeyboardUtil *>(singleton(APPLICATION_URI, QStringLiteral("KeyboardUtil")));
+        addSystemSettingsStep(QStringLiteral("keyboard"), keyboardUtil, [keyboardUtil, layout, variant, options]() {
+            if (layout.isEmpty()) {
+                return QStringLiteral("No keyboard layout given.");
+            }
+            keyboardUtil->setLayoutName(layout);
+            keyboardUtil->setLayoutVariant(variant);
+            keyboardUtil->setLayoutOptions(options);
+            keyboardUtil->applyLayout();
+            return QString();
+        });
+    }
+
+    if (answers.hasGroup(QStringLiteral("Time"))) {
+        const QString timeZone = answers.group(QStringLiteral("Time")).readEntry("TimeZone");
+        QObject *timeUtil = singleton(QStringLiteral("org.kde.plasmasetup.timeutil"), QStringLiteral("TimeUtil"));
+        addSystemSettingsStep(QStringLiteral("time"), timeUtil, [timeUtil, timeZone]() {
+            if (!QTimeZone::isTimeZoneIdAvailable(timeZone.toUtf8())) {
+                return QStringLiteral("Unknown timezone: ") + timeZone;
+            }
+            timeUtil->setProperty("currentTimeZone", timeZone);
+            return QString();
+        });
+    }
+
+    if (answers.hasGroup(QStringLiteral("Hostname"))) {
+        const QString hostname = answers.group(QStringLiteral("Hostname")).readEntry("Hostname");
+        QObject *hostnameUtil = singleton(QStringLiteral("org.kde.plasmasetup.hostnameutil"), QStringLiteral("HostnameUtil"));
+        addSystemSettingsStep(QStringLiteral("hostname"), hostnameUtil, [hostnameUtil, hostname]() {
+            QString validationMessage;
+            QMetaObject::invokeMethod(hostnameUtil, "hostnameValidationMessage", Q_RETURN_ARG(QString, validationMessage), Q_ARG(QString, hostname));
+            if (!validationMessage.isEmpty()) {
+                return validationMessage;
+            }
+            hostnameUtil->setProperty("hostname", hostname);
+            return QString();
+        });
+    }
+
+    AccountController *accountController = AccountController::instance();
+    if (answers.hasGroup(QStringLiteral("Account"))) {
+        const KConfigGroup group = answers.group(QStringLiteral("Account"));
+        accountController->setUsername(group.readEntry("Username"));
+        accountController->setFullName(group.readEntry("FullName"));
+        accountController->setPassword(group.readEntry("Password"));
+        if (group.hasKey("Groups")) {
+            accountController->setExtraGroups(group.readEntry("Groups", QStringList()));
+        }
+    }
+
+    addFinishStep();
+
+    for (const Step &step : std::as_const(m_steps)) {
+        if (!step.start) {
+            return QStringLiteral("Unable to load what applies the %1, is Plasma Setup completely installed?").arg(step.name);
+        }
+    }
+    return QString();
+}
+
+void HeadlessSetup::start()
+{
+    m_totalTimer.start();
+    startNextStep();
+}
+
+QObject *HeadlessSetup::singleton(const QString &uri, const QString &typeName)
+{
+    // Importing the module loads its plugin, which registers its types
+    QQmlComponent component(m_engine);
+    component.setData(QStringLiteral("import QtQml\nimport %1\nQtObject {}\n").arg(uri).toUtf8(), QUrl());
+    if (component.isError()) {
+        qCWarning(PlasmaSetup) << "Unable to load" << uri << ':' << component.errorString();
+        return nullptr;
+    }
+
+    return m_engine->singletonInstance<QObject *>(uri, typeName);
+}
+
+void HeadlessSetup::addSystemSettingsStep(const QString &name, QObject *util, const std::function<QString()> &stage)
+{
+    if (!util) {
+        m_steps.append({name, {}});
+        return;
+    }
+
+    m_steps.append({name, [this, util, stage]() {
+                        const QString errorMessage = stage();
+                        if (!errorMessage.isEmpty()) {
+                            finishStep(errorMessage);
+                            return;
+                        }
+
+                        // Answered by handleSystemSettingsCommitted(), right away if nothing changed
+                        m_committingUtil = util;
+                        connect(util, SIGNAL(systemSettingsCommitted(QStringList)), this, SLOT(handleSystemSettingsCommitted(QStringList)));
+                        QMetaObject::invokeMethod(util, "commitSystemSettings");
+                    }});
+}
+
+void HeadlessSetup::handleSystemSettingsCommitted(const QStringList &errorMessages)
+{
+    if (sender() != m_committingUtil) {
+        return;
+    }
+
+    disconnect(m_committingUtil, nullptr, this, nullptr);
+    m_committingUtil = nullptr;
+    finishStep(errorMessages.join(QStringLiteral("; ")));
+}
+
+void HeadlessSetup::addFinishStep()
+{
+    auto initialStartUtil = qobject_cast<InitialStartUtil *>(singleton(APPLICATION_URI, QStringLiteral("InitialStartUtil")));
+    if (!initialStartUtil) {
+        m_steps.append({QStringLiteral("finish"), {}});
+        return;
+    }
+
+    m_steps.append({QStringLiteral("finish"), [this, initialStartUtil]() {
+                        AccountController *accountController = AccountController::instance();
+
+                        // Whether a user is to be created is only known once the detection is done
+                        if (accountController->isDetectingExistingUsers() || !accountController->takenNamesLoaded()) {
+                            auto connection = std::make_shared<QMetaObject::Connection>();
+                            const auto retry = [this, connection]() {
+                                disconnect(*connection);
+                                m_steps[m_currentStep].start();
+                            };
+                            *connection = connect(accountController,
+                                                  accountController->isDetectingExistingUsers() ? &AccountController::detectingExistingUsersChanged
+                                                                                                 : &AccountController::takenNamesLoadedChanged,
+                                                  this,
+                                                  retry);
+                            return;
+                        }
+
+                        if (accountController->createsUser()) {
+                            const QString validationMessage = accountController->usernameValidationMessage(accountController->username());
+                            if (!validationMessage.isEmpty()) {
+                                finishStep(validationMessage);
+                                return;
+                            }
+                            if (accountController->password().isEmpty()) {
+                                finishStep(QStringLiteral("No password given for the new user."));
+                                return;
+                            }
+                        }
+
+                        auto stepStarts = std::make_shared<QHash<QString, qint64>>();
+                        connect(initialStartUtil, &InitialStartUtil::finishStepStarted, this, [this, stepStarts](const QString &id) {
+                            stepStarts->insert(id, m_totalTimer.elapsed());
+                        });
+                        connect(initialStartUtil,
+                                &InitialStartUtil::finishStepFinished,
+                                this,
+                                [this, stepStarts](const QString &id, bool success, const QString &errorString) {
+                                    report(QStringLiteral("finish/") + id,
+                                           success ? QStringLiteral("ok") : QStringLiteral("failed: ") + errorString,
+                                           m_totalTimer.elapsed() - stepStarts->value(id, m_totalTimer.elapsed()));
+                                });
+                        connect(initialStartUtil, &InitialStartUtil::finishingChanged, this, [this, initialStartUtil]() {
+                            if (!initialStartUtil->isFinishing()) {
+                                disconnect(initialStartUtil, nullptr, this, nullptr);
+                                finishStep(initialStartUtil->finishError());
+                            }
+                        });
+
+                        initialStartUtil->finish();
+                    }});
+}
+
+void HeadlessSetup::startNextStep()
+{
+    ++m_currentStep;
+    if (m_currentStep == m_steps.size()) {
+        report(QStringLiteral("total"), QStringLiteral("ok"), m_totalTimer.elapsed());
+        Q_EMIT finished(true);
+        return;
+    }
+
+    m_stepTimer.start();
+    m_stepStart = Tracer::timestamp();
+    m_steps[m_currentStep].start();
+}
+
+void HeadlessSetup::finishStep(const QString &errorMessage)
+{
+    const Step &step = m_steps.at(m_currentStep);
+    Tracer::addSpan(step.name, QStringLiteral("headless"), m_stepStart);
+    report(step.name, errorMessage.isEmpty() ? QStringLiteral("ok") : QStringLiteral("failed: ") + errorMessage, m_stepTimer.elapsed());
+
+    if (!errorMessage.isEmpty()) {
+        for (qsizetype i = m_currentStep + 1; i < m_steps.size(); ++i) {
+            report(m_steps.at(i).name, QStringLiteral("skipped"), 0);
+        }
+        report(QStringLiteral("total"), QStringLiteral("failed"), m_totalTimer.elapsed());
+        Q_EMIT finished(false);
+        return;
+    }
+
+    startNextStep();
+}
+
+void HeadlessSetup::report(const QString &name, const QString &status, qint64 elapsed)
+{
+    QTextStream out(stdout);
+    out << name << QStringLiteral(": ") << status << QStringLiteral(" (") << elapsed << QStringLiteral(" ms)\n");
+    out.flush();
+    qCInfo(PlasmaSetup) << "Headless setup:" << name << status << "in" << elapsed << "ms";
+}
+
+#include "moc_headlesssetup.cpp"
@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+class QQmlEngine;
+
+/**
+ * Runs the setup without the wizard, from the answers given in a file.
+ *
+ * The answers are applied through the same singletons the modules use, so the result is the
+ * same as going through the wizard. Only the plugins of the modules are loaded into the QML
+ * engine, none of their pages is created.
+ *
+ * The answers file uses the format of the configuration files, every group is optional:
+ *
+ * @code
+ * [Language]
+ * Language=de_DE
+ *
+ * [Keyboard]
+ * Layout=de
+ * Variant=nodeadkeys
+ * Options=
+ *
+ * [Time]
+ * TimeZone=Europe/Berlin
+ *
+ * [Hostname]
+ * Hostname=workstation-042
+ *
+ * [Account]
+ * Username=jdoe
+ * FullName=Jane Doe
+ * Password=…
+ * Groups=wheel,audio
+ * @endcode
+ *
+ * The steps run one after the other, and the status and duration of each is reported on
+ * the standard output. The first step failing stops the run, so the setup is never marked
+ * as done after a failure.
+ */
+class HeadlessSetup : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessSetup(QQmlEngine *engine, QObject *parent = nullptr);
+
+    /**
+     * Reads the answers from the given file and prepares the steps applying them.
+     *
+     * @return An error message, or an empty string if the answers can be applied.
+     */
+    QString load(const QString &answersPath);
+
+    /**
+     * Runs the steps, finished() is emitted once they are done.
+     */
+    void start();
+
+Q_SIGNALS:
+    /**
+     * Emitted once all steps succeeded, or one failed.
+     */
+    void finished(bool success);
+
+private Q_SLOTS:
+    void handleSystemSettingsCommitted(const QStringList &errorMessages);
+
+private:
+    struct Step {
+        /** What the step applies, used in the report. */
+        QString name;
+
+        /** Starts the step, which calls finishStep() once it is done. */
+        std::function<void()> start;
+    };
+
+    /**
+     * Returns the instance of the given singleton, loading the module providing it if needed.
+     */
+    QObject *singleton(const QString &uri, const QString &typeName);
+
+    /**
+     * Adds a step writing the settings staged on the given singleton by the given function.
+     */
+    void addSystemSettingsStep(const QString &name, QObject *util, const std::function<QString()> &stage);
+
+    /**
+     * Adds the step creating the user and finishing the setup.
+     */
+    void addFinishStep();
+
+    void startNextStep();
+
+    /**
+     * Reports the outcome of the current step, and continues with the next one if it succeeded.
+     */
+    void finishStep(const QString &errorMessage);
+
+    /**
+     * Prints a line of the report.
+     */
+    static void report(const QString &name, const QString &status, qint64 elapsed);
+
+    QQmlEngine *const m_engine;
+
+    QList<Step> m_steps;
+    qsizetype m_currentStep = -1;
+
+    /** The singleton whose settings the current step writes. */
+    QObject *m_committingUtil = nullptr;
+
+    QElapsedTimer m_stepTimer;
+    QElapsedTimer m_totalTimer;
+    qint64 m_stepStart = 0;
+};
@@ -4,8 +4,10 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "initialstartutil.h"
-#include "displayutil.h"
+#include "finishpipeline.h"
 #include "plasmasetup_debug.h"
+#include "systemconfig.h"
+#include "tracer.h"
 
 #include <KAuth/Action>
 #include <KAuth/ExecuteJob>
@@ -13,6 +15,8 @@
 
 #include <QApplication>
 
+#include <algorithm>
+
 InitialStartUtil::InitialStartUtil(QObject *parent)
     : QObject{parent}
     , m_accountController(AccountController::instance())
@@ -29,119 +33,284 @@ QString InitialStartUtil::distroName() const
 
 void InitialStartUtil::finish()
 {
-    doUserCreationSteps();
-    createCompletionFlag();
-    logOut();
-}
-
-void InitialStartUtil::doUserCreationSteps()
-{
-    if (m_accountController->hasExistingUsers()) {
-        qCInfo(PlasmaSetup) << "Skipping user creation steps since existing users were detected.";
+    // The autologin of the plasma-setup user is removed before anything else is configured
+    if (m_autologinJob) {
+        qCDebug(PlasmaSetup) << "Waiting for the autologin configuration to be removed before finishing";
+        connect(m_autologinJob, &KJob::result, this, &InitialStartUtil::finish, Qt::SingleShotConnection);
         return;
     }
 
-    const bool userCreated = m_accountController->createUser();
-    if (!userCreated) {
-        qCWarning(PlasmaSetup) << "Failed to create user:" << m_accountController->username();
-        // TODO: Handle the error appropriately, e.g., show a message to the user
+    // The files staged for the new user are only moved into place once staging them is done
+    if (m_preparationJob) {
+        qCDebug(PlasmaSetup) << "Waiting for the preparation of the new user before finishing";
+        connect(m_preparationJob, &KJob::result, this, &InitialStartUtil::finish, Qt::SingleShotConnection);
         return;
     }
 
-    // Temporarily disabling the automatic session transition because using SDDM's
-    // Autologin causes some issues, like being unable to create a wallet and potentially
-    // connecting to new wifi networks until after a reboot. This isn't an issue when the user
-    // logs in normally with their password. Re-enable these when we can ensure the automatic
-    // transition doesn't cause such issues.
-    // setNewUserTempAutologin();
-    // createNewUserAutostartHook();
+    if (!m_finishPipeline) {
+        createFinishPipeline();
+    }
+
+    if (m_finishPipeline->isRunning()) {
+        return;
+    }
 
-    DisplayUtil displayUtil;
-    displayUtil.setGlobalThemeForNewUser(m_window, m_accountController->username());
-    displayUtil.setScalingForNewUser(m_window, m_accountController->username());
+    setFinishError(QString());
+    m_finishPipeline->start();
+    Q_EMIT finishingChanged();
 }
 
-void InitialStartUtil::disablePlasmaSetupAutologin()
+void InitialStartUtil::prepareFinish()
 {
-    if (!runningAsPlasmaSetupUser()) {
-        qCInfo(PlasmaSetup) << "Not running as plasma-setup user; skipping autologin removal.";
+    // Once finishing started, the finishing steps report problems themselves
+    if (m_finishPipeline || !m_accountController->createsUser() || !runningAsPlasmaSetupUser()) {
         return;
     }
 
-    qCInfo(PlasmaSetup) << "Removing autologin configuration for plasma-setup user.";
+    const QVariantMap arguments = m_accountController->preparationArguments();
+    if (arguments.value(QStringLiteral("username")).toString().isEmpty() || arguments == m_preparedArguments) {
+        return;
+    }
+    m_preparedArguments = arguments;
 
-    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.removeautologin"));
+    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.preparenewuser"));
     action.setParentWindow(m_window);
     action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
+    action.setArguments(arguments);
+
     KAuth::ExecuteJob *job = action.execute();
+    m_preparationJob = job;
+    connect(job, &KJob::result, this, [this, job, arguments]() {
+        if (m_preparationJob == job) {
+            m_preparationJob = nullptr;
+        }
+
+        // The user changed their choices meanwhile, another preparation has been started for them
+        if (arguments != m_preparedArguments) {
+            return;
+        }
+
+        if (job->error()) {
+            qCWarning(PlasmaSetup) << "Preparing the new user failed:" << job->errorString();
+            setPreparationError(job->errorString());
+            return;
+        }
+
+        const QVariantMap data = job->data();
+        qCInfo(PlasmaSetup) << "Prepared the new user with groups" << data.value(QStringLiteral("extraGroups")).toStringList() << "and"
+                            << data.value(QStringLiteral("homeEntries")).toLongLong() << "staged home entries for"
+                            << data.value(QStringLiteral("displayManager")).toString();
+        setPreparationError(QString());
+    });
+    job->start();
+}
+
+bool InitialStartUtil::isFinishing() const
+{
+    return m_finishPipeline && m_finishPipeline->isRunning();
+}
 
-    if (!job->exec()) {
-        qCWarning(PlasmaSetup) << "Failed to remove autologin configuration:" << job->errorString();
-    } else {
-        qCInfo(PlasmaSetup) << "Autologin configuration removed successfully.";
+qreal InitialStartUtil::finishProgress() const
+{
+    return m_finishPipeline ? m_finishPipeline->progress() : 0;
+}
+
+QString InitialStartUtil::finishStatus() const
+{
+    return m_finishPipeline ? m_finishPipeline->currentDescription() : QString();
+}
+
+QString InitialStartUtil::finishError() const
+{
+    return m_finishError;
+}
+
+QString InitialStartUtil::preparationError() const
+{
+    return m_preparationError;
+}
+
+void InitialStartUtil::setPreparationError(const QString &preparationError)
+{
+    if (m_preparationError == preparationError) {
+        return;
     }
+    m_preparationError = preparationError;
+    Q_EMIT preparationErrorChanged();
 }
 
-bool InitialStartUtil::runningAsPlasmaSetupUser()
+void InitialStartUtil::setFinishError(const QString &finishError)
 {
-    return (qgetenv("USER") == "plasma-setup");
+    if (m_finishError == finishError) {
+        return;
+    }
+    m_finishError = finishError;
+    Q_EMIT finishErrorChanged();
 }
 
-void InitialStartUtil::logOut()
+void InitialStartUtil::createFinishPipeline()
 {
-    m_session.requestLogout(SessionManagement::ConfirmationMode::Skip);
+    m_finishPipeline = new FinishPipeline(this);
+    connect(m_finishPipeline, &FinishPipeline::progressChanged, this, &InitialStartUtil::finishProgressChanged);
+    connect(m_finishPipeline, &FinishPipeline::stepStarted, this, &InitialStartUtil::finishStepStarted);
+    connect(m_finishPipeline, &FinishPipeline::stepFinished, this, &InitialStartUtil::finishStepFinished);
+    connect(m_finishPipeline, &FinishPipeline::finished, this, [this](bool success) {
+        // The error is known by the time finishing is reported as done
+        if (!success) {
+            setFinishError(m_finishPipeline->errors().join(QLatin1Char('\n')));
+        }
+        Q_EMIT finishingChanged();
+
+        if (!success) {
+            Q_EMIT finishFailed();
+            return;
+        }
+
+        logOut();
+    });
+
+    addUserCreationSteps();
+
+    if (!m_accountController->createsUser()) {
+        m_finishPipeline->addStep(QStringLiteral("completionflag"), i18nc("@info:status", "Completing setup…"), {}, [this]() {
+            return completionFlagJob();
+        });
+    }
 }
 
-void InitialStartUtil::setNewUserTempAutologin()
+void InitialStartUtil::addUserCreationSteps()
 {
-    const QString username = m_accountController->username();
-    qCInfo(PlasmaSetup) << "Setting temporary autologin for new user:" << username;
+    if (!m_accountController->createsUser()) {
+        qCInfo(PlasmaSetup) << "Skipping user creation steps since existing users were detected.";
+        return;
+    }
 
-    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.setnewusertempautologin"));
-    action.setParentWindow(m_window);
-    action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
-    action.setArguments({{QStringLiteral("username"), username}});
-    KAuth::ExecuteJob *job = action.execute();
+    // All steps for the new user run in a single helper invocation, saving a helper
+    // spawn, a polkit check and a user lookup for each of them.
+    const QStringList operations = {
+        QStringLiteral("createuser"),
+        // Temporarily disabling the automatic session transition because using SDDM's
+        // Autologin causes some issues, like being unable to create a wallet and potentially
+        // connecting to new wifi networks until after a reboot. This isn't an issue when the user
+        // logs in normally with their password. Re-enable these when we can ensure the automatic
+        // transition doesn't cause such issues.
+        // QStringLiteral("setnewusertempautologin"),
+        // QStringLiteral("createnewuserautostarthook"),
+        // Carries over the global theme, the display scaling and whatever else is configured
+        QStringLiteral("seednewuserhome"),
+        // Only mark the setup as done once the new user exists, so that a failure
+        // to create it leaves the setup to be run again.
+        QStringLiteral("createflagfile"),
+    };
+
+    m_finishPipeline->addStep(QStringLiteral("provisionuser"), provisionOperationDescription(operations.first()), {}, [this, operations]() {
+        return provisionUserJob(operations);
+    });
+}
 
-    if (!job->exec()) {
-        qCWarning(PlasmaSetup) << "Failed to set temporary autologin for new user:" << job->errorString();
-    } else {
-        qCInfo(PlasmaSetup) << "Temporary autologin set for new user successfully.";
+KAuth::ExecuteJob *InitialStartUtil::provisionUserJob(const QStringList &operations)
+{
+    QStringList remainingOperations = operations;
+    remainingOperations.removeIf([this](const QString &operation) {
+        return m_completedProvisionOperations.contains(operation);
+    });
+    if (remainingOperations.isEmpty()) {
+        return nullptr;
     }
+
+    const auto completeOperation = [this, operations](const QString &operation) {
+        if (!operations.contains(operation) || m_completedProvisionOperations.contains(operation)) {
+            return;
+        }
+        m_completedProvisionOperations << operation;
+
+        const auto next = std::ranges::find_if(operations, [this](const QString &pending) {
+            return !m_completedProvisionOperations.contains(pending);
+        });
+        m_finishPipeline->setStepProgress(QStringLiteral("provisionuser"),
+                                          qreal(m_completedProvisionOperations.size()) / operations.size(),
+                                          provisionOperationDescription(next != operations.cend() ? *next : operations.last()));
+    };
+
+    KAuth::ExecuteJob *job = m_accountController->provisionUserJob(remainingOperations);
+    // The helper reports each operation once it is done, see PlasmaSetupAuthHelper::provisionuser()
+    connect(job, &KAuth::ExecuteJob::newData, this, [completeOperation](const QVariantMap &data) {
+        completeOperation(data.value(QStringLiteral("completedOperation")).toString());
+    });
+    connect(job, &KJob::result, this, [job, completeOperation]() {
+        const QStringList completedOperations = job->data().value(QStringLiteral("completedOperations")).toStringList();
+        for (const QString &operation : completedOperations) {
+            completeOperation(operation);
+        }
+    });
+    return job;
 }
 
-void InitialStartUtil::createCompletionFlag()
+QString InitialStartUtil::provisionOperationDescription(const QString &operation)
 {
-    qCInfo(PlasmaSetup) << "Creating plasma-setup completion flag file.";
+    if (operation == QLatin1String("createuser")) {
+        return i18nc("@info:status", "Creating user account…");
+    }
+    if (operation == QLatin1String("createflagfile")) {
+        return i18nc("@info:status", "Completing setup…");
+    }
+    return i18nc("@info:status", "Setting up the home folder…");
+}
 
-    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.createflagfile"));
+void InitialStartUtil::disablePlasmaSetupAutologin()
+{
+    if (!runningAsPlasmaSetupUser()) {
+        qCInfo(PlasmaSetup) << "Not running as plasma-setup user; skipping autologin removal.";
+        return;
+    }
+
+    qCInfo(PlasmaSetup) << "Removing autologin configuration for plasma-setup user.";
+
+    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.removeautologin"));
     action.setParentWindow(m_window);
     action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
+    action.setArguments(SystemConfig::instance().helperArguments());
     KAuth::ExecuteJob *job = action.execute();
+    m_autologinJob = job;
 
-    if (!job->exec()) {
-        qCWarning(PlasmaSetup) << "Failed to create completion flag file:" << job->errorString();
-    } else {
-        qCInfo(PlasmaSetup) << "Completion flag file created successfully.";
-    }
+    const qint64 traceStart = Tracer::timestamp();
+    connect(job, &KJob::result, this, [this, job, traceStart]() {
+        // Cleared first, finish() may be waiting for this job to be done
+        m_autologinJob = nullptr;
+        Tracer::addSpan(job->action().name(), QStringLiteral("kauth"), traceStart);
+        if (job->error()) {
+            qCWarning(PlasmaSetup) << "Failed to remove autologin configuration:" << job->errorString();
+        } else {
+            qCInfo(PlasmaSetup) << "Autologin configuration removed successfully.";
+        }
+        Q_EMIT autologinDisabled();
+    });
+    job->start();
+}
+
+bool InitialStartUtil::isDisablingAutologin() const
+{
+    return !m_autologinJob.isNull();
 }
 
-void InitialStartUtil::createNewUserAutostartHook()
+bool InitialStartUtil::runningAsPlasmaSetupUser()
 {
-    const QString username = m_accountController->username();
-    qCInfo(PlasmaSetup) << "Creating autostart hook for new user:" << username;
+    return (qgetenv("USER") == "plasma-setup");
+}
 
-    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.createnewuserautostarthook"));
+void InitialStartUtil::logOut()
+{
+    m_session.requestLogout(SessionManagement::ConfirmationMode::Skip);
+}
+
+KAuth::ExecuteJob *InitialStartUtil::completionFlagJob()
+{
+    qCInfo(PlasmaSetup) << "Creating plasma-setup completion flag file.";
+
+    KAuth::Action action(QStringLiteral("org.kde.plasmasetup.createflagfile"));
     action.setParentWindow(m_window);
     action.setHelperId(QStringLiteral("org.kde.plasmasetup"));
-    action.setArguments({{QStringLiteral("username"), username}});
-    KAuth::ExecuteJob *job = action.execute();
-
-    if (!job->exec()) {
-        qCWarning(PlasmaSetup) << "Failed to create autostart hook for new user:" << job->errorString();
-    } else {
-        qCInfo(PlasmaSetup) << "Autostart hook created successfully for new user.";
-    }
+    return action.execute();
 }
 
 #include "initialstartutil.moc"
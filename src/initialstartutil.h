@@ -6,6 +6,7 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
 #include <QWindow>
 #include <qqmlintegration.h>
 
@@ -14,6 +15,13 @@
 
 #include "accountcontroller.h"
 
+namespace KAuth
+{
+class ExecuteJob;
+}
+
+class FinishPipeline;
+
 class InitialStartUtil : public QObject
 {
     Q_OBJECT
@@ -21,6 +29,33 @@ class InitialStartUtil : public QObject
     QML_SINGLETON
     Q_PROPERTY(QString distroName READ distroName CONSTANT);
 
+    /**
+     * Whether the finishing steps started by finish() are currently running.
+     */
+    Q_PROPERTY(bool finishing READ isFinishing NOTIFY finishingChanged)
+
+    /**
+     * The fraction of finishing steps that are done, between 0 and 1.
+     */
+    Q_PROPERTY(qreal finishProgress READ finishProgress NOTIFY finishProgressChanged)
+
+    /**
+     * A localized description of what is currently being done to finish the setup.
+     */
+    Q_PROPERTY(QString finishStatus READ finishStatus NOTIFY finishProgressChanged)
+
+    /**
+     * The error messages of the finishing steps that failed, or an empty string.
+     */
+    Q_PROPERTY(QString finishError READ finishError NOTIFY finishErrorChanged)
+
+    /**
+     * Why preparing the finishing steps for the choices made so far failed, or an empty string.
+     *
+     * See prepareFinish().
+     */
+    Q_PROPERTY(QString preparationError READ preparationError NOTIFY preparationErrorChanged)
+
 public:
     InitialStartUtil(QObject *parent = nullptr);
 
@@ -28,16 +63,44 @@ public:
 
     /**
      * Completes the initial setup process.
+     *
+     * The finishing steps run in the background, and the session is logged out once they all
+     * succeeded. If a step fails, finishFailed() is emitted and finish() may be called again
+     * to retry the steps that did not succeed.
      */
     Q_INVOKABLE void finish();
 
     /**
-     * Removes the autologin configuration for Plasma Setup.
+     * Checks in the background what the finishing steps depend on, while the user is still in the wizard.
+     *
+     * Meant to be called whenever the user leaves a page, i.e. once the choices made on it are final. The
+     * check only runs again when the preparation arguments of the account changed since, see
+     * AccountController::preparationArguments(), the result of a check made for details that changed
+     * meanwhile is ignored. Problems such as a taken username are found before finishing rather than
+     * halfway through it, and the files of the new home directory are staged, so finishing only has
+     * to create the user and move them into place.
+     */
+    Q_INVOKABLE void prepareFinish();
+
+    bool isFinishing() const;
+    qreal finishProgress() const;
+    QString finishStatus() const;
+    QString finishError() const;
+    QString preparationError() const;
+
+    /**
+     * Starts removing the autologin configuration for Plasma Setup in the background.
      *
      * This allows the next login to be a normal login, unless the Plasma Setup systemd service runs again.
+     * Called on construction, autologinDisabled() is emitted once done. finish() waits for it.
      */
     void disablePlasmaSetupAutologin();
 
+    /**
+     * Whether the removal started by disablePlasmaSetupAutologin() is still running.
+     */
+    bool isDisablingAutologin() const;
+
     /**
      * Checks if the service is running as the plasma-setup user.
      *
@@ -51,39 +114,68 @@ public:
      */
     static bool runningAsPlasmaSetupUser();
 
+Q_SIGNALS:
+    void finishingChanged();
+    void finishProgressChanged();
+    void finishErrorChanged();
+    void preparationErrorChanged();
+
+    /**
+     * Emitted once the removal started by disablePlasmaSetupAutologin() is done, whether it succeeded or not.
+     */
+    void autologinDisabled();
+
+    /**
+     * Emitted when at least one of the finishing steps failed.
+     */
+    void finishFailed();
+
+    /**
+     * Emitted when one of the finishing steps started by finish() starts, and once it is done.
+     *
+     * See FinishPipeline::stepStarted() and FinishPipeline::stepFinished().
+     */
+    void finishStepStarted(const QString &id, const QString &description);
+    void finishStepFinished(const QString &id, bool success, const QString &errorString);
+
 private:
     /**
-     * Performs the finishing steps specific to the creation of the new user.
+     * Creates the pipeline running the finishing steps.
+     */
+    void createFinishPipeline();
+
+    /**
+     * Adds the finishing steps specific to the creation of the new user to the pipeline.
      *
      * Does not handle the system-wide completion steps such as network configuration, keyboard layout, etc.
      * This separation is needed for when Plasma Setup is run in a context where no user creation is needed.
      */
-    void doUserCreationSteps();
+    void addUserCreationSteps();
 
     /**
-     * Logs out of the plasma-setup user.
-     *
-     * This will cause the new user to be logged in automatically, since the autologin is set for the new user.
+     * Prepares the job running the given provisioning operations that have not succeeded yet.
      */
-    void logOut();
+    KAuth::ExecuteJob *provisionUserJob(const QStringList &operations);
 
     /**
-     * Enables temporary autologin for the specified new user.
-     *
-     * This function configures the system so that after the initial setup, the new user will be automatically logged in once,
-     * facilitating the transition from the plasma-setup user to the newly created user account.
+     * Returns the localized text shown while the given provisioning operation runs.
      */
-    void setNewUserTempAutologin();
+    static QString provisionOperationDescription(const QString &operation);
+
+    void setFinishError(const QString &finishError);
+    void setPreparationError(const QString &preparationError);
 
     /**
-     * Creates the completion flag file (usually /etc/plasma-setup-done) to indicate that initial setup is complete.
+     * Logs out of the plasma-setup user.
+     *
+     * This will cause the new user to be logged in automatically, since the autologin is set for the new user.
      */
-    void createCompletionFlag();
+    void logOut();
 
     /**
-     * Creates an autostart hook for the new user to cleanup the initial setup configuration.
+     * Prepares the job creating the completion flag file (usually /etc/plasma-setup-done) to indicate that initial setup is complete.
      */
-    void createNewUserAutostartHook();
+    KAuth::ExecuteJob *completionFlagJob();
 
     /*
      * The account controller instance that manages the new user account creation.
@@ -103,6 +195,35 @@ private:
      */
     QWindow *m_window = nullptr;
 
+    /**
+     * Runs the finishing steps, created on the first call to finish().
+     */
+    FinishPipeline *m_finishPipeline = nullptr;
+
+    QString m_finishError;
+
+    /**
+     * The arguments of the last preparation started by prepareFinish().
+     */
+    QVariantMap m_preparedArguments;
+
+    /**
+     * The preparation started by prepareFinish() while it is running, finish() waits for it.
+     */
+    QPointer<KAuth::ExecuteJob> m_preparationJob;
+
+    /**
+     * The removal of the autologin started on construction while it is running, finish() waits for it.
+     */
+    QPointer<KAuth::ExecuteJob> m_autologinJob;
+
+    QString m_preparationError;
+
+    /**
+     * The provisioning operations that already succeeded, skipped when retrying.
+     */
+    QStringList m_completedProvisionOperations;
+
     /**
      * Provides session management capabilities, notably for logging out of plasma-setup user session.
      */
@@ -0,0 +1,365 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "keyboardlayoutmodel.h"
+
+#include "plasmasetup_debug.h"
+#include "textsearch.h"
+
+#include <KLocalizedString>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace
+{
+/**
+ * Where the XKB data lives, unless overridden with the XKB_CONFIG_ROOT environment variable like libxkbcommon does.
+ */
+const QString DEFAULT_XKB_CONFIG_ROOT = QStringLiteral("/usr/share/X11/xkb");
+
+/**
+ * A layout or variant from the XKB rules.
+ */
+struct Entry {
+    QString shortName;
+    /** Empty for the layout itself. */
+    QString variantName;
+    /** The untranslated description. */
+    QString description;
+    /** For layouts, the index after their last variant. */
+    qsizetype groupEnd = 0;
+};
+
+/**
+ * Reads the layouts and their variants from the evdev rules, each layout followed by its variants.
+ */
+QList<Entry> parseRules()
+{
+    const QString path = qEnvironmentVariable("XKB_CONFIG_ROOT", DEFAULT_XKB_CONFIG_ROOT) + QStringLiteral("/rules/evdev.xml");
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(PlasmaSetup) << "Failed to read the keyboard layouts from" << path << ':' << file.errorString();
+        return {};
+    }
+
+    QList<Entry> entries;
+    Entry current;
+    qsizetype layoutEntry = -1;
+    bool inLayoutList = false;
+    bool inVariant = false;
+
+    QXmlStreamReader xml(&file);
+    while (!xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
+
+        if (token == QXmlStreamReader::StartElement) {
+            const QStringView name = xml.name();
+            if (name == u"layoutList") {
+                inLayoutList = true;
+            } else if (!inLayoutList) {
+                continue;
+            } else if (name == u"layout") {
+                current = {};
+                layoutEntry = -1;
+                inVariant = false;
+            } else if (name == u"variant") {
+                current = {};
+                current.shortName = layoutEntry >= 0 ? entries.at(layoutEntry).shortName : QString();
+                inVariant = true;
+            } else if (name == u"name") {
+                (inVariant ? current.variantName : current.shortName) = xml.readElementText();
+            } else if (name == u"description") {
+                current.description = xml.readElementText();
+            }
+        } else if (token == QXmlStreamReader::EndElement && inLayoutList) {
+            const QStringView name = xml.name();
+            if (name == u"layoutList") {
+                break;
+            } else if (name == u"configItem" && !current.shortName.isEmpty()) {
+                if (!inVariant) {
+                    layoutEntry = entries.size();
+                }
+                entries.append(current);
+            } else if (name == u"variant") {
+                inVariant = false;
+            } else if (name == u"layout" && layoutEntry >= 0) {
+                entries[layoutEntry].groupEnd = entries.size();
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        qCWarning(PlasmaSetup) << "Failed to parse the keyboard layouts from" << path << ':' << xml.errorString();
+    }
+
+    entries.squeeze();
+    return entries;
+}
+
+/**
+ * The layouts and variants, parsed on first use and shared by all models.
+ */
+const QList<Entry> &catalog()
+{
+    static const QList<Entry> entries = parseRules();
+    return entries;
+}
+}
+
+KeyboardLayoutModel::KeyboardLayoutModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    QCoreApplication::instance()->installEventFilter(this);
+
+    buildIndex();
+    updateBaseRows();
+    updateRows(false);
+}
+
+int KeyboardLayoutModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant KeyboardLayoutModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return {};
+    }
+
+    const qsizetype entry = m_rows.at(index.row());
+    switch (role) {
+    case ShortNameRole:
+        return catalog().at(entry).shortName;
+    case VariantNameRole:
+        return catalog().at(entry).variantName;
+    case Qt::DisplayRole:
+    case DescriptionRole:
+        return m_descriptions.at(entry);
+    }
+
+    return {};
+}
+
+QHash<int, QByteArray> KeyboardLayoutModel::roleNames() const
+{
+    return {
+        {Qt::DisplayRole, "display"},
+        {ShortNameRole, "shortName"},
+        {VariantNameRole, "variantName"},
+        {DescriptionRole, "description"},
+    };
+}
+
+bool KeyboardLayoutModel::variants() const
+{
+    return m_variants;
+}
+
+void KeyboardLayoutModel::setVariants(bool variants)
+{
+    if (m_variants == variants) {
+        return;
+    }
+    m_variants = variants;
+    Q_EMIT variantsChanged();
+
+    updateBaseRows();
+    updateRows(false);
+}
+
+QString KeyboardLayoutModel::layoutName() const
+{
+    return m_layoutName;
+}
+
+void KeyboardLayoutModel::setLayoutName(const QString &layoutName)
+{
+    if (m_layoutName == layoutName) {
+        return;
+    }
+    m_layoutName = layoutName;
+    Q_EMIT layoutNameChanged();
+
+    if (m_variants) {
+        updateBaseRows();
+        updateRows(false);
+    }
+}
+
+QString KeyboardLayoutModel::searchString() const
+{
+    return m_searchString;
+}
+
+void KeyboardLayoutModel::setSearchString(const QString &searchString)
+{
+    if (m_searchString == searchString) {
+        return;
+    }
+    m_searchString = searchString;
+    Q_EMIT searchStringChanged();
+
+    const QString folded = TextSearch::fold(searchString.trimmed());
+    if (folded == m_foldedSearchString) {
+        return;
+    }
+
+    // Anything matching the longer string also matched the previous one
+    const bool narrow = folded.contains(m_foldedSearchString);
+    m_foldedSearchString = folded;
+    updateRows(narrow);
+}
+
+int KeyboardLayoutModel::indexOf(const QString &shortName, const QString &variantName) const
+{
+    const QList<Entry> &entries = catalog();
+    for (qsizetype row = 0; row < m_rows.size(); ++row) {
+        const Entry &entry = entries.at(m_rows.at(row));
+        if (entry.shortName == shortName && entry.variantName == variantName) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+bool KeyboardLayoutModel::eventFilter(QObject *object, QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange && object == QCoreApplication::instance()) {
+        buildIndex();
+        updateRows(false);
+    }
+
+    return QAbstractListModel::eventFilter(object, event);
+}
+
+void KeyboardLayoutModel::buildIndex()
+{
+    const QList<Entry> &entries = catalog();
+
+    m_descriptions.clear();
+    m_foldedNames.clear();
+    m_foldedDescriptions.clear();
+    m_descriptions.reserve(entries.size());
+    m_foldedNames.reserve(entries.size());
+    m_foldedDescriptions.reserve(entries.size());
+
+    for (const Entry &entry : entries) {
+        // The descriptions are translated by xkeyboard-config
+        const QString description = entry.description.isEmpty() ? QString() : i18nd("xkeyboard-config", entry.description.toUtf8().constData());
+        m_descriptions.append(description);
+        m_foldedNames.append(TextSearch::fold(entry.variantName.isEmpty() ? entry.shortName : entry.variantName));
+        m_foldedDescriptions.append(TextSearch::fold(description));
+    }
+}
+
+void KeyboardLayoutModel::updateBaseRows()
+{
+    const QList<Entry> &entries = catalog();
+    m_baseRows.clear();
+
+    if (!m_variants) {
+        for (qsizetype i = 0; i < entries.size(); ++i) {
+            if (entries.at(i).variantName.isEmpty()) {
+                m_baseRows.append(i);
+            }
+        }
+        return;
+    }
+
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+        if (entry.variantName.isEmpty() && entry.shortName == m_layoutName) {
+            for (qsizetype variant = i; variant < entry.groupEnd; ++variant) {
+                m_baseRows.append(variant);
+            }
+            return;
+        }
+    }
+}
+
+void KeyboardLayoutModel::updateRows(bool narrow)
+{
+    beginResetModel();
+
+    if (m_foldedSearchString.isEmpty()) {
+        m_matches = m_baseRows;
+        m_rows = m_baseRows;
+    } else {
+        const QList<qsizetype> candidates = narrow ? std::exchange(m_matches, {}) : m_baseRows;
+        m_matches.clear();
+
+        QList<std::pair<Rank, qsizetype>> ranked;
+        for (const qsizetype entry : candidates) {
+            const Rank entryRank = m_variants ? rank(entry, m_foldedSearchString) : layoutRank(entry, m_foldedSearchString);
+            if (entryRank != NoMatch) {
+                ranked.append({entryRank, entry});
+                m_matches.append(entry);
+            }
+        }
+
+        std::ranges::stable_sort(ranked, {}, &std::pair<Rank, qsizetype>::first);
+        m_rows.clear();
+        m_rows.reserve(ranked.size());
+        for (const auto &[entryRank, entry] : std::as_const(ranked)) {
+            m_rows.append(entry);
+        }
+
+        // The layout itself matched, so all of its variants are relevant
+        if (m_variants && m_rows.isEmpty()) {
+            m_rows = m_baseRows;
+        }
+    }
+
+    endResetModel();
+}
+
+KeyboardLayoutModel::Rank KeyboardLayoutModel::rank(qsizetype entry, QStringView foldedQuery) const
+{
+    Rank best = NoMatch;
+
+    const std::array<std::pair<QStringView, bool>, 2> fields = {
+        std::pair<QStringView, bool>{m_foldedDescriptions.at(entry), false},
+        std::pair<QStringView, bool>{m_foldedNames.at(entry), true},
+    };
+    for (const auto &[text, isName] : fields) {
+        Rank fieldRank = NoMatch;
+        switch (TextSearch::match(text, foldedQuery)) {
+        case TextSearch::ExactMatch:
+            fieldRank = ExactMatch;
+            break;
+        case TextSearch::PrefixMatch:
+            fieldRank = isName ? NamePrefixMatch : DescriptionPrefixMatch;
+            break;
+        case TextSearch::WordPrefixMatch:
+            fieldRank = WordPrefixMatch;
+            break;
+        case TextSearch::SubstringMatch:
+            fieldRank = SubstringMatch;
+            break;
+        case TextSearch::NoMatch:
+            break;
+        }
+
+        best = std::min(best, fieldRank);
+    }
+
+    return best;
+}
+
+KeyboardLayoutModel::Rank KeyboardLayoutModel::layoutRank(qsizetype entry, QStringView foldedQuery) const
+{
+    Rank best = rank(entry, foldedQuery);
+    for (qsizetype variant = entry + 1; variant < catalog().at(entry).groupEnd && best != ExactMatch; ++variant) {
+        best = std::min(best, rank(variant, foldedQuery));
+    }
+    return best;
+}
+
+#include "moc_keyboardlayoutmodel.cpp"
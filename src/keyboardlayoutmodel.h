@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QQmlEngine>
+
+/**
+ * The keyboard layouts, or the variants of one layout, known to XKB.
+ *
+ * The XKB rules are parsed once per process and shared by every instance, so recreating
+ * the keyboard page is cheap. The translated descriptions are folded into a search index
+ * when the model is created and when the language changes, so filtering only compares
+ * precomputed strings.
+ *
+ * Results are ranked by how well they match searchString. When the search string is
+ * extended, only the rows that matched the previous one are looked at again.
+ */
+class KeyboardLayoutModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    /**
+     * Whether the model lists the variants of layoutName rather than the layouts.
+     *
+     * The variants include the layout itself, with an empty variant name.
+     */
+    Q_PROPERTY(bool variants READ variants WRITE setVariants NOTIFY variantsChanged)
+
+    /**
+     * The layout whose variants are listed, e.g. "us".
+     */
+    Q_PROPERTY(QString layoutName READ layoutName WRITE setLayoutName NOTIFY layoutNameChanged)
+
+    /**
+     * Only rows matching this text are listed, best matches first.
+     *
+     * Matching is case and diacritic insensitive, and looks at the names and descriptions.
+     * Layouts also match through their variants. A list of variants falls back to all
+     * variants if none of them match, as the layout itself matched.
+     */
+    Q_PROPERTY(QString searchString READ searchString WRITE setSearchString NOTIFY searchStringChanged)
+
+public:
+    enum Roles {
+        ShortNameRole = Qt::UserRole + 1,
+        VariantNameRole,
+        DescriptionRole,
+    };
+    Q_ENUM(Roles)
+
+    explicit KeyboardLayoutModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool variants() const;
+    void setVariants(bool variants);
+
+    QString layoutName() const;
+    void setLayoutName(const QString &layoutName);
+
+    QString searchString() const;
+    void setSearchString(const QString &searchString);
+
+    /**
+     * Returns the row of the given layout and variant, or -1 if it is not listed.
+     *
+     * @param shortName The layout, e.g. "us".
+     * @param variantName The variant, e.g. "intl", or an empty string for the layout itself.
+     */
+    Q_INVOKABLE int indexOf(const QString &shortName, const QString &variantName) const;
+
+Q_SIGNALS:
+    void variantsChanged();
+    void layoutNameChanged();
+    void searchStringChanged();
+
+private:
+    /**
+     * How well a row matches the search string, lower is better.
+     */
+    enum Rank {
+        ExactMatch,
+        DescriptionPrefixMatch,
+        NamePrefixMatch,
+        WordPrefixMatch,
+        SubstringMatch,
+        NoMatch,
+    };
+
+    /**
+     * Retranslates the descriptions when the language changes.
+     */
+    bool eventFilter(QObject *object, QEvent *event) override;
+
+    /**
+     * Translates and folds the descriptions of all layouts and variants.
+     */
+    void buildIndex();
+
+    /**
+     * Collects the rows listed without a search string, in display order.
+     */
+    void updateBaseRows();
+
+    /**
+     * Filters and ranks the base rows for the current search string.
+     *
+     * @param narrow Whether the search string only got longer, so the previous matches can be reused.
+     */
+    void updateRows(bool narrow);
+
+    Rank rank(qsizetype entry, QStringView foldedQuery) const;
+
+    /**
+     * The rank of a layout, including the best rank of its variants.
+     */
+    Rank layoutRank(qsizetype entry, QStringView foldedQuery) const;
+
+    bool m_variants = false;
+    QString m_layoutName;
+    QString m_searchString;
+
+    /** The folded search string the current rows were filtered with. */
+    QString m_foldedSearchString;
+
+    /** The translated descriptions, per entry of the catalog. */
+    QStringList m_descriptions;
+
+    /** The folded names and descriptions, per entry of the catalog. */
+    QStringList m_foldedNames;
+    QStringList m_foldedDescriptions;
+
+    /** The entries listed without a search string, in display order. */
+    QList<qsizetype> m_baseRows;
+
+    /** The base rows matching m_foldedSearchString, in display order. */
+    QList<qsizetype> m_matches;
+
+    /** The entries listed, best match first. */
+    QList<qsizetype> m_rows;
+};
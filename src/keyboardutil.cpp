@@ -8,20 +8,45 @@
 
 #include <KConfig>
 #include <KConfigGroup>
+#include <KSharedConfig>
 
 #include <QDBusArgument>
 #include <QDBusConnection>
-#include <QDBusInterface>
-#include <QDBusReply>
 #include <QDebug>
 #include <QFile>
 #include <QProcess>
 #include <QTextStream>
 
+/**
+ * The key of the system keyboard layout in the committed system settings.
+ */
+const QString X11_KEYBOARD_SETTING = QStringLiteral("x11Keyboard");
+
+/**
+ * Default keyboard model, hardcoded since we don't have a way to detect the actual model for now.
+ */
+const QString DEFAULT_KEYBOARD_MODEL = QStringLiteral("pc105");
+
 KeyboardUtil::KeyboardUtil(QObject *parent)
     : QObject(parent)
+    , m_locale1(QStringLiteral("org.freedesktop.locale1"),
+                QStringLiteral("/org/freedesktop/locale1"),
+                QStringLiteral("org.freedesktop.locale1"),
+                QDBusConnection::systemBus())
+    , m_systemSettings(QDBusConnection::systemBus())
 {
-    readCurrentKeyboardLayout();
+    connect(&m_systemSettings, &SystemSettingsCommitter::committed, this, [](const QString &key, const QString &errorMessage) {
+        Q_UNUSED(key)
+        if (!errorMessage.isEmpty()) {
+            qCWarning(PlasmaSetup) << "Failed to set system default keyboard layout:" << errorMessage;
+        } else {
+            qCInfo(PlasmaSetup) << "Successfully set system default keyboard layout.";
+        }
+    });
+    connect(&m_systemSettings, &SystemSettingsCommitter::allCommitted, this, &KeyboardUtil::systemSettingsCommitted);
+
+    connect(&m_locale1, &SystemPropertyCache::loaded, this, &KeyboardUtil::readCurrentKeyboardLayout);
+    connect(&m_locale1, &SystemPropertyCache::propertiesChanged, this, &KeyboardUtil::readCurrentKeyboardLayout);
 }
 
 QString KeyboardUtil::layoutName() const
@@ -82,21 +107,33 @@ void KeyboardUtil::applyLayout()
         return;
     }
 
+    m_layoutChosen = true;
+
     qCInfo(PlasmaSetup) << "Applying keyboard layout:" << m_layoutName << "with variant:" << m_layoutVariant << "and options:" << m_layoutOptions;
 
-    applyLayoutForCurrentUser();
+    previewLayoutForCurrentUser();
     applyLayoutAsSystemDefault();
 }
 
-void KeyboardUtil::applyLayoutForCurrentUser()
+void KeyboardUtil::previewLayoutForCurrentUser()
 {
-    auto config = new KConfig(QStringLiteral("kxkbrc"), KConfig::NoGlobals);
-    KConfigGroup group = config->group(QStringLiteral("Layout"));
-    group.writeEntry(QStringLiteral("DisplayNames"), "", KConfig::Notify);
-    group.writeEntry(QStringLiteral("LayoutList"), m_layoutName, KConfig::Notify);
-    group.writeEntry(QStringLiteral("VariantList"), m_layoutVariant, KConfig::Notify);
-    config->sync();
-    delete config;
+    if (!m_keyboardConfig) {
+        m_keyboardConfig = KSharedConfig::openConfig(QStringLiteral("kxkbrc"), KConfig::NoGlobals);
+    }
+
+    // No KConfig::Notify, only the compositor needs to follow the layout while the user is browsing
+    KConfigGroup group = m_keyboardConfig->group(QStringLiteral("Layout"));
+    group.writeEntry(QStringLiteral("DisplayNames"), QString());
+    group.writeEntry(QStringLiteral("LayoutList"), m_layoutName);
+    group.writeEntry(QStringLiteral("VariantList"), m_layoutVariant);
+    if (!m_keyboardConfig->isDirty()) {
+        return;
+    }
+    m_keyboardConfig->sync();
+
+    // The compositor reads the layouts from kxkbrc when told to, like the keyboard KCM does
+    QDBusMessage message = QDBusMessage::createSignal(QStringLiteral("/Layouts"), QStringLiteral("org.kde.keyboard"), QStringLiteral("reloadConfig"));
+    QDBusConnection::sessionBus().send(message);
 }
 
 void KeyboardUtil::applyLayoutAsSystemDefault()
@@ -111,37 +148,38 @@ void KeyboardUtil::applyLayoutAsSystemDefault()
         QStringLiteral("SetX11Keyboard") //
     );
 
-    // Default model is hardcoded, since we don't have a way to detect the actual model for now.
-    const QString model = QStringLiteral("pc105");
     // Convert option allows the layout to be applied everywhere with a single command.
     const bool convert = true;
     const bool interactive = false;
 
-    message << m_layoutName << model << m_layoutVariant << m_layoutOptions << convert << interactive;
+    message << m_layoutName << DEFAULT_KEYBOARD_MODEL << m_layoutVariant << m_layoutOptions << convert << interactive;
 
-    QDBusMessage resultMessage = QDBusConnection::systemBus().call(message);
+    // Written once the user leaves the page, see commitSystemSettings()
+    m_systemSettings.stage(X11_KEYBOARD_SETTING, QStringList{m_layoutName, DEFAULT_KEYBOARD_MODEL, m_layoutVariant, m_layoutOptions}, message);
+}
 
-    if (resultMessage.type() == QDBusMessage::ErrorMessage) {
-        qCWarning(PlasmaSetup) << "Failed to set system default keyboard layout:" << resultMessage.errorMessage();
-    } else {
-        qCInfo(PlasmaSetup) << "Successfully set system default keyboard layout.";
-    }
+void KeyboardUtil::commitSystemSettings()
+{
+    m_systemSettings.commit();
 }
 
 void KeyboardUtil::readCurrentKeyboardLayout()
 {
-    const QString locale1Service = QStringLiteral("org.freedesktop.locale1");
-    const QString locale1Path = QStringLiteral("/org/freedesktop/locale1");
+    const QString layoutName = m_locale1.value(QStringLiteral("X11Layout")).toString();
+    const QString model = m_locale1.value(QStringLiteral("X11Model")).toString();
+    const QString layoutVariant = m_locale1.value(QStringLiteral("X11Variant")).toString();
+    const QString layoutOptions = m_locale1.value(QStringLiteral("X11Options")).toString();
+
+    m_systemSettings.setCurrentValue(X11_KEYBOARD_SETTING, QStringList{layoutName, model, layoutVariant, layoutOptions});
 
-    QDBusInterface interface(locale1Service, locale1Path, QStringLiteral("org.freedesktop.locale1"), QDBusConnection::systemBus());
-    if (!interface.isValid()) {
-        qCWarning(PlasmaSetup) << "Failed to connect to dbus interface for reading current keyboard layout:" << interface.lastError().message();
+    // Don't replace what the user chose with what the system currently has
+    if (m_layoutChosen) {
         return;
     }
 
-    m_layoutName = interface.property("X11Layout").toString();
-    m_layoutVariant = interface.property("X11Variant").toString();
-    m_layoutOptions = interface.property("X11Options").toString();
+    setLayoutName(layoutName);
+    setLayoutVariant(layoutVariant);
+    setLayoutOptions(layoutOptions);
 }
 
 #include "moc_keyboardutil.cpp"
@@ -3,9 +3,14 @@
 
 #pragma once
 
+#include <KSharedConfig>
+
 #include <QObject>
 #include <QQmlEngine>
 
+#include "systempropertycache.h"
+#include "systemsettingscommitter.h"
+
 /**
  * Handles keyboard layout choice.
  *
@@ -69,19 +74,40 @@ public:
 
     /**
      * Applies the current keyboard layout choices to the current user and the system default.
+     *
+     * The layout is previewed in the current session right away, while the system default
+     * is staged and written by commitSystemSettings().
      */
     Q_INVOKABLE void applyLayout();
 
+    /**
+     * Writes the chosen keyboard layout as the system default.
+     *
+     * Meant to be called when the user leaves the keyboard page, so that only the layout
+     * finally chosen is written to the system.
+     */
+    Q_INVOKABLE void commitSystemSettings();
+
 Q_SIGNALS:
     void layoutNameChanged();
     void layoutVariantChanged();
     void layoutOptionsChanged();
 
+    /**
+     * Emitted once the settings written by commitSystemSettings() have been written.
+     *
+     * @param errorMessages The errors of the writes that failed, empty if all succeeded.
+     */
+    void systemSettingsCommitted(const QStringList &errorMessages);
+
 private:
     /**
-     * Applies the currently set keyboard layout for the current user.
+     * Switches the session to the currently set keyboard layout.
+     *
+     * Only the compositor is told about the change, so browsing layouts does not make
+     * every KDE process reload the keyboard configuration.
      */
-    void applyLayoutForCurrentUser();
+    void previewLayoutForCurrentUser();
 
     /**
      * Applies the currently set keyboard layout as the system default.
@@ -90,10 +116,23 @@ private:
 
     /**
      * Reads the current keyboard layout from the system and updates the properties accordingly.
+     *
+     * The properties are only updated as long as the user has not applied a layout.
      */
     void readCurrentKeyboardLayout();
 
     QString m_layoutName;
     QString m_layoutVariant;
     QString m_layoutOptions;
+
+    /** Whether the user applied a layout, which then takes precedence over the system's. */
+    bool m_layoutChosen = false;
+
+    /** The keyboard configuration of the current user, kept open while previewing layouts. */
+    KSharedConfigPtr m_keyboardConfig;
+
+    /** The properties of org.freedesktop.locale1. */
+    SystemPropertyCache m_locale1;
+
+    SystemSettingsCommitter m_systemSettings;
 };
@@ -11,18 +11,28 @@
 #include <QApplication>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
+#include <QFile>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQmlEngine>
 #include <QQuickStyle>
+#include <QQuickWindow>
 #include <QUrl>
 
+#include <memory>
+
 #include "../plasma-setup-version.h"
+#include "headlesssetup.h"
 #include "initialstartutil.h"
+#include "modulecache.h"
+#include "tracer.h"
 
 using namespace Qt::StringLiterals;
 
 int main(int argc, char *argv[])
 {
+    const qint64 startTime = Tracer::timestamp();
+
     QApplication app(argc, argv);
 
     KLocalizedString::setApplicationDomain("org.kde.plasmasetup");
@@ -38,26 +48,74 @@ int main(int argc, char *argv[])
                      KAboutLicense::GPL_V3,
                      i18n("© 2021-2024 KDE Community"));
 
-    QQmlApplicationEngine engine;
-
     QCommandLineParser parser;
     parser.addOption(QCommandLineOption(QStringLiteral("remove-autologin"), i18n("Remove the Plasma Setup autologin configuration.")));
+    parser.addOption(QCommandLineOption(QStringLiteral("answers"),
+                                        i18n("Set up the system with the answers from the given file, without showing the wizard."),
+                                        i18nc("@info:shell value of the --answers option", "file")));
+    parser.addOption(QCommandLineOption(QStringLiteral("trace"),
+                                        i18n("Record how long startup and each step take, to the given file in the Chrome trace format or to the journal."),
+                                        i18nc("@info:shell value of the --trace option", "file|journal")));
     about.setupCommandLine(&parser);
     parser.process(app);
     about.processCommandLine(&parser);
 
+    // Set before anything records a span, the modules read it as well
+    if (parser.isSet(QStringLiteral("trace"))) {
+        qputenv(Tracer::ENVIRONMENT_VARIABLE, parser.value(QStringLiteral("trace")).toLocal8Bit());
+    }
+    const QString traceTarget = qEnvironmentVariable(Tracer::ENVIRONMENT_VARIABLE);
+    if (!traceTarget.isEmpty() && traceTarget != QLatin1String("journal")) {
+        // One trace per run
+        QFile::remove(traceTarget);
+    }
+
     if (parser.isSet(QStringLiteral("remove-autologin"))) {
+        // Removing the autologin is started on construction
         InitialStartUtil util;
-        util.disablePlasmaSetupAutologin();
-        return 0;
+        if (!util.isDisablingAutologin()) {
+            return 0;
+        }
+        QObject::connect(&util, &InitialStartUtil::autologinDisabled, &app, &QCoreApplication::quit);
+        return app.exec();
     }
 
+    if (parser.isSet(QStringLiteral("answers"))) {
+        // Only the singletons of the modules are needed, none of their pages
+        QQmlEngine engine;
+        HeadlessSetup setup(&engine);
+        if (const QString error = setup.load(parser.value(QStringLiteral("answers"))); !error.isEmpty()) {
+            qCritical().noquote() << error;
+            return 1;
+        }
+        QObject::connect(&setup, &HeadlessSetup::finished, &app, [](bool success) {
+            QCoreApplication::exit(success ? 0 : 1);
+        });
+        setup.start();
+        return app.exec();
+    }
+
+    QQmlApplicationEngine engine;
+
+    ModuleCache::setUpDiskCache();
+
     KLocalization::setupLocalizedContext(&engine);
+
+    Tracer::Span loadSpan(u"Load Main"_s, u"startup"_s);
     engine.loadFromModule("org.kde.plasmasetup"_L1, "Main"_L1);
+    loadSpan.end();
 
     if (engine.rootObjects().isEmpty()) {
         return -1;
     }
 
+    if (auto window = qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst()); window && Tracer::isEnabled()) {
+        auto connection = std::make_shared<QMetaObject::Connection>();
+        *connection = QObject::connect(window, &QQuickWindow::frameSwapped, window, [startTime, connection]() {
+            QObject::disconnect(*connection);
+            Tracer::addSpan(u"Startup until the first frame"_s, u"startup"_s, startTime);
+        });
+    }
+
     return app.exec();
 }
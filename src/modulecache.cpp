@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "modulecache.h"
+
+#include "../plasma-setup-version.h"
+#include "cachedirectory.h"
+#include "plasmasetup_debug.h"
+#include "tracer.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace
+{
+/**
+ * Where the QML of the modules shipped with Plasma Setup is compiled into, see modules/CMakeLists.txt.
+ */
+const QString COMPILED_MODULES_PATH = QStringLiteral(":/qt/qml/org/kde/plasmasetup/modules/");
+
+/**
+ * The prefix of the plugin ids of the modules shipped with Plasma Setup, followed by their directory name.
+ */
+constexpr QLatin1StringView BUNDLED_MODULE_PREFIX("org.kde.plasmasetup.");
+
+/**
+ * Returns the compiled copy of the package with the given plugin id, empty if there is none.
+ */
+QString compiledPackagePath(const QString &pluginId)
+{
+    if (!pluginId.startsWith(BUNDLED_MODULE_PREFIX)) {
+        return QString();
+    }
+
+    const QString path = COMPILED_MODULES_PATH + QStringView(pluginId).sliced(BUNDLED_MODULE_PREFIX.size()) + QLatin1Char('/');
+    return QDir(path).exists() ? path : QString();
+}
+
+/**
+ * Where the packages found identical to their compiled copy are remembered, see verifiedStamps().
+ */
+QString verifiedPackagesPath()
+{
+    return CacheDirectory::path() + QStringLiteral("/verifiedmodules.json");
+}
+
+/**
+ * Returns the stamps of the installed packages found identical to their compiled copy, keyed by plugin id.
+ *
+ * Only the stamps recorded by this version of Plasma Setup are returned, older ones were compared
+ * against other compiled files.
+ */
+QJsonObject &verifiedStamps()
+{
+    static QJsonObject stamps = []() {
+        QFile file(verifiedPackagesPath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QJsonObject();
+        }
+        const QJsonObject verified = QJsonDocument::fromJson(file.readAll()).object();
+        if (verified.value(QStringLiteral("version")).toString() != QLatin1StringView(PLASMASETUP_VERSION_STRING)) {
+            return QJsonObject();
+        }
+        return verified.value(QStringLiteral("modules")).toObject();
+    }();
+    return stamps;
+}
+
+void writeVerifiedStamps()
+{
+    const QJsonObject verified{
+        {QStringLiteral("version"), QStringLiteral(PLASMASETUP_VERSION_STRING)},
+        {QStringLiteral("modules"), verifiedStamps()},
+    };
+
+    const QString path = verifiedPackagesPath();
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(PlasmaSetup) << "Unable to write" << path << ':' << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(verified).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(PlasmaSetup) << "Unable to write" << path << ':' << file.errorString();
+    }
+}
+
+/**
+ * Whether every file of the compiled copy is identical to the installed one.
+ *
+ * The contents are only compared the first time, and again whenever the size or modification
+ * time of an installed file changed. A file of another size differs without reading it.
+ */
+bool matchesInstalledFiles(const QString &pluginId, const QString &compiledPath, const QString &installedPath)
+{
+    const QDir installedDirectory(installedPath);
+    QStringList compiledFilePaths;
+    QStringList stamps;
+    QDirIterator it(compiledPath, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString compiledFilePath = it.next();
+        const QString relativePath = compiledFilePath.sliced(compiledPath.size());
+        const QFileInfo installedInfo(installedDirectory.filePath(relativePath));
+        if (!installedInfo.isFile() || installedInfo.size() != it.fileInfo().size()) {
+            return false;
+        }
+        compiledFilePaths << compiledFilePath;
+        stamps << relativePath + QLatin1Char('@') + QString::number(installedInfo.size()) + QLatin1Char('@')
+                + QString::number(installedInfo.lastModified().toMSecsSinceEpoch());
+    }
+    stamps.sort();
+    const QString stamp = stamps.join(QLatin1Char(':'));
+
+    if (verifiedStamps().value(pluginId).toString() == stamp) {
+        return true;
+    }
+
+    for (const QString &compiledFilePath : std::as_const(compiledFilePaths)) {
+        QFile compiledFile(compiledFilePath);
+        QFile installedFile(installedDirectory.filePath(compiledFilePath.sliced(compiledPath.size())));
+        if (!compiledFile.open(QIODevice::ReadOnly) || !installedFile.open(QIODevice::ReadOnly) || compiledFile.readAll() != installedFile.readAll()) {
+            return false;
+        }
+    }
+
+    verifiedStamps().insert(pluginId, stamp);
+    writeVerifiedStamps();
+    return true;
+}
+}
+
+namespace ModuleCache
+{
+QString mainScript(const ModuleInfo &module)
+{
+    const QString installedPath = module.mainScript;
+    const QString pluginId = module.pluginId();
+    const QString compiledPath = compiledPackagePath(pluginId);
+    if (compiledPath.isEmpty()) {
+        return installedPath;
+    }
+
+    // The files are only compared once per package
+    static QHash<QString, QString> mainScripts;
+    if (const auto it = mainScripts.constFind(installedPath); it != mainScripts.cend()) {
+        return *it;
+    }
+
+    Tracer::Span span(QStringLiteral("Verify ") + pluginId, QStringLiteral("modules"));
+    QString mainScript = QStringLiteral("qrc") + compiledPath + QStringLiteral("contents/ui/main.qml");
+    if (!matchesInstalledFiles(pluginId, compiledPath, module.path)) {
+        qCInfo(PlasmaSetup) << "The installed files of" << pluginId << "differ from the ones Plasma Setup was built with, compiling them instead.";
+        mainScript = installedPath;
+    }
+
+    mainScripts.insert(installedPath, mainScript);
+    return mainScript;
+}
+
+void setUpDiskCache()
+{
+    if (qEnvironmentVariableIsSet("QML_DISK_CACHE_PATH") || qEnvironmentVariableIsSet("QML_DISABLE_DISK_CACHE")) {
+        return;
+    }
+
+    // The engine checks each cached file against the timestamp of its source, the key makes
+    // sure nothing compiled for another version of a module is ever picked up.
+    QStringList versions{QStringLiteral(PLASMASETUP_VERSION_STRING)};
+    const QList<ModuleInfo> modules = ModuleIndex::modules();
+    for (const ModuleInfo &module : modules) {
+        if (compiledPackagePath(module.pluginId()).isEmpty()) {
+            versions << module.pluginId() + QLatin1Char('@') + module.metadata.version();
+        }
+    }
+    versions.sort();
+    const QByteArray key = QCryptographicHash::hash(versions.join(QLatin1Char('\n')).toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+
+    // Kept across boots, the home of the plasma-setup user is a tmpfs
+    const QString cacheRoot = CacheDirectory::path() + QStringLiteral("/modulecache/");
+
+    // Caches for other versions are never used again
+    const QStringList cacheDirectories = QDir(cacheRoot).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &directory : cacheDirectories) {
+        if (directory != QLatin1StringView(key)) {
+            QDir(cacheRoot + directory).removeRecursively();
+        }
+    }
+
+    qputenv("QML_DISK_CACHE_PATH", QFile::encodeName(cacheRoot) + key);
+}
+}
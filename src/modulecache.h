@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "moduleindex.h"
+
+#include <QString>
+
+/**
+ * Avoids compiling the QML of the modules on every start of the wizard.
+ *
+ * The modules shipped with Plasma Setup are compiled ahead of time into the executable, see
+ * modules/CMakeLists.txt. Their installed packages are still what is discovered, the compiled
+ * copy is only used as long as it matches the installed files, so patched packages keep working.
+ * The packages found identical are remembered along with the sizes and modification times of
+ * their files, so the contents are only compared again after a package was modified.
+ *
+ * Other modules are compiled by the QML engine, which keeps the result in its disk cache.
+ * That cache is placed in a directory keyed on the versions of those modules. Both are kept
+ * in the persistent cache directory, see CacheDirectory.
+ */
+namespace ModuleCache
+{
+/**
+ * Returns the URL of the main QML file of the given module.
+ *
+ * This is the compiled copy for modules shipped with Plasma Setup whose installed files
+ * were not modified, the installed file otherwise.
+ */
+QString mainScript(const ModuleInfo &module);
+
+/**
+ * Points the disk cache of the QML engine to the directory for the installed modules.
+ *
+ * Must be called before the QML engine compiles its first file. Does nothing if the
+ * QML_DISK_CACHE_PATH environment variable is already set or the disk cache is disabled.
+ */
+void setUpDiskCache();
+}
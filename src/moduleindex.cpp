@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "moduleindex.h"
+
+#include "cachedirectory.h"
+#include "plasmasetup_debug.h"
+
+#include <KPackage/PackageLoader>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <optional>
+
+namespace
+{
+/**
+ * The package type of the modules, and the directory their packages are installed to.
+ */
+const QString PACKAGE_FORMAT = QStringLiteral("KDE/PlasmaSetup");
+const QString PACKAGE_ROOT = QStringLiteral("plasma/packages");
+
+/**
+ * The version of the format of the index, to be increased whenever it changes.
+ */
+constexpr int INDEX_VERSION = 1;
+
+QString indexPath()
+{
+    return CacheDirectory::path() + QStringLiteral("/moduleindex.json");
+}
+
+/**
+ * Returns a key changing whenever the given file or directory is modified.
+ */
+QString modificationStamp(const QString &path)
+{
+    const QFileInfo info(path);
+    return info.exists() ? QString::number(info.lastModified().toMSecsSinceEpoch()) : QStringLiteral("-");
+}
+
+/**
+ * Returns a key changing whenever a package is added to or removed from one of the package roots.
+ */
+QString packageRootsStamp()
+{
+    QStringList stamps;
+    const QStringList dataDirectories = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataDirectory : dataDirectories) {
+        stamps << modificationStamp(dataDirectory + QLatin1Char('/') + PACKAGE_ROOT);
+    }
+    return stamps.join(QLatin1Char(':'));
+}
+
+ModuleInfo moduleInfo(const KPluginMetaData &metadata, int weight)
+{
+    const QString path = QFileInfo(metadata.fileName()).absolutePath() + QLatin1Char('/');
+    return {
+        .metadata = metadata,
+        .path = path,
+        // See PlasmaSetupPackageStructure
+        .mainScript = path + QStringLiteral("contents/ui/main.qml"),
+        .weight = weight,
+    };
+}
+
+/**
+ * Discovers the modules through KPackage.
+ */
+QList<ModuleInfo> scanModules()
+{
+    QList<ModuleInfo> modules;
+    const QList<KPluginMetaData> plugins = KPackage::PackageLoader::self()->listPackages(PACKAGE_FORMAT);
+    for (const KPluginMetaData &plugin : plugins) {
+        modules.append(moduleInfo(plugin, plugin.rawData().value(QStringLiteral("X-KDE-Weight")).toInt()));
+    }
+
+    // The weight is only read once per module, not for every comparison
+    std::ranges::stable_sort(modules, {}, &ModuleInfo::weight);
+    return modules;
+}
+
+/**
+ * Reads the index, unless it is missing or outdated.
+ */
+std::optional<QList<ModuleInfo>> readIndex(const QString &rootsStamp)
+{
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    if (index.value(QStringLiteral("version")).toInt() != INDEX_VERSION || index.value(QStringLiteral("roots")).toString() != rootsStamp) {
+        return std::nullopt;
+    }
+
+    QList<ModuleInfo> modules;
+    const QJsonArray entries = index.value(QStringLiteral("modules")).toArray();
+    for (const QJsonValue &value : entries) {
+        const QJsonObject entry = value.toObject();
+        const QString metadataPath = entry.value(QStringLiteral("metadataPath")).toString();
+        if (metadataPath.isEmpty() || modificationStamp(metadataPath) != entry.value(QStringLiteral("stamp")).toString()) {
+            return std::nullopt;
+        }
+
+        const KPluginMetaData metadata(entry.value(QStringLiteral("metadata")).toObject(), metadataPath);
+        modules.append(moduleInfo(metadata, entry.value(QStringLiteral("weight")).toInt()));
+    }
+    return modules;
+}
+
+void writeIndex(const QString &rootsStamp, const QList<ModuleInfo> &modules)
+{
+    QJsonArray entries;
+    for (const ModuleInfo &module : modules) {
+        entries.append(QJsonObject{
+            {QStringLiteral("metadataPath"), module.metadata.fileName()},
+            {QStringLiteral("stamp"), modificationStamp(module.metadata.fileName())},
+            {QStringLiteral("metadata"), module.metadata.rawData()},
+            {QStringLiteral("weight"), module.weight},
+        });
+    }
+
+    const QJsonObject index{
+        {QStringLiteral("version"), INDEX_VERSION},
+        {QStringLiteral("roots"), rootsStamp},
+        {QStringLiteral("modules"), entries},
+    };
+
+    QDir().mkpath(QFileInfo(indexPath()).path());
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(PlasmaSetup) << "Unable to write the module index" << indexPath() << ':' << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(PlasmaSetup) << "Unable to write the module index" << indexPath() << ':' << file.errorString();
+    }
+}
+}
+
+namespace ModuleIndex
+{
+QList<ModuleInfo> modules()
+{
+    const QString rootsStamp = packageRootsStamp();
+    if (auto modules = readIndex(rootsStamp)) {
+        return *modules;
+    }
+
+    qCDebug(PlasmaSetup) << "The module index is missing or outdated, discovering the modules.";
+    const QList<ModuleInfo> modules = scanModules();
+    writeIndex(rootsStamp, modules);
+    return modules;
+}
+}
@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <KPluginMetaData>
+
+#include <QList>
+#include <QMetaType>
+#include <QString>
+
+/**
+ * A module package of Plasma Setup, as found by ModuleIndex.
+ */
+struct ModuleInfo {
+    /** The metadata of the package, including the translations of its name. */
+    KPluginMetaData metadata;
+
+    /** The root directory of the package. */
+    QString path;
+
+    /** The installed main QML file of the module. */
+    QString mainScript;
+
+    /** The position of the module in the wizard, from X-KDE-Weight. */
+    int weight = 0;
+
+    QString pluginId() const
+    {
+        return metadata.pluginId();
+    }
+};
+
+Q_DECLARE_METATYPE(ModuleInfo)
+
+/**
+ * Discovery of the installed module packages.
+ *
+ * Discovering the packages through KPackage walks every data directory and parses each
+ * metadata.json. The result is therefore kept in an index in the persistent cache directory,
+ * see CacheDirectory, so it survives reboots. It is only rebuilt when a package root directory
+ * or one of the indexed metadata files was modified since, so checking it costs a stat per package.
+ */
+namespace ModuleIndex
+{
+/**
+ * Returns the installed modules, ordered by their weight.
+ */
+QList<ModuleInfo> modules();
+}
@@ -3,46 +3,210 @@
 
 #include "pagesmodel.h"
 
+#include "modulecache.h"
+#include "moduleindex.h"
 #include "plasmasetup_debug.h"
+#include "tracer.h"
 
-#include <KPackage/PackageLoader>
 #include <KPluginMetaData>
 
+#include <QFile>
+#include <QLocale>
+#include <QQmlIncubator>
+
+#include <algorithm>
+#include <functional>
+
+#include <unistd.h>
+
 using namespace Qt::StringLiterals;
 
+namespace
+{
+/**
+ * Returns the resident memory of the process in KiB, or 0 if it cannot be read.
+ */
+qint64 residentMemory()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    // The total size of the process, followed by its resident size, both in pages
+    const QList<QByteArray> fields = statm.readLine().split(' ');
+    if (fields.size() < 2) {
+        return 0;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+}
+}
+
+/**
+ * Incubator used to create modules in the background for PagesModel::preparePage().
+ */
+class PageIncubator : public QQmlIncubator
+{
+public:
+    PageIncubator(const QString &qmlPath, std::function<void()> finishedCallback)
+        : QQmlIncubator(QQmlIncubator::Asynchronous)
+        , qmlPath(qmlPath)
+        , traceStart(Tracer::timestamp())
+        , residentMemoryBefore(residentMemory())
+        , m_finishedCallback(std::move(finishedCallback))
+    {
+    }
+
+    /** The QML file the module is created from. */
+    const QString qmlPath;
+
+    /** When creating the module started, for the trace. */
+    const qint64 traceStart;
+
+    /** The resident memory before creating the module, see PagesModel::recordModuleMemory(). */
+    const qint64 residentMemoryBefore;
+
+protected:
+    void statusChanged(Status status) override
+    {
+        if (status == QQmlIncubator::Ready || status == QQmlIncubator::Error) {
+            m_finishedCallback();
+        }
+    }
+
+private:
+    std::function<void()> m_finishedCallback;
+};
+
 PagesModel::PagesModel(QObject *parent)
     : QStandardItemModel(parent)
 {
     QCoreApplication::instance()->installEventFilter(this);
+
+    m_availabilityTimer.setSingleShot(true);
+    connect(&m_availabilityTimer, &QTimer::timeout, this, &PagesModel::availabilityTimedOut);
+}
+
+PagesModel::~PagesModel()
+{
+    for (const auto &incubator : std::as_const(m_incubators)) {
+        incubator->clear();
+    }
 }
 
 void PagesModel::reload()
 {
+    Tracer::Span span(QStringLiteral("PagesModel::reload"), QStringLiteral("modules"));
+
+    setReady(false);
+    m_availabilityTimer.stop();
+    m_pendingAvailability.clear();
+
     clear();
+    releaseModules();
+    if (!m_moduleMemory.isEmpty()) {
+        m_moduleMemory.clear();
+        Q_EMIT moduleMemoryChanged();
+    }
 
-    auto packages = KPackage::PackageLoader::self()->listKPackages(QStringLiteral("KDE/PlasmaSetup"));
+    for (const auto &incubator : std::as_const(m_incubators)) {
+        incubator->clear();
+    }
+    m_incubators.clear();
 
-    std::ranges::sort(packages, [](const KPackage::Package &left, const KPackage::Package &right) {
-        const auto leftData = left.metadata().rawData();
-        const auto rightData = right.metadata().rawData();
-        return leftData["X-KDE-Weight"_L1].toInt() < rightData["X-KDE-Weight"_L1].toInt();
-    });
+    Tracer::Span discoverySpan(QStringLiteral("Discover packages"), QStringLiteral("modules"));
+    const QList<ModuleInfo> modules = ModuleIndex::modules();
+    discoverySpan.end();
 
-    for (const auto &package : std::as_const(packages)) {
+    for (const ModuleInfo &moduleInfo : modules) {
         // Create the module so we can check if it's available
-        const auto qmlPath = package.filePath("ui", QStringLiteral("main.qml"));
+        const auto qmlPath = ModuleCache::mainScript(moduleInfo);
+        Tracer::Span createSpan(QStringLiteral("Create ") + moduleInfo.pluginId(), QStringLiteral("modules"));
+        const qint64 memoryBefore = residentMemory();
         std::unique_ptr<SetupModule> module(createGui(qmlPath));
+        createSpan.end();
 
-        // Only add available modules to the model
-        if (module && module->available()) {
-            const auto plugin = package.metadata();
-            auto item = new QStandardItem(plugin.name());
-            item->setData(plugin.pluginId(), PagesModel::PluginIdRole);
-            item->setData(QVariant::fromValue(package), PagesModel::PackageRole);
+        // Only add available modules to the model, and keep their instance around
+        // for pageItem(). Unavailable modules are released when going out of scope.
+        // Modules that are still working out their availability get a row right away,
+        // which is removed again if they turn out to be unavailable.
+        if (module && (module->available() || module->availabilityPending())) {
+            const QString id = moduleInfo.pluginId();
+            const bool pending = module->availabilityPending();
+
+            auto item = new QStandardItem(translatedName(moduleInfo));
+            item->setData(id, PagesModel::PluginIdRole);
+            item->setData(QVariant::fromValue(moduleInfo), PagesModel::ModuleRole);
+            item->setData(pending, PagesModel::AvailabilityPendingRole);
             appendRow(item);
+
+            if (pending) {
+                SetupModule *pendingModule = module.get();
+                connect(pendingModule, &SetupModule::availabilityPendingChanged, this, [this, id, pendingModule]() {
+                    // Ignore modules left over from a previous reload()
+                    if (!pendingModule->availabilityPending() && m_modules.value(id) == pendingModule) {
+                        settleAvailability(id);
+                    }
+                });
+                m_pendingAvailability.insert(id);
+            }
+
+            m_modules.insert(id, module.release());
+            recordModuleMemory(id, memoryBefore);
+        }
+    }
+
+    if (!m_pendingAvailability.isEmpty()) {
+        qCDebug(PlasmaSetup) << "Waiting for the availability of" << m_pendingAvailability;
+        m_availabilityTimer.start(m_availabilityTimeout);
+        return;
+    }
+
+    finishLoading();
+}
+
+void PagesModel::settleAvailability(const QString &pluginId)
+{
+    if (!m_pendingAvailability.remove(pluginId)) {
+        return;
+    }
+
+    const int row = rowForPluginId(pluginId);
+    SetupModule *module = m_modules.value(pluginId);
+    if (row >= 0) {
+        if (module && module->available()) {
+            item(row, 0)->setData(false, PagesModel::AvailabilityPendingRole);
+        } else {
+            qCDebug(PlasmaSetup) << "Module" << pluginId << "is not available";
+            releasePage(row);
+            removeRow(row);
         }
     }
 
+    if (m_pendingAvailability.isEmpty()) {
+        m_availabilityTimer.stop();
+        finishLoading();
+    }
+}
+
+void PagesModel::availabilityTimedOut()
+{
+    qCWarning(PlasmaSetup) << "Timed out waiting for the availability of" << m_pendingAvailability;
+
+    const auto pending = m_pendingAvailability.values();
+    for (const QString &id : pending) {
+        settleAvailability(id);
+    }
+}
+
+void PagesModel::finishLoading()
+{
+    // The instances created to check the availability are kept, even when lazy loading, releasing
+    // them here would only have them created a second time once the user gets close to them
+    qCDebug(PlasmaSetup) << "Loaded" << rowCount() << "modules," << m_componentCompilations << "component compilations and" << m_moduleCreations
+                         << "module creations so far.";
+
+    setReady(true);
     Q_EMIT loaded();
 }
 
@@ -56,14 +220,188 @@ QHash<int, QByteArray> PagesModel::roleNames() const
     QHash<int, QByteArray> roles = QAbstractItemModel::roleNames();
 
     roles[PluginIdRole] = "pluginId";
+    roles[AvailabilityPendingRole] = "availabilityPending";
     roles[Qt::DisplayRole] = "name";
     return roles;
 }
 
 SetupModule *PagesModel::pageItem(int row)
 {
-    const auto package = data(index(row, 0), PackageRole).value<KPackage::Package>();
-    return createGui(package.filePath("ui", QStringLiteral("main.qml")));
+    const QString id = pluginId(row);
+    if (SetupModule *module = m_modules.value(id)) {
+        return module;
+    }
+
+    // Finish the module being created in the background rather than creating a second instance
+    if (const std::shared_ptr<PageIncubator> incubator = m_incubators.take(id)) {
+        Tracer::Span span(QStringLiteral("Complete ") + id, QStringLiteral("modules"));
+        incubator->forceCompletion();
+        return finishIncubation(id, *incubator);
+    }
+
+    const auto moduleInfo = data(index(row, 0), ModuleRole).value<ModuleInfo>();
+    Tracer::Span span(QStringLiteral("Create ") + id, QStringLiteral("modules"));
+    const qint64 memoryBefore = residentMemory();
+    SetupModule *module = createGui(ModuleCache::mainScript(moduleInfo));
+    if (module) {
+        m_modules.insert(id, module);
+        recordModuleMemory(id, memoryBefore);
+    }
+    return module;
+}
+
+void PagesModel::preparePage(int row)
+{
+    const QString id = pluginId(row);
+    if (id.isEmpty() || m_modules.contains(id) || m_incubators.contains(id)) {
+        return;
+    }
+
+    const auto moduleInfo = data(index(row, 0), ModuleRole).value<ModuleInfo>();
+    const QString qmlPath = ModuleCache::mainScript(moduleInfo);
+    QQmlComponent *component = componentForPath(qmlPath);
+    if (component->status() != QQmlComponent::Ready) {
+        qCritical() << "Error creating component:" << component->errors();
+        return;
+    }
+
+    auto incubator = std::make_shared<PageIncubator>(qmlPath, [this, id]() {
+        // Finish up from the event loop, the incubator must not be destroyed from within its own callback.
+        QMetaObject::invokeMethod(
+            this,
+            [this, id]() {
+                // pageItem() may have finished the incubator in the meantime, and preparePage()
+                // started another one for the same module, which reports on its own
+                const auto it = m_incubators.constFind(id);
+                if (it == m_incubators.cend() || (*it)->isLoading()) {
+                    return;
+                }
+                const std::shared_ptr<PageIncubator> incubator = m_incubators.take(id);
+
+                if (!finishIncubation(id, *incubator)) {
+                    return;
+                }
+
+                const int row = rowForPluginId(id);
+                if (row >= 0) {
+                    Q_EMIT pageReady(row);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+
+    m_incubators.insert(id, incubator);
+    component->create(*incubator);
+}
+
+SetupModule *PagesModel::finishIncubation(const QString &pluginId, PageIncubator &incubator)
+{
+    Tracer::addSpan(QStringLiteral("Incubate ") + pluginId, QStringLiteral("modules"), incubator.traceStart);
+
+    if (incubator.isError()) {
+        qCritical() << "Error creating component:" << incubator.errors();
+        return nullptr;
+    }
+
+    SetupModule *module = adoptModule(incubator.object(), incubator.qmlPath);
+    if (!module) {
+        return nullptr;
+    }
+    m_modules.insert(pluginId, module);
+    recordModuleMemory(pluginId, incubator.residentMemoryBefore);
+    return module;
+}
+
+void PagesModel::releasePage(int row)
+{
+    const QString id = pluginId(row);
+    // Stops creating a module no longer needed
+    m_incubators.remove(id);
+    if (SetupModule *module = m_modules.take(id)) {
+        qCDebug(PlasmaSetup) << "Releasing module" << id << "which took about" << m_moduleMemory.value(id).toLongLong() << "KiB to create";
+        module->deleteLater();
+    }
+}
+
+bool PagesModel::isPageLoaded(int row) const
+{
+    return m_modules.contains(data(index(row, 0), PluginIdRole).toString());
+}
+
+int PagesModel::componentCompilations() const
+{
+    return m_componentCompilations;
+}
+
+int PagesModel::moduleCreations() const
+{
+    return m_moduleCreations;
+}
+
+bool PagesModel::lazyLoading() const
+{
+    return m_lazyLoading;
+}
+
+void PagesModel::setLazyLoading(bool lazyLoading)
+{
+    if (m_lazyLoading == lazyLoading) {
+        return;
+    }
+    m_lazyLoading = lazyLoading;
+    Q_EMIT lazyLoadingChanged();
+}
+
+int PagesModel::availabilityTimeout() const
+{
+    return m_availabilityTimeout;
+}
+
+void PagesModel::setAvailabilityTimeout(int availabilityTimeout)
+{
+    if (m_availabilityTimeout == availabilityTimeout) {
+        return;
+    }
+    m_availabilityTimeout = availabilityTimeout;
+    Q_EMIT availabilityTimeoutChanged();
+}
+
+bool PagesModel::isReady() const
+{
+    return m_ready;
+}
+
+void PagesModel::setReady(bool ready)
+{
+    if (m_ready == ready) {
+        return;
+    }
+    m_ready = ready;
+    Q_EMIT readyChanged();
+}
+
+QVariantMap PagesModel::moduleMemory() const
+{
+    return m_moduleMemory;
+}
+
+void PagesModel::recordModuleMemory(const QString &pluginId, qint64 residentMemoryBefore)
+{
+    // Memory given back to the system in the meantime is not attributed to the module
+    const qint64 growth = std::max<qint64>(0, residentMemory() - residentMemoryBefore);
+    m_moduleMemory.insert(pluginId, growth);
+    qCDebug(PlasmaSetup) << "Creating module" << pluginId << "grew the resident memory by" << growth << "KiB";
+    Q_EMIT moduleMemoryChanged();
+}
+
+int PagesModel::rowForPluginId(const QString &pluginId) const
+{
+    for (int row = 0; row < rowCount(); ++row) {
+        if (data(index(row, 0), PluginIdRole).toString() == pluginId) {
+            return row;
+        }
+    }
+    return -1;
 }
 
 bool PagesModel::eventFilter(QObject *object, QEvent *event)
@@ -81,27 +419,64 @@ void PagesModel::updateTranslations()
     for (int row = 0; row < rowCount(); ++row) {
         auto page = item(row, 0);
         if (page) {
-            const auto package = page->data(PackageRole).value<KPackage::Package>();
-            const KPluginMetaData plugin = package.metadata();
-            page->setText(plugin.name());
+            const QString name = translatedName(page->data(ModuleRole).value<ModuleInfo>());
+            // setText() emits dataChanged() for this row only
+            if (page->text() != name) {
+                page->setText(name);
+            }
         }
     }
+}
+
+QString PagesModel::translatedName(const ModuleInfo &moduleInfo)
+{
+    const KPluginMetaData &plugin = moduleInfo.metadata;
 
-    Q_EMIT dataChanged(index(0, 0), index(rowCount() - 1, 0));
+    QHash<QString, QString> &names = m_translatedNames[QLocale().name()];
+    auto it = names.constFind(plugin.pluginId());
+    if (it == names.cend()) {
+        it = names.insert(plugin.pluginId(), plugin.name());
+    }
+    return *it;
 }
 
-SetupModule *PagesModel::createGui(const QString &qmlPath)
+QQmlComponent *PagesModel::componentForPath(const QString &qmlPath)
 {
+    if (QQmlComponent *component = m_components.value(qmlPath)) {
+        return component;
+    }
+
     QQmlEngine *engine = qmlEngine(this);
-    auto component = new QQmlComponent(engine, QUrl(qmlPath), nullptr);
-    QObject *guiObject = component->create();
+    Tracer::Span span(QStringLiteral("Compile ") + qmlPath, QStringLiteral("modules"));
+    auto component = new QQmlComponent(engine, QUrl(qmlPath), this);
+    span.end();
+    m_components.insert(qmlPath, component);
 
+    ++m_componentCompilations;
+    Q_EMIT componentCompilationsChanged();
+
+    return component;
+}
+
+SetupModule *PagesModel::createGui(const QString &qmlPath)
+{
+    QQmlComponent *component = componentForPath(qmlPath);
     if (component->status() != QQmlComponent::Ready) {
         qCritical() << "Error creating component:" << component->errors();
-        component->deleteLater();
         return nullptr;
     }
 
+    QObject *guiObject = component->create();
+    if (!guiObject) {
+        qCritical() << "Error creating component:" << component->errors();
+        return nullptr;
+    }
+
+    return adoptModule(guiObject, qmlPath);
+}
+
+SetupModule *PagesModel::adoptModule(QObject *guiObject, const QString &qmlPath)
+{
     auto module = qobject_cast<SetupModule *>(guiObject);
 
     if (!module) {
@@ -110,7 +485,19 @@ SetupModule *PagesModel::createGui(const QString &qmlPath)
         return nullptr;
     }
     module->setParent(this);
+
+    ++m_moduleCreations;
+    Q_EMIT moduleCreationsChanged();
+
     return module;
 }
 
+void PagesModel::releaseModules()
+{
+    for (SetupModule *module : std::as_const(m_modules)) {
+        module->deleteLater();
+    }
+    m_modules.clear();
+}
+
 #include "moc_pagesmodel.cpp"
@@ -3,34 +3,150 @@
 
 #pragma once
 
+#include <QHash>
+#include <QQmlComponent>
 #include <QQuickItem>
+#include <QSet>
 #include <QStandardItemModel>
+#include <QTimer>
+#include <QVariantMap>
 
+#include <memory>
+
+#include "moduleindex.h"
 #include "setupmodule.h"
 
+class PageIncubator;
+
 class PagesModel : public QStandardItemModel
 {
     Q_OBJECT
     QML_ELEMENT
+
+    /**
+     * The number of QML components compiled by this model since it was created.
+     *
+     * Each module's main.qml is compiled once and the component is reused for
+     * every instance, so this should match the number of installed modules.
+     */
+    Q_PROPERTY(int componentCompilations READ componentCompilations NOTIFY componentCompilationsChanged)
+
+    /**
+     * The number of module instances created by this model since it was created.
+     *
+     * Each available module is created once by reload() to check its availability, and only
+     * created again after releasePage().
+     */
+    Q_PROPERTY(int moduleCreations READ moduleCreations NOTIFY moduleCreationsChanged)
+
+    /**
+     * Whether pages should only be kept alive while the wizard is close to them.
+     *
+     * When enabled, the instances created by reload() to check availability are kept until the
+     * wizard hands back the pages it no longer needs with releasePage(). Released pages are
+     * requested again with pageItem() or preparePage() when the user navigates back to them.
+     */
+    Q_PROPERTY(bool lazyLoading READ lazyLoading WRITE setLazyLoading NOTIFY lazyLoadingChanged)
+
+    /**
+     * How long reload() waits for modules whose availability is still pending, in milliseconds.
+     *
+     * Once the timeout has passed, the current value of `available` is taken as final for modules
+     * that have not settled yet, so that a single slow module cannot hold up the landing page.
+     */
+    Q_PROPERTY(int availabilityTimeout READ availabilityTimeout WRITE setAvailabilityTimeout NOTIFY availabilityTimeoutChanged)
+
+    /**
+     * Whether reload() has finished and loaded() has been emitted.
+     */
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
+
+    /**
+     * How much the resident memory of the process grew while creating each module, in KiB, keyed by plugin id.
+     *
+     * Meant for debugging the memory footprint of the modules. The values are approximate, they
+     * include what the module loaded for the first time, such as its util plugin, as well as what
+     * anything else allocated in the meantime while a module was created in the background.
+     * A module created again after releasePage() replaces its previous value.
+     */
+    Q_PROPERTY(QVariantMap moduleMemory READ moduleMemory NOTIFY moduleMemoryChanged)
+
 public:
     enum AdditionalRoles {
         PluginIdRole = Qt::UserRole + 1,
-        PackageRole,
+        ModuleRole,
+        AvailabilityPendingRole,
     };
     Q_ENUM(AdditionalRoles)
 
     PagesModel(QObject *parent = nullptr);
-    ~PagesModel() = default;
+    ~PagesModel() override;
 
     Q_INVOKABLE void reload();
     Q_INVOKABLE QString pluginId(int row);
 
     QHash<int, QByteArray> roleNames() const override;
 
+    /**
+     * Returns the module instance for the given row.
+     *
+     * The instance created while checking the module's availability in reload()
+     * is handed out here, so a module is only instantiated again if it has not been
+     * created yet. A module still being created by preparePage() is finished right away.
+     */
     Q_INVOKABLE SetupModule *pageItem(int row);
 
+    /**
+     * Starts creating the module for the given row in the background.
+     *
+     * The instance is created asynchronously and pageReady() is emitted once it is
+     * available from pageItem(). Does nothing if the module already exists or is being
+     * created. pageReady() is not emitted if pageItem() is called before the instance is done.
+     */
+    Q_INVOKABLE void preparePage(int row);
+
+    /**
+     * Destroys the module instance for the given row, or stops creating it.
+     *
+     * The compiled component is kept, so the module can be recreated cheaply with
+     * pageItem() or preparePage() later on.
+     */
+    Q_INVOKABLE void releasePage(int row);
+
+    /**
+     * Returns whether an instance of the module for the given row currently exists.
+     */
+    Q_INVOKABLE bool isPageLoaded(int row) const;
+
+    int componentCompilations() const;
+    int moduleCreations() const;
+
+    bool lazyLoading() const;
+    void setLazyLoading(bool lazyLoading);
+
+    int availabilityTimeout() const;
+    void setAvailabilityTimeout(int availabilityTimeout);
+
+    bool isReady() const;
+
+    QVariantMap moduleMemory() const;
+
 Q_SIGNALS:
+    /**
+     * Emitted once reload() is done and every module has decided whether it is available.
+     */
     void loaded();
+    void componentCompilationsChanged();
+    void moduleCreationsChanged();
+    void lazyLoadingChanged();
+    void availabilityTimeoutChanged();
+    void readyChanged();
+    void moduleMemoryChanged();
+
+    /**
+     * Emitted when a module requested with preparePage() has been created.
+     */
+    void pageReady(int row);
 
 private:
     /**
@@ -47,8 +163,101 @@ private:
      * Updates translations for all items in the model when the language changes.
      *
      * This way we avoid reloading the entire model when only the translations need to be updated.
+     * Only the rows whose name actually changed emit dataChanged().
      */
     void updateTranslations();
 
+    /**
+     * Returns the name of the given module in the current language.
+     *
+     * Names are cached per language, so switching back to a language does not parse the metadata again.
+     */
+    QString translatedName(const ModuleInfo &moduleInfo);
+
+    /**
+     * Returns the compiled component for the given QML file, compiling it on first use.
+     */
+    QQmlComponent *componentForPath(const QString &qmlPath);
+
     SetupModule *createGui(const QString &qmlPath);
+
+    /**
+     * Takes ownership of a freshly created module object, or returns nullptr if it is not a SetupModule.
+     */
+    SetupModule *adoptModule(QObject *guiObject, const QString &qmlPath);
+
+    /**
+     * Takes the module created by the given incubator, which must be done, or returns nullptr if that failed.
+     */
+    SetupModule *finishIncubation(const QString &pluginId, PageIncubator &incubator);
+
+    /**
+     * Returns the row of the given plugin id, or -1 if it is not in the model.
+     */
+    int rowForPluginId(const QString &pluginId) const;
+
+    /**
+     * Deletes all cached module instances.
+     */
+    void releaseModules();
+
+    /**
+     * Called once the module with the given plugin id has decided whether it is available.
+     *
+     * Removes its row again if it turned out to be unavailable, and finishes loading
+     * when it was the last pending module.
+     */
+    void settleAvailability(const QString &pluginId);
+
+    /**
+     * Settles all modules that are still pending once the availability timeout has passed.
+     */
+    void availabilityTimedOut();
+
+    /**
+     * Marks the model as ready and emits loaded().
+     */
+    void finishLoading();
+
+    void setReady(bool ready);
+
+    /**
+     * Records the growth of the resident memory since the given value of residentMemory() for the given module.
+     */
+    void recordModuleMemory(const QString &pluginId, qint64 residentMemoryBefore);
+
+    /**
+     * Compiled components, keyed by the path of their QML file.
+     */
+    QHash<QString, QQmlComponent *> m_components;
+
+    /**
+     * Module instances for the rows of the model, keyed by plugin id.
+     */
+    QHash<QString, SetupModule *> m_modules;
+
+    /**
+     * Modules being created in the background, keyed by plugin id.
+     */
+    QHash<QString, std::shared_ptr<PageIncubator>> m_incubators;
+
+    /**
+     * Translated module names, keyed by language and then by plugin id.
+     */
+    QHash<QString, QHash<QString, QString>> m_translatedNames;
+
+    /**
+     * Plugin ids of the modules whose availability is still pending.
+     */
+    QSet<QString> m_pendingAvailability;
+
+    QVariantMap m_moduleMemory;
+
+    QTimer m_availabilityTimer;
+
+    int m_componentCompilations = 0;
+    int m_moduleCreations = 0;
+    int m_availabilityTimeout = 5000;
+    bool m_lazyLoading = false;
+    bool m_ready = false;
 };
@@ -17,6 +17,11 @@ Item {
     readonly property real scaleLanding: 1.2
     readonly property real scaleSteps: 1
 
+    /**
+     * Whether the wizard is ready to start, the setup can only be started once it is.
+     */
+    property bool ready: true
+
     signal requestNextPage()
 
     function returnToLanding() {
@@ -137,6 +142,7 @@ Item {
                 Layout.alignment: Qt.AlignHCenter
 
                 opacity: root.contentOpacity
+                enabled: root.ready
                 text: i18n("Begin Setup")
                 icon.name: "plasma-symbolic"
 
@@ -73,7 +73,9 @@ Kirigami.Page {
     }
 
     function finishFinalPage(): void {
-        // Finalize the initial setup process and exit the wizard.
+        deactivatePage(stepsRepeater.itemAt(currentIndex));
+
+        // Finalize the initial setup process, the wizard exits once all steps succeeded.
         InitialStartUtil.finish();
     }
 
@@ -83,6 +85,12 @@ Kirigami.Page {
         }
     }
 
+    function deactivatePage(item): void {
+        if (item && item.module && typeof item.module.onPageDeactivated === "function") {
+            item.module.onPageDeactivated();
+        }
+    }
+
     function requestNextPage(): void {
         if (previousStepAnim.running || currentStepAnim.running || nextStepAnim.running) {
             return;
@@ -90,6 +98,13 @@ Kirigami.Page {
 
         previousStepItemX = 0;
 
+        // Notify the current page/module it is being left, so that it can
+        // write the settings chosen on it.
+        deactivatePage(stepsRepeater.itemAt(currentIndex));
+
+        // The choices made so far are final, check what finishing depends on meanwhile.
+        InitialStartUtil.prepareFinish();
+
         // Notify the next page/module it is being activated.
         //
         // Requires the module to implement an `onPageActivated` function.
@@ -117,6 +132,9 @@ Kirigami.Page {
             return;
         }
 
+        deactivatePage(stepsRepeater.itemAt(currentIndex));
+        InitialStartUtil.prepareFinish();
+
         if (currentIndex === 0) {
             root.showingLanding = true;
             landingComponent.returnToLanding();
@@ -147,6 +165,9 @@ Kirigami.Page {
          */
         visible: !Kirigami.Settings.isMobile || root.showingLanding
 
+        // Wait until every module has decided whether it is available
+        ready: pagesModel.ready && root.currentIndex >= 0
+
         onRequestNextPage: {
             root.showingLanding = false;
             stepHeading.changeText(root.currentStepItem.name);
@@ -158,6 +179,9 @@ Kirigami.Page {
     PagesModel {
         id: pagesModel
 
+        // Only keep the pages around the current one alive, see PageDelegate.updateLoadedState()
+        lazyLoading: true
+
         Component.onCompleted: reload()
 
         onLoaded: root.currentIndex = 0
@@ -330,7 +354,7 @@ Kirigami.Page {
                         text: i18nc("@action:button", "Finish")
                         icon.name: "dialog-ok-symbolic"
 
-                        enabled: root.currentModule.nextEnabled
+                        enabled: root.currentModule.nextEnabled && !InitialStartUtil.finishing
 
                         onClicked: {
                             // Ensure the `Finish` button can only be click once.
@@ -356,7 +380,7 @@ Kirigami.Page {
         property PlasmaSetupComponents.SetupModule module: null
 
         Component.onCompleted: {
-            module = pagesModel.pageItem(index);
+            updateLoadedState();
             updateRootItems();
         }
 
@@ -394,6 +418,31 @@ Kirigami.Page {
         width: parent.width
         height: parent.height
 
+        /*!
+        * Creates or releases the module of this page depending on its distance to the current page.
+        *
+        * The current page and its direct neighbours are always live, since they take part
+        * in the step animation. The page after the next one is created in the background, and
+        * taken once pagesModel reports it ready, so it is laid out by the time the user gets to it. Pages far behind the current one are
+        * released if their module allows it, and recreated when navigating back.
+        */
+        function updateLoadedState(): void {
+            if (!pagesModel.lazyLoading || Math.abs(index - root.currentIndex) <= 1) {
+                if (!module) {
+                    module = pagesModel.pageItem(index);
+                }
+            } else if (index === root.currentIndex + 2) {
+                pagesModel.preparePage(index);
+            } else if (index < root.currentIndex - 1 && module && module.unloadable) {
+                // Lets the module drop what its backend only holds for the page
+                if (typeof module.onPageReleased === "function") {
+                    module.onPageReleased();
+                }
+                module = null;
+                pagesModel.releasePage(index);
+            }
+        }
+
         function updateRootItems(): void {
             if (index === root.currentIndex) {
                 root.currentStepItem = item;
@@ -410,8 +459,20 @@ Kirigami.Page {
             target: root
 
             function onCurrentIndexChanged(): void {
+                item.updateLoadedState();
                 item.updateRootItems();
             }
         }
+
+        // Takes the page created in the background right away, so it is laid out before the user gets to it
+        Connections {
+            target: pagesModel
+
+            function onPageReady(row: int): void {
+                if (row === item.index && !item.module) {
+                    item.module = pagesModel.pageItem(row);
+                }
+            }
+        }
     }
 }
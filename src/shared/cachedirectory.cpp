@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "cachedirectory.h"
+
+#include "config-plasma-setup.h"
+
+#include <QStandardPaths>
+
+#include <unistd.h>
+
+namespace CacheDirectory
+{
+QString path()
+{
+    if (!QStandardPaths::isTestModeEnabled() && access(PLASMA_SETUP_CACHE_DIR, W_OK | X_OK) == 0) {
+        return QStringLiteral(PLASMA_SETUP_CACHE_DIR);
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+}
+}
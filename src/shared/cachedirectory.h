@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QString>
+
+/**
+ * The directory for the caches meant to speed up the next start of Plasma Setup.
+ *
+ * The home of the plasma-setup user is a tmpfs, so its CacheLocation is empty on every boot.
+ * These caches are kept in a directory under /var/cache instead, created by the tmpfiles.d
+ * configuration, see files/plasma-setup-tmpfiles.conf.in.
+ */
+namespace CacheDirectory
+{
+/**
+ * Returns the persistent cache directory.
+ *
+ * Falls back to CacheLocation when the persistent directory is not writable, e.g. when running
+ * from the build directory as another user, and in the test mode of QStandardPaths.
+ */
+QString path();
+}
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "displaymanager.h"
+
+#include <array>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+namespace
+{
+/**
+ * The alias systemd creates when a display manager is enabled, pointing at its unit.
+ */
+const std::filesystem::path DISPLAY_MANAGER_ALIAS_PATH = "/etc/systemd/system/display-manager.service";
+
+/**
+ * The supported display managers, SDDM first as it is the fallback.
+ */
+constexpr std::array<DisplayManager, 3> DISPLAY_MANAGERS = {{
+    {
+        .name = "sddm",
+        .unit = "sddm.service",
+        .autologinConfigPath = "/etc/sddm.conf.d/99-plasma-setup.conf",
+        .autologinGroup = "[Autologin]",
+        .userKey = "User",
+        .sessionKey = "Session",
+        .reloginKey = "Relogin",
+    },
+    {
+        .name = "plasmalogin",
+        .unit = "plasmalogin.service",
+        .autologinConfigPath = "/etc/plasmalogin.conf.d/99-plasma-setup.conf",
+        .autologinGroup = "[Autologin]",
+        .userKey = "User",
+        .sessionKey = "Session",
+        .reloginKey = "Relogin",
+    },
+    {
+        .name = "lightdm",
+        .unit = "lightdm.service",
+        .autologinConfigPath = "/etc/lightdm/lightdm.conf.d/99-plasma-setup.conf",
+        .autologinGroup = "[Seat:*]",
+        .userKey = "autologin-user",
+        .sessionKey = "autologin-session",
+        .reloginKey = {},
+    },
+}};
+
+const DisplayManager &detect()
+{
+    std::error_code error;
+    const std::filesystem::path target = std::filesystem::read_symlink(DISPLAY_MANAGER_ALIAS_PATH, error);
+    if (!error) {
+        for (const DisplayManager &displayManager : DISPLAY_MANAGERS) {
+            if (target.filename() == displayManager.unit) {
+                return displayManager;
+            }
+        }
+        std::cerr << "Unsupported display manager " << target << ", falling back to " << DISPLAY_MANAGERS.front().name << '\n';
+    }
+    return DISPLAY_MANAGERS.front();
+}
+}
+
+std::string DisplayManager::autologinConfig(std::string_view user, std::string_view session, bool relogin) const
+{
+    std::string config;
+    config.append(autologinGroup).append("\n");
+    config.append(userKey).append("=").append(user).append("\n");
+    config.append(sessionKey).append("=").append(session).append("\n");
+    if (relogin && !reloginKey.empty()) {
+        config.append(reloginKey).append("=true\n");
+    }
+    return config;
+}
+
+std::span<const DisplayManager> DisplayManager::known()
+{
+    return DISPLAY_MANAGERS;
+}
+
+const DisplayManager *DisplayManager::fromName(std::string_view name)
+{
+    for (const DisplayManager &displayManager : DISPLAY_MANAGERS) {
+        if (displayManager.name == name) {
+            return &displayManager;
+        }
+    }
+    return nullptr;
+}
+
+const DisplayManager &DisplayManager::active()
+{
+    static const DisplayManager &displayManager = detect();
+    return displayManager;
+}
+
+const DisplayManager &DisplayManager::fromHint(std::string_view name)
+{
+    const DisplayManager &activeDisplayManager = active();
+    if (!name.empty() && name != activeDisplayManager.name) {
+        std::cerr << "Ignoring display manager " << name << ", " << activeDisplayManager.name << " is active\n";
+    }
+    return activeDisplayManager;
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * A display manager Plasma Setup knows how to configure autologin for.
+ *
+ * Used by the boot utility, which runs before the display manager and therefore only uses
+ * the standard library, as well as by the application and the auth helper.
+ *
+ * The active display manager is read from the display-manager.service alias, which systemd
+ * points at the unit of the enabled display manager. This takes a single readlink, done once
+ * per process, instead of a D-Bus round trip to systemd for every action.
+ */
+struct DisplayManager {
+    /** The name used in the helper arguments, e.g. "sddm". */
+    std::string_view name;
+
+    /** The systemd unit of the display manager, e.g. "sddm.service". */
+    std::string_view unit;
+
+    /** The drop-in file written by Plasma Setup to enable autologin. */
+    std::string_view autologinConfigPath;
+
+    /** The group holding the autologin keys, including the brackets. */
+    std::string_view autologinGroup;
+
+    /** The keys for the user and the session to log into. */
+    std::string_view userKey;
+    std::string_view sessionKey;
+
+    /** The key logging back in when the session ends, empty if not supported. */
+    std::string_view reloginKey;
+
+    /**
+     * Returns the contents of the autologin drop-in.
+     *
+     * @param user The user to log in.
+     * @param session The session to start, e.g. "plasma".
+     * @param relogin Whether to log in again when the session ends, ignored if not supported.
+     */
+    std::string autologinConfig(std::string_view user, std::string_view session, bool relogin) const;
+
+    /**
+     * The display managers Plasma Setup supports.
+     */
+    static std::span<const DisplayManager> known();
+
+    /**
+     * Returns the known display manager with the given name, or nullptr.
+     */
+    static const DisplayManager *fromName(std::string_view name);
+
+    /**
+     * Returns the active display manager, detecting it on first use.
+     *
+     * Falls back to SDDM if no display manager is enabled or it is not a known one.
+     */
+    static const DisplayManager &active();
+
+    /**
+     * Returns the display manager named by a caller, if it is the active one.
+     *
+     * The application passes along the display manager it detected, see
+     * SystemConfig::helperArguments(). As only known display managers are accepted and the
+     * hint is compared against the cached detection, a caller cannot make the helper write
+     * anywhere else. Falls back to active() if the hint is empty or does not match.
+     */
+    static const DisplayManager &fromHint(std::string_view name);
+};
@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "systemconfig.h"
+
+#include "config-plasma-setup.h"
+#include "displaymanager.h"
+#include "plasmasetup_shared_debug.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QFile>
+
+#include <array>
+#include <cstring>
+#include <optional>
+
+/**
+ * The names of the user backends, as used in plasmasetuprc and the helper arguments.
+ */
+static constexpr std::array<std::pair<SystemConfig::UserBackend, QLatin1StringView>, 3> USER_BACKEND_NAMES = {{
+    {SystemConfig::UserBackend::Automatic, QLatin1StringView("auto")},
+    {SystemConfig::UserBackend::AccountsService, QLatin1StringView("accountsservice")},
+    {SystemConfig::UserBackend::Subprocess, QLatin1StringView("useradd")},
+}};
+
+static QString userBackendName(SystemConfig::UserBackend backend)
+{
+    for (const auto &[value, name] : USER_BACKEND_NAMES) {
+        if (value == backend) {
+            return name;
+        }
+    }
+    return QString();
+}
+
+static std::optional<SystemConfig::UserBackend> userBackendFromName(QStringView name)
+{
+    for (const auto &[value, backendName] : USER_BACKEND_NAMES) {
+        if (name.compare(backendName, Qt::CaseInsensitive) == 0) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * Returns whether the given character separates tokens in login.defs.
+ */
+static constexpr bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * Parses the value of a UID key, keeping the current value if it is invalid.
+ */
+static void parseUidValue(QByteArrayView key, QByteArrayView value, int &target, const QString &source)
+{
+    bool ok = false;
+    const int parsedValue = value.toInt(&ok);
+    if (ok && parsedValue >= 0) {
+        target = parsedValue;
+    } else {
+        qCWarning(PlasmaSetupShared) << "Invalid" << key << "value in" << source << ':' << value;
+    }
+}
+
+LoginDefs parseLoginDefs(QByteArrayView data, const QString &source)
+{
+    LoginDefs loginDefs;
+
+    const char *position = data.data();
+    const char *const end = position + data.size();
+
+    while (position < end) {
+        const char *lineEnd = static_cast<const char *>(memchr(position, '\n', end - position));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+
+        // Skip the indentation, then comments and empty lines
+        while (position < lineEnd && isBlank(*position)) {
+            ++position;
+        }
+
+        if (position < lineEnd && *position != '#') {
+            const char *keyEnd = position;
+            while (keyEnd < lineEnd && !isBlank(*keyEnd)) {
+                ++keyEnd;
+            }
+            const QByteArrayView key(position, keyEnd - position);
+
+            // Only the keys we care about get their value tokenized
+            if (key == "UID_MIN" || key == "UID_MAX") {
+                const char *valueStart = keyEnd;
+                while (valueStart < lineEnd && isBlank(*valueStart)) {
+                    ++valueStart;
+                }
+                const char *valueEnd = valueStart;
+                while (valueEnd < lineEnd && !isBlank(*valueEnd)) {
+                    ++valueEnd;
+                }
+
+                if (valueStart < valueEnd) {
+                    const QByteArrayView value(valueStart, valueEnd - valueStart);
+                    parseUidValue(key, value, key == "UID_MIN" ? loginDefs.uidMin : loginDefs.uidMax, source);
+                }
+            }
+        }
+
+        position = lineEnd + 1;
+    }
+
+    return loginDefs;
+}
+
+const SystemConfig &SystemConfig::instance()
+{
+    static const SystemConfig config = load(QStringLiteral(LOGIN_DEFS_PATH), QString::fromUtf8(PLASMA_SETUP_CONFIG_PATH));
+    return config;
+}
+
+SystemConfig SystemConfig::load(const QString &loginDefsPath, const QString &configPath)
+{
+    SystemConfig systemConfig;
+
+    QFile loginDefs(loginDefsPath);
+    if (loginDefs.open(QIODevice::ReadOnly)) {
+        // login.defs is small enough to be mapped or read in one go
+        const uchar *mapped = loginDefs.map(0, loginDefs.size());
+        if (mapped) {
+            systemConfig.m_loginDefs = parseLoginDefs(QByteArrayView(mapped, loginDefs.size()), loginDefs.fileName());
+            loginDefs.unmap(const_cast<uchar *>(mapped));
+        } else {
+            systemConfig.m_loginDefs = parseLoginDefs(loginDefs.readAll(), loginDefs.fileName());
+        }
+    } else {
+        qCWarning(PlasmaSetupShared) << "Unable to open" << loginDefs.fileName() << ':' << loginDefs.errorString();
+    }
+
+    if (!configPath.isEmpty()) {
+        KConfig config(configPath, KConfig::SimpleConfig);
+
+        const KConfigGroup accountsGroup(&config, QStringLiteral("Accounts"));
+        const QString configuredGroups = accountsGroup.readEntry(QStringLiteral("UserGroups"), QString());
+        const auto groupNames = configuredGroups.split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (const QString &groupName : groupNames) {
+            const QString trimmedGroupName = groupName.trimmed();
+            if (!trimmedGroupName.isEmpty()) {
+                systemConfig.m_userGroups << trimmedGroupName;
+            }
+        }
+        systemConfig.m_queryRemoteUsers = accountsGroup.readEntry(QStringLiteral("QueryRemoteUsers"), false);
+
+        const QString userBackend = accountsGroup.readEntry(QStringLiteral("UserBackend"), QString()).trimmed();
+        if (!userBackend.isEmpty()) {
+            if (const auto backend = userBackendFromName(userBackend)) {
+                systemConfig.m_userBackend = *backend;
+            } else {
+                qCWarning(PlasmaSetupShared) << "Unknown UserBackend in" << configPath << ':' << userBackend;
+            }
+        }
+
+        const KConfigGroup newUserHomeGroup(&config, QStringLiteral("NewUserHome"));
+        systemConfig.m_newUserHomePaths = newUserHomeGroup.readEntry(QStringLiteral("Paths"), QStringList());
+    }
+
+    if (systemConfig.m_userGroups.isEmpty()) {
+        systemConfig.m_userGroups << QStringLiteral("wheel");
+    }
+
+    return systemConfig;
+}
+
+std::pair<int, int> SystemConfig::uidRange() const
+{
+    return {m_loginDefs.uidMin, m_loginDefs.uidMax};
+}
+
+QStringList SystemConfig::userGroups() const
+{
+    return m_userGroups;
+}
+
+bool SystemConfig::queryRemoteUsers() const
+{
+    return m_queryRemoteUsers;
+}
+
+QStringList SystemConfig::newUserHomePaths() const
+{
+    return m_newUserHomePaths;
+}
+
+SystemConfig::UserBackend SystemConfig::userBackend() const
+{
+    return m_userBackend;
+}
+
+const DisplayManager &SystemConfig::displayManager() const
+{
+    return m_displayManager ? *m_displayManager : DisplayManager::active();
+}
+
+QVariantMap SystemConfig::helperArguments() const
+{
+    return {
+        {QStringLiteral("uidMin"), m_loginDefs.uidMin},
+        {QStringLiteral("uidMax"), m_loginDefs.uidMax},
+        {QStringLiteral("newUserHomePaths"), m_newUserHomePaths},
+        {QStringLiteral("userBackend"), userBackendName(m_userBackend)},
+        {QStringLiteral("displayManager"), QString::fromUtf8(displayManager().name)},
+    };
+}
+
+SystemConfig SystemConfig::fromHelperArguments(const QVariantMap &args)
+{
+    // The caller is not trusted, the helper relies on the configuration it reads itself
+    SystemConfig systemConfig = instance();
+
+    const QVariantMap ownArguments = systemConfig.helperArguments();
+    for (const QString &key : {QStringLiteral("uidMin"), QStringLiteral("uidMax"), QStringLiteral("newUserHomePaths"), QStringLiteral("userBackend")}) {
+        if (args.contains(key) && args.value(key) != ownArguments.value(key)) {
+            qCWarning(PlasmaSetupShared) << "Ignoring the" << key << "passed by the caller:" << args.value(key) << "the configuration has"
+                                         << ownArguments.value(key);
+        }
+    }
+
+    // Verified against the display managers actually installed
+    systemConfig.m_displayManager = &DisplayManager::fromHint(args.value(QStringLiteral("displayManager")).toString().toStdString());
+
+    return systemConfig;
+}
@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <utility>
+
+struct DisplayManager;
+
+/**
+ * @brief Default minimum UID for regular user accounts
+ *
+ * This value is used as a fallback when LOGIN_DEFS_PATH cannot be read
+ * or does not contain a valid UID_MIN setting. UIDs below this threshold
+ * are typically reserved for system accounts.
+ */
+constexpr int DEFAULT_MIN_REGULAR_USER_ID = 1000;
+/**
+ * @brief Default maximum UID for regular user accounts
+ *
+ * This value is used as a fallback when LOGIN_DEFS_PATH cannot be read
+ * or does not contain a valid UID_MAX setting. UIDs above this threshold
+ * are typically reserved for dynamic accounts.
+ */
+constexpr int DEFAULT_MAX_REGULAR_USER_ID = 65000;
+
+/**
+ * The values of login.defs used by Plasma Setup.
+ */
+struct LoginDefs {
+    /** The lowest UID of regular users, from UID_MIN. */
+    int uidMin = DEFAULT_MIN_REGULAR_USER_ID;
+
+    /** The highest UID of regular users, from UID_MAX. */
+    int uidMax = DEFAULT_MAX_REGULAR_USER_ID;
+};
+
+/**
+ * Parses the contents of a login.defs file.
+ *
+ * Only the keys needed by Plasma Setup are looked at, everything else is skipped without
+ * being tokenized. Keys that are missing or whose value is invalid keep their default.
+ *
+ * @param data The contents of the file.
+ * @param source The name of the file, used in warnings.
+ */
+LoginDefs parseLoginDefs(QByteArrayView data, const QString &source = QString());
+
+/**
+ * A snapshot of the system configuration relevant to Plasma Setup.
+ *
+ * Combines login.defs and plasmasetuprc, which are read once when the snapshot is first
+ * used. Shared by the application and the auth helper, which reads its own snapshot rather
+ * than trusting the one of the application, see fromHelperArguments().
+ */
+class SystemConfig
+{
+public:
+    /**
+     * How the auth helper creates user accounts.
+     */
+    enum class UserBackend {
+        /** Use AccountsService if it is available, the shadow utilities otherwise. */
+        Automatic,
+        /** Create the account through the org.freedesktop.Accounts D-Bus service. */
+        AccountsService,
+        /** Run useradd and chpasswd, the default. */
+        Subprocess,
+    };
+
+    /**
+     * Returns the snapshot of the system configuration, loading it on first use.
+     */
+    static const SystemConfig &instance();
+
+    /**
+     * Loads the configuration from the given files.
+     *
+     * @param loginDefsPath The path to login.defs.
+     * @param configPath The path to plasmasetuprc, may be empty.
+     */
+    static SystemConfig load(const QString &loginDefsPath, const QString &configPath);
+
+    /**
+     * The range of UIDs of regular users, inclusive.
+     */
+    std::pair<int, int> uidRange() const;
+
+    /**
+     * The groups newly created users should join, from the `UserGroups` key of `[Accounts]`.
+     *
+     * Falls back to `wheel`, which most distributions use for admin/sudo access.
+     */
+    QStringList userGroups() const;
+
+    /**
+     * Whether to look for existing users in remote user databases, from the `QueryRemoteUsers` key of `[Accounts]`.
+     */
+    bool queryRemoteUsers() const;
+
+    /**
+     * The paths copied to the home directory of the new user, from the `Paths` key of `[NewUserHome]`.
+     *
+     * Empty if not configured.
+     */
+    QStringList newUserHomePaths() const;
+
+    /**
+     * How to create the new user, from the `UserBackend` key of `[Accounts]`.
+     *
+     * Defaults to UserBackend::Subprocess, the other backends have to be chosen explicitly.
+     */
+    UserBackend userBackend() const;
+
+    /**
+     * The display manager whose autologin is configured.
+     *
+     * In the auth helper, this is the one passed by the application once verified, see DisplayManager::fromHint().
+     */
+    const DisplayManager &displayManager() const;
+
+    /**
+     * The arguments passed along with the auth helper actions.
+     *
+     * Contains "uidMin", "uidMax", "newUserHomePaths", "userBackend" and "displayManager". The helper
+     * reads the configuration itself, these are only hints, see fromHelperArguments().
+     */
+    QVariantMap helperArguments() const;
+
+    /**
+     * Returns the snapshot of the configuration for an auth helper action, see helperArguments().
+     *
+     * This is instance(), read by the helper itself, since the caller must not be able to change
+     * the range of regular UIDs, the files copied to the new user or how the user is created.
+     * Values of the arguments differing from it are ignored with a warning. The display manager
+     * passed by the caller is only used once verified, see DisplayManager::fromHint().
+     */
+    static SystemConfig fromHelperArguments(const QVariantMap &args);
+
+private:
+    LoginDefs m_loginDefs;
+    QStringList m_userGroups;
+    bool m_queryRemoteUsers = false;
+    QStringList m_newUserHomePaths;
+    UserBackend m_userBackend = UserBackend::Subprocess;
+    const DisplayManager *m_displayManager = nullptr;
+};
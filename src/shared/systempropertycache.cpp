@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "systempropertycache.h"
+
+#include "plasmasetup_shared_debug.h"
+#include "tracer.h"
+
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+namespace
+{
+const QString PROPERTIES_INTERFACE = QStringLiteral("org.freedesktop.DBus.Properties");
+}
+
+SystemPropertyCache::SystemPropertyCache(const QString &service,
+                                         const QString &path,
+                                         const QString &interface,
+                                         const QDBusConnection &connection,
+                                         QObject *parent)
+    : QObject(parent)
+    , m_service(service)
+    , m_path(path)
+    , m_interface(interface)
+    , m_connection(connection)
+{
+    // Subscribe first, so that no change is missed while GetAll is running
+    m_connection.connect(m_service,
+                         m_path,
+                         PROPERTIES_INTERFACE,
+                         QStringLiteral("PropertiesChanged"),
+                         this,
+                         SLOT(onPropertiesChanged(QString, QVariantMap, QStringList)));
+
+    fetchAll();
+}
+
+QString SystemPropertyCache::service() const
+{
+    return m_service;
+}
+
+QString SystemPropertyCache::path() const
+{
+    return m_path;
+}
+
+QString SystemPropertyCache::interface() const
+{
+    return m_interface;
+}
+
+bool SystemPropertyCache::isLoaded() const
+{
+    return m_loaded;
+}
+
+QVariant SystemPropertyCache::value(const QString &name) const
+{
+    return m_values.value(name);
+}
+
+void SystemPropertyCache::onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties)
+{
+    if (interface != m_interface) {
+        return;
+    }
+
+    const QStringList changed = store(changedProperties);
+    if (m_loaded && !changed.isEmpty()) {
+        Q_EMIT propertiesChanged(changed);
+    }
+
+    // Services only announcing that a property changed need it to be read again
+    if (!invalidatedProperties.isEmpty()) {
+        fetchAll();
+    }
+}
+
+void SystemPropertyCache::fetchAll()
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(m_service, m_path, PROPERTIES_INTERFACE, QStringLiteral("GetAll"));
+    message << m_interface;
+
+    const qint64 traceStart = Tracer::timestamp();
+    auto watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, traceStart](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        Tracer::addSpan(QStringLiteral("GetAll ") + m_interface, QStringLiteral("dbus"), traceStart);
+
+        const QDBusPendingReply<QVariantMap> reply = *watcher;
+        QStringList changed;
+        if (reply.isError()) {
+            qCWarning(PlasmaSetupShared) << "Failed to read the properties of" << m_service << ':' << reply.error().message();
+        } else {
+            changed = store(reply.value());
+        }
+
+        if (!m_loaded) {
+            m_loaded = true;
+            Q_EMIT loaded();
+        } else if (!changed.isEmpty()) {
+            Q_EMIT propertiesChanged(changed);
+        }
+    });
+}
+
+QStringList SystemPropertyCache::store(const QVariantMap &values)
+{
+    QStringList changed;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        auto current = m_values.find(it.key());
+        if (current == m_values.end()) {
+            m_values.insert(it.key(), it.value());
+        } else if (*current != it.value()) {
+            *current = it.value();
+        } else {
+            continue;
+        }
+        changed.append(it.key());
+    }
+    return changed;
+}
+
+#include "moc_systempropertycache.cpp"
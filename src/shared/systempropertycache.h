@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * Keeps a copy of the properties of a D-Bus object, e.g. those of org.freedesktop.locale1.
+ *
+ * All properties are fetched with a single asynchronous GetAll call on construction, and
+ * the copy is updated from the PropertiesChanged signal afterwards. Reading a property is
+ * then free, and never blocks on the bus.
+ *
+ * Values are only available once loaded() has been emitted.
+ */
+class SystemPropertyCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates the cache and starts fetching the properties.
+     *
+     * @param service The service owning the object, e.g. "org.freedesktop.locale1".
+     * @param path The path of the object, e.g. "/org/freedesktop/locale1".
+     * @param interface The interface the properties belong to, e.g. "org.freedesktop.locale1".
+     */
+    explicit SystemPropertyCache(const QString &service,
+                                 const QString &path,
+                                 const QString &interface,
+                                 const QDBusConnection &connection,
+                                 QObject *parent = nullptr);
+
+    QString service() const;
+    QString path() const;
+    QString interface() const;
+
+    /**
+     * Whether the properties have been fetched.
+     *
+     * This is also true if fetching failed, in which case every value is invalid.
+     */
+    bool isLoaded() const;
+
+    /**
+     * The cached value of a property, or an invalid QVariant if it is unknown.
+     */
+    QVariant value(const QString &name) const;
+
+Q_SIGNALS:
+    /**
+     * Emitted once the initial GetAll call finished.
+     */
+    void loaded();
+
+    /**
+     * Emitted when properties changed after the cache was loaded.
+     *
+     * @param names The names of the properties whose value changed.
+     */
+    void propertiesChanged(const QStringList &names);
+
+private Q_SLOTS:
+    void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
+
+private:
+    /**
+     * Fetches all properties, replacing the cached ones.
+     */
+    void fetchAll();
+
+    /**
+     * Stores the given values, and returns the names of the properties whose value changed.
+     */
+    QStringList store(const QVariantMap &values);
+
+    const QString m_service;
+    const QString m_path;
+    const QString m_interface;
+    QDBusConnection m_connection;
+
+    QVariantMap m_values;
+    bool m_loaded = false;
+};
@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "systemsettingscommitter.h"
+
+#include "plasmasetup_shared_debug.h"
+#include "tracer.h"
+
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include <utility>
+
+SystemSettingsCommitter::SystemSettingsCommitter(const QDBusConnection &connection, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+{
+}
+
+SystemSettingsCommitter::~SystemSettingsCommitter()
+{
+    // Nobody is left to handle the replies, but the settings should still be written
+    for (const Write &write : std::as_const(m_pending)) {
+        m_connection.send(write.message);
+    }
+}
+
+void SystemSettingsCommitter::setCurrentValue(const QString &key, const QVariant &value)
+{
+    m_values.insert(key, value);
+}
+
+QVariant SystemSettingsCommitter::value(const QString &key) const
+{
+    if (const auto it = m_pending.constFind(key); it != m_pending.cend()) {
+        return it->value;
+    }
+    return m_values.value(key);
+}
+
+void SystemSettingsCommitter::stage(const QString &key, const QVariant &value, const QDBusMessage &message)
+{
+    if (const auto it = m_values.constFind(key); it != m_values.cend() && *it == value) {
+        // Going back to the value the system already has cancels the pending write
+        if (m_pending.remove(key)) {
+            qCDebug(PlasmaSetupShared) << "Dropping the pending write of" << key << "as it already has the value" << value;
+        }
+        return;
+    }
+
+    m_pending.insert(key, {value, message});
+}
+
+bool SystemSettingsCommitter::hasPendingWrites() const
+{
+    return !m_pending.isEmpty();
+}
+
+void SystemSettingsCommitter::commit()
+{
+    const QHash<QString, Write> pending = std::exchange(m_pending, {});
+    if (pending.isEmpty() && m_runningCalls == 0) {
+        Q_EMIT allCommitted({});
+        return;
+    }
+    m_runningCalls += pending.size();
+
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        const QString key = it.key();
+        const QVariant value = it->value;
+        qCDebug(PlasmaSetupShared) << "Writing" << key << "with the value" << value;
+
+        // Considered written right away, so staging the same value while the call is running is a no-op
+        m_values.insert(key, value);
+
+        const QString traceName = it->message.member() + QLatin1Char(' ') + it->message.service();
+        const qint64 traceStart = Tracer::timestamp();
+
+        auto watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(it->message), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, key, value, traceName, traceStart](QDBusPendingCallWatcher *watcher) {
+            watcher->deleteLater();
+            Tracer::addSpan(traceName, QStringLiteral("dbus"), traceStart);
+
+            const QDBusPendingReply<> reply = *watcher;
+            if (reply.isError()) {
+                qCWarning(PlasmaSetupShared) << "Failed to write" << key << ':' << reply.error().message();
+                // The system kept its previous value, allow writing this one again
+                if (m_values.value(key) == value) {
+                    m_values.remove(key);
+                }
+                m_commitErrors << reply.error().message();
+                Q_EMIT committed(key, reply.error().message());
+            } else {
+                Q_EMIT committed(key, QString());
+            }
+
+            if (--m_runningCalls == 0) {
+                Q_EMIT allCommitted(std::exchange(m_commitErrors, {}));
+            }
+        });
+    }
+}
+
+#include "moc_systemsettingscommitter.cpp"
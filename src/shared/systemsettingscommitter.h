@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QVariant>
+
+/**
+ * Collects the system settings chosen by the user and writes them over D-Bus in one go.
+ *
+ * Every setting is identified by a key and holds the value it should end up with, along
+ * with the D-Bus call writing it. Staging a setting again replaces the previous call, so
+ * only the last choice reaches the bus, and settings already having the wanted value
+ * are not written at all.
+ *
+ * commit() sends all pending calls at once without waiting for their replies. It is
+ * meant to be called when the user leaves the page the settings belong to.
+ */
+class SystemSettingsCommitter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SystemSettingsCommitter(const QDBusConnection &connection, QObject *parent = nullptr);
+
+    /**
+     * Sends the calls still pending without waiting for them.
+     */
+    ~SystemSettingsCommitter() override;
+
+    /**
+     * Records the value a setting currently has on the system.
+     *
+     * Staging this value afterwards is a no-op.
+     */
+    void setCurrentValue(const QString &key, const QVariant &value);
+
+    /**
+     * The value the setting is known to have on the system, or will have once pending calls are sent.
+     */
+    QVariant value(const QString &key) const;
+
+    /**
+     * Stages the call writing a setting, replacing any call staged earlier for it.
+     *
+     * @param key The setting to write.
+     * @param value The value the call sets, compared against the current one.
+     * @param message The D-Bus call writing the value.
+     */
+    void stage(const QString &key, const QVariant &value, const QDBusMessage &message);
+
+    /**
+     * Whether some staged calls have not been sent yet.
+     */
+    bool hasPendingWrites() const;
+
+    /**
+     * Sends all pending calls in parallel.
+     */
+    void commit();
+
+Q_SIGNALS:
+    /**
+     * Emitted once a committed call got its reply.
+     *
+     * @param key The setting written.
+     * @param errorMessage The error, or an empty string if the call succeeded.
+     */
+    void committed(const QString &key, const QString &errorMessage);
+
+    /**
+     * Emitted once every call sent by commit() got its reply, right away if there was nothing to send.
+     *
+     * @param errorMessages The errors of the calls that failed, empty if all succeeded.
+     */
+    void allCommitted(const QStringList &errorMessages);
+
+private:
+    struct Write {
+        QVariant value;
+        QDBusMessage message;
+    };
+
+    QDBusConnection m_connection;
+
+    /** The calls staged but not sent yet. */
+    QHash<QString, Write> m_pending;
+
+    /** The values last sent, or known to be set, per setting. */
+    QHash<QString, QVariant> m_values;
+
+    /** The number of calls sent that did not get their reply yet. */
+    int m_runningCalls = 0;
+
+    /** The errors of the calls that failed since allCommitted() was last emitted. */
+    QStringList m_commitErrors;
+};
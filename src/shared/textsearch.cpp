@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "textsearch.h"
+
+namespace TextSearch
+{
+QString fold(QStringView text)
+{
+    // Decompose so diacritics become separate combining marks, then drop them
+    const QString decomposed = text.toString().normalized(QString::NormalizationForm_KD);
+
+    QString folded;
+    folded.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.category() != QChar::Mark_NonSpacing) {
+            folded.append(c);
+        }
+    }
+
+    return folded.toCaseFolded();
+}
+
+bool isWordStart(QStringView text, qsizetype position)
+{
+    return position == 0 || !text.at(position - 1).isLetterOrNumber();
+}
+
+Match match(QStringView foldedText, QStringView foldedQuery, bool matchWords)
+{
+    qsizetype position = foldedText.indexOf(foldedQuery);
+    if (position < 0) {
+        return NoMatch;
+    }
+
+    if (position == 0) {
+        return foldedText.size() == foldedQuery.size() ? ExactMatch : PrefixMatch;
+    }
+
+    if (matchWords) {
+        // Look for a later occurrence at the start of a word
+        while (position >= 0 && !isWordStart(foldedText, position)) {
+            position = foldedText.indexOf(foldedQuery, position + 1);
+        }
+        if (position >= 0) {
+            return WordPrefixMatch;
+        }
+    }
+
+    return SubstringMatch;
+}
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * Matching of search strings typed into the lists of Plasma Setup, e.g. those of the languages
+ * and keyboard layouts.
+ *
+ * Both the text and the query are folded first, so matching is case and diacritic insensitive.
+ */
+namespace TextSearch
+{
+/**
+ * Where a query was found in a text, lower is better.
+ */
+enum Match {
+    /** The query is the whole text. */
+    ExactMatch,
+    /** The text starts with the query. */
+    PrefixMatch,
+    /** A later word of the text starts with the query. */
+    WordPrefixMatch,
+    /** The query appears anywhere else. */
+    SubstringMatch,
+    /** The query does not match. */
+    NoMatch,
+};
+
+/**
+ * Folds the given text for matching, removing case and diacritic differences.
+ */
+QString fold(QStringView text);
+
+/**
+ * Returns whether the given position of a text starts a word.
+ */
+bool isWordStart(QStringView text, qsizetype position);
+
+/**
+ * Returns where the query was found in the text.
+ *
+ * @param foldedText A text folded with fold().
+ * @param foldedQuery A query folded with fold().
+ * @param matchWords Whether to look for a later word starting with the query, otherwise such a
+ *        match is a SubstringMatch, e.g. for codes.
+ */
+Match match(QStringView foldedText, QStringView foldedQuery, bool matchWords = true);
+}
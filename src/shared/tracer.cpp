@@ -0,0 +1,163 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "tracer.h"
+
+#include "plasmasetup_shared_debug.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+
+#include <chrono>
+
+namespace
+{
+/**
+ * Where the spans go, set up from the environment on first use.
+ */
+class TraceOutput
+{
+public:
+    enum Kind {
+        Disabled,
+        Journal,
+        File,
+    };
+
+    TraceOutput()
+    {
+        const QString target = qEnvironmentVariable(Tracer::ENVIRONMENT_VARIABLE);
+        if (target.isEmpty()) {
+            return;
+        }
+
+        if (target == QLatin1String("journal")) {
+            m_kind = Journal;
+            return;
+        }
+
+        m_file.setFileName(target);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qCWarning(PlasmaSetupShared) << "Failed to open the trace file" << target << ':' << m_file.errorString();
+            return;
+        }
+
+        // The closing bracket is optional in the JSON array format, so every copy can simply append
+        if (m_file.size() == 0) {
+            m_file.write("[\n");
+            m_file.flush();
+        }
+        m_kind = File;
+    }
+
+    Kind kind() const
+    {
+        return m_kind;
+    }
+
+    void write(const QString &name, const QString &category, char phase, qint64 start, qint64 duration)
+    {
+        if (m_kind == Journal) {
+            if (phase == 'X') {
+                qCInfo(PlasmaSetupShared).nospace() << "Trace: " << category << ' ' << name << " took " << duration / 1000.0 << " ms";
+            } else {
+                qCInfo(PlasmaSetupShared).nospace() << "Trace: " << category << ' ' << name << " at " << start / 1000 << " ms";
+            }
+            return;
+        }
+
+        QJsonObject event{
+            {QStringLiteral("name"), name},
+            {QStringLiteral("cat"), category},
+            {QStringLiteral("ph"), QString(QLatin1Char(phase))},
+            {QStringLiteral("ts"), start},
+            {QStringLiteral("pid"), QCoreApplication::applicationPid()},
+            {QStringLiteral("tid"), static_cast<qint64>(reinterpret_cast<quintptr>(QThread::currentThreadId()))},
+        };
+        if (phase == 'X') {
+            event.insert(QStringLiteral("dur"), duration);
+        } else {
+            event.insert(QStringLiteral("s"), QStringLiteral("p"));
+        }
+
+        const QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact) + ",\n";
+
+        // Flushed right away, so the trace survives the wizard being killed at the end of the setup
+        QMutexLocker locker(&m_mutex);
+        m_file.write(line);
+        m_file.flush();
+    }
+
+private:
+    Kind m_kind = Disabled;
+    QFile m_file;
+    QMutex m_mutex;
+};
+
+TraceOutput &output()
+{
+    static TraceOutput instance;
+    return instance;
+}
+}
+
+namespace Tracer
+{
+bool isEnabled()
+{
+    return output().kind() != TraceOutput::Disabled;
+}
+
+qint64 timestamp()
+{
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+void addSpan(const QString &name, const QString &category, qint64 start)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    output().write(name, category, 'X', start, timestamp() - start);
+}
+
+void addInstant(const QString &name, const QString &category)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    output().write(name, category, 'i', timestamp(), 0);
+}
+
+Span::Span(const QString &name, const QString &category)
+{
+    if (isEnabled()) {
+        m_name = name;
+        m_category = category;
+        m_start = timestamp();
+    }
+}
+
+Span::~Span()
+{
+    end();
+}
+
+void Span::end()
+{
+    if (m_start < 0) {
+        return;
+    }
+
+    addSpan(m_name, m_category, m_start);
+    m_start = -1;
+}
+}
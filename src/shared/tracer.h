@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QString>
+
+/**
+ * Records how long the steps of the wizard take.
+ *
+ * Tracing is enabled by setting the PLASMA_SETUP_TRACE environment variable, or with the
+ * --trace command line option which sets it:
+ * - to a file path, spans are appended to that file in the Chrome trace event format,
+ *   which can be opened in Perfetto or chrome://tracing;
+ * - to "journal", spans are logged through the org.kde.plasmasetup.shared category.
+ *
+ * This code is linked statically into the application and every module, so each copy writes
+ * to the file on its own. Events are appended one line at a time with timestamps from the
+ * monotonic clock, which keeps them consistent across copies.
+ *
+ * When tracing is disabled, recording a span only costs checking a cached boolean.
+ */
+namespace Tracer
+{
+/**
+ * The environment variable enabling tracing.
+ */
+inline constexpr const char *ENVIRONMENT_VARIABLE = "PLASMA_SETUP_TRACE";
+
+/**
+ * Whether spans are recorded.
+ */
+bool isEnabled();
+
+/**
+ * The current time of the monotonic clock, in microseconds.
+ */
+qint64 timestamp();
+
+/**
+ * Records a span that started at the given time and ends now.
+ *
+ * Meant for asynchronous work, e.g. from the reply of a D-Bus call.
+ *
+ * @param name What was done, e.g. "GetAll org.freedesktop.locale1".
+ * @param category The kind of work, e.g. "dbus", used to group spans.
+ * @param start When the work started, from timestamp().
+ */
+void addSpan(const QString &name, const QString &category, qint64 start);
+
+/**
+ * Records a point in time, e.g. the first frame being shown.
+ */
+void addInstant(const QString &name, const QString &category);
+
+/**
+ * Records a span from its construction until it is destroyed or end() is called.
+ */
+class Span
+{
+public:
+    Span(const QString &name, const QString &category);
+    ~Span();
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+    /**
+     * Ends the span before it goes out of scope.
+     */
+    void end();
+
+private:
+    QString m_name;
+    QString m_category;
+    qint64 m_start = -1;
+};
+}
@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: 2026 Kristen McWilliam <kristen@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+/**
+ * Building blocks for validating the names entered in the wizard, e.g. the username and the hostname.
+ *
+ * The fields are validated on every keystroke, so the validators scan the text once, look
+ * characters up in a table instead of matching regular expressions, and do not allocate.
+ */
+namespace PlasmaSetupValidation
+{
+/**
+ * The classes of ASCII characters the validators distinguish, combined as flags.
+ */
+namespace CharacterClass
+{
+enum : std::uint8_t {
+    Letter = 1 << 0,
+    Digit = 1 << 1,
+    Underscore = 1 << 2,
+    Period = 1 << 3,
+    Hyphen = 1 << 4,
+};
+}
+
+/**
+ * The classes of each ASCII character, characters beyond ASCII have none.
+ */
+inline constexpr std::array<std::uint8_t, 128> CHARACTER_CLASSES = [] {
+    std::array<std::uint8_t, 128> classes{};
+    for (char c = 'a'; c <= 'z'; ++c) {
+        classes[c] = CharacterClass::Letter;
+        classes[c - 'a' + 'A'] = CharacterClass::Letter;
+    }
+    for (char c = '0'; c <= '9'; ++c) {
+        classes[c] = CharacterClass::Digit;
+    }
+    classes['_'] = CharacterClass::Underscore;
+    classes['.'] = CharacterClass::Period;
+    classes['-'] = CharacterClass::Hyphen;
+    return classes;
+}();
+
+/**
+ * Returns the classes of the given character.
+ */
+constexpr std::uint8_t characterClass(QChar c)
+{
+    return c.unicode() < CHARACTER_CLASSES.size() ? CHARACTER_CLASSES[c.unicode()] : 0;
+}
+
+/**
+ * Whether the given character belongs to any of the given classes.
+ */
+constexpr bool hasCharacterClass(QChar c, std::uint8_t classes)
+{
+    return (characterClass(c) & classes) != 0;
+}
+
+/**
+ * Remembers the validation of the last text, along with its message.
+ *
+ * QML asks for the validity and the message of the same text separately, this answers
+ * both from a single validation. The text is kept as an implicitly shared copy, so
+ * remembering it does not allocate either.
+ *
+ * @tparam Result The result of the validation, whose default value must mean valid.
+ */
+template<typename Result>
+class ValidationCache
+{
+public:
+    using Validator = std::function<Result(QStringView text)>;
+    using Describer = QString (*)(Result result);
+
+    ValidationCache(Validator validator, Describer describer)
+        : m_validator(std::move(validator))
+        , m_describer(describer)
+    {
+    }
+
+    /**
+     * Returns the result of the validation of the given text.
+     */
+    Result result(const QString &text) const
+    {
+        update(text);
+        return m_result;
+    }
+
+    /**
+     * Returns the message for the validation of the given text, empty if it is valid.
+     */
+    QString message(const QString &text) const
+    {
+        update(text);
+        if (!m_hasMessage) {
+            m_message = m_describer(m_result);
+            m_hasMessage = true;
+        }
+        return m_message;
+    }
+
+    /**
+     * Forgets the last validation, e.g. because what the validator checks against changed.
+     */
+    void clear()
+    {
+        m_hasResult = false;
+    }
+
+private:
+    void update(const QString &text) const
+    {
+        if (m_hasResult && text == m_text) {
+            return;
+        }
+
+        m_text = text;
+        m_result = m_validator(text);
+        m_hasResult = true;
+        m_hasMessage = false;
+    }
+
+    Validator m_validator;
+    Describer m_describer;
+
+    mutable QString m_text;
+    mutable Result m_result{};
+    mutable QString m_message;
+    mutable bool m_hasResult = false;
+    mutable bool m_hasMessage = false;
+};
+} // namespace PlasmaSetupValidation
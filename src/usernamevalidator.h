@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include "validation.h"
+
 #include <KLocalizedString>
 
 #include <QMetaType>
-#include <QRegularExpression>
 #include <QString>
+#include <QStringView>
 
 /**
  * Shared username validation logic for Plasma Setup.
@@ -28,6 +30,8 @@ enum class UsernameValidationResult {
     Empty,
     TooLong,
     InvalidCharacters,
+    /** Only reported by AccountController, which knows the existing users and groups. */
+    AlreadyTaken,
 };
 
 Q_ENUM_NS(UsernameValidationResult)
@@ -40,12 +44,15 @@ constexpr int MAX_USERNAME_LENGTH = 32;
 /**
  * Validate the provided username.
  *
+ * Usernames must start with a letter (A-Z, a-z) or underscore (_), followed by letters,
+ * digits (0-9), periods (.), underscores (_), or hyphens (-).
+ *
  * @param username The username to validate.
  * @return The result of the validation.
  */
-inline UsernameValidationResult validateUsername(const QString &username)
+inline UsernameValidationResult validateUsername(QStringView username)
 {
-    const QString trimmed = username.trimmed();
+    const QStringView trimmed = username.trimmed();
 
     if (trimmed.isEmpty()) {
         return UsernameValidationResult::Empty;
@@ -55,17 +62,15 @@ inline UsernameValidationResult validateUsername(const QString &username)
         return UsernameValidationResult::TooLong;
     }
 
-    /**
-     * Regular expression pattern for valid usernames.
-     *
-     * Usernames must start with a letter (A-Z, a-z) or underscore (_),
-     * followed by letters, digits (0-9), periods (.), underscores (_), or hyphens (-).
-     */
-    static const QRegularExpression usernamePattern(QStringLiteral("^[A-Za-z_][A-Za-z0-9_.-]*$"));
-
-    if (!usernamePattern.match(trimmed).hasMatch()) {
+    using namespace PlasmaSetupValidation::CharacterClass;
+    if (!hasCharacterClass(trimmed.front(), Letter | Underscore)) {
         return UsernameValidationResult::InvalidCharacters;
     }
+    for (const QChar c : trimmed.sliced(1)) {
+        if (!hasCharacterClass(c, Letter | Digit | Underscore | Period | Hyphen)) {
+            return UsernameValidationResult::InvalidCharacters;
+        }
+    }
 
     return UsernameValidationResult::Valid;
 }
@@ -73,7 +78,7 @@ inline UsernameValidationResult validateUsername(const QString &username)
 /**
  * Convenience helper that answers whether the username is valid.
  */
-inline bool isUsernameValid(const QString &username)
+inline bool isUsernameValid(QStringView username)
 {
     return validateUsername(username) == UsernameValidationResult::Valid;
 }
@@ -93,6 +98,8 @@ inline QString usernameValidationMessage(UsernameValidationResult result)
         return i18nc("@info", "Username is too long (maximum 32 characters).");
     case UsernameValidationResult::InvalidCharacters:
         return i18nc("@info", "Usernames must start with a letter or underscore.\n\nThey may contain only letters, numbers, periods, underscores, or hyphens.");
+    case UsernameValidationResult::AlreadyTaken:
+        return i18nc("@info", "This name is already used by an existing user or group.");
     }
 
     return QString();